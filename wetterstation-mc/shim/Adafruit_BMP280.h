@@ -0,0 +1,30 @@
+#ifndef __NATIVE_BMP280_H_INC__
+#define __NATIVE_BMP280_H_INC__
+
+#include <Wire.h>
+#include "environment.h"
+
+// Busdauer wie die Bibliothek: Register schreiben und lesen, der Luftdruck
+// liest zuvor die Temperatur für die Kompensation
+class Adafruit_BMP280
+{
+public:
+    bool begin(uint8_t address = 0x77) { return true; }
+    float readTemperature()
+    {
+        Wire.transferTime(6);
+        return nativeEnvironment.getTemperature();
+    }
+    float readPressure()
+    {
+        Wire.transferTime(12);
+        return nativeEnvironment.getPressure();
+    }
+    float readAltitude(float seaLevelhPa = 1013.25)
+    {
+        Wire.transferTime(12);
+        return 44330 * (1.0f - powf(nativeEnvironment.getPressure() / 100 / seaLevelhPa, 0.1903f));
+    }
+};
+
+#endif
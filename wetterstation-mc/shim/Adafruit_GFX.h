@@ -0,0 +1,102 @@
+#ifndef __NATIVE_GFX_H_INC__
+#define __NATIVE_GFX_H_INC__
+
+#include <Arduino.h>
+
+#define BLACK 0
+#define WHITE 1
+
+/**
+ *
+ * Grafikfunktionen wie Adafruit_GFX. Zeichen werden als 6x8 Muster aus
+ * dem Zeichencode gezeichnet, der genaue Font spielt für die Tests keine Rolle.
+ *
+ **/
+class Adafruit_GFX : public Print
+{
+protected:
+    int16_t _width, _height;
+    int16_t cursorX = 0, cursorY = 0;
+    uint8_t textSize = 1;
+    uint16_t textColor = WHITE, textBackground = WHITE;
+
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : _width(w), _height(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    void setCursor(int16_t x, int16_t y)
+    {
+        cursorX = x;
+        cursorY = y;
+    }
+    void setTextSize(uint8_t size) { textSize = size; }
+    void setTextColor(uint16_t color) { textColor = textBackground = color; }
+    void setTextColor(uint16_t color, uint16_t background)
+    {
+        textColor = color;
+        textBackground = background;
+    }
+    void setTextWrap(bool wrap) {}
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        for (int16_t j = y; j < y + h; j++)
+        {
+            for (int16_t i = x; i < x + w; i++)
+            {
+                drawPixel(i, j, color);
+            }
+        }
+    }
+
+    void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color)
+    {
+        int16_t byteWidth = (w + 7) / 8;
+        for (int16_t j = 0; j < h; j++)
+        {
+            for (int16_t i = 0; i < w; i++)
+            {
+                if (bitmap[j * byteWidth + i / 8] & (0x80 >> (i & 7)))
+                {
+                    drawPixel(x + i, y + j, color);
+                }
+            }
+        }
+    }
+
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t background, uint8_t size)
+    {
+        for (int16_t i = 0; i < 6 * size; i++)
+        {
+            for (int16_t j = 0; j < 8 * size; j++)
+            {
+                bool set = i / size < 5 && j / size < 7 && ((c >> ((i / size + j / size) & 7)) & 1);
+                drawPixel(x + i, y + j, set ? color : background);
+            }
+        }
+    }
+
+    size_t write(uint8_t c)
+    {
+        if (c == '\n')
+        {
+            cursorX = 0;
+            cursorY += 8 * textSize;
+        }
+        else if (c != '\r')
+        {
+            drawChar(cursorX, cursorY, c, textColor, textBackground, textSize);
+            cursorX += 6 * textSize;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+    int16_t getCursorX() const { return cursorX; }
+    int16_t getCursorY() const { return cursorY; }
+};
+
+#endif
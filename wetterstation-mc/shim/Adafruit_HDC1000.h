@@ -0,0 +1,28 @@
+#ifndef __NATIVE_HDC1000_H_INC__
+#define __NATIVE_HDC1000_H_INC__
+
+#include <Wire.h>
+#include "environment.h"
+
+// Wie die Bibliothek: Messung starten, 20 ms warten und lesen
+class Adafruit_HDC1000
+{
+public:
+    bool begin(uint8_t address = 0x40) { return true; }
+    float readTemperature()
+    {
+        Wire.transferTime(2);
+        delay(20);
+        Wire.transferTime(5);
+        return nativeEnvironment.getTemperature();
+    }
+    float readHumidity()
+    {
+        Wire.transferTime(2);
+        delay(20);
+        Wire.transferTime(5);
+        return nativeEnvironment.getHumidity();
+    }
+};
+
+#endif
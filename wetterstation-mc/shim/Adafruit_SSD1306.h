@@ -0,0 +1,72 @@
+#ifndef __NATIVE_SSD1306_H_INC__
+#define __NATIVE_SSD1306_H_INC__
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+
+/**
+ *
+ * SSD1306 mit Bildspeicher im RAM. 'display' überträgt wie die Bibliothek
+ * den ganzen Bildspeicher über 'Wire', so zählt 'Wire.bytesWritten' alle
+ * Übertragungen zum Display.
+ *
+ **/
+class Adafruit_SSD1306 : public Adafruit_GFX
+{
+private:
+    uint8_t buffer[128 * 64 / 8];
+
+public:
+    Adafruit_SSD1306(int8_t reset = -1) : Adafruit_GFX(128, 64) {}
+
+    bool begin(uint8_t vcc = SSD1306_SWITCHCAPVCC, uint8_t address = 0x3C, bool reset = true, bool periphBegin = true)
+    {
+        clearDisplay();
+        return true;
+    }
+
+    void clearDisplay() { memset(buffer, 0, sizeof(buffer)); }
+
+    void display()
+    {
+        // Kommandos für das Adressfenster und der Bildspeicher in 32 Byte Blöcken
+        Wire.beginTransmission(0x3D);
+        Wire.write((const uint8_t *)"\x00\x22\x00\xff\x21\x00\x7f", 7);
+        Wire.endTransmission();
+        for (size_t i = 0; i < sizeof(buffer); i += 31)
+        {
+            size_t count = sizeof(buffer) - i < 31 ? sizeof(buffer) - i : 31;
+            Wire.beginTransmission(0x3D);
+            Wire.write((uint8_t)0x40);
+            Wire.write(buffer + i, count);
+            Wire.endTransmission();
+        }
+    }
+
+    void ssd1306_command(uint8_t command) {}
+
+    uint8_t *getBuffer() { return buffer; }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+        if (x < 0 || y < 0 || x >= _width || y >= _height)
+        {
+            return;
+        }
+        uint8_t bit = 1 << (y & 7);
+        if (color)
+        {
+            buffer[x + (y / 8) * _width] |= bit;
+        }
+        else
+        {
+            buffer[x + (y / 8) * _width] &= ~bit;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef __NATIVE_ARDUINO_H_INC__
+#define __NATIVE_ARDUINO_H_INC__
+
+/*
+    Nachbildung des Arduino Kerns für die Umgebung 'native' (siehe platformio.ini).
+    Es wird nur das abgebildet, was die Wetterstation tatsächlich benutzt.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <deque>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t uint16;
+
+#define PROGMEM
+#define F(s) (s)
+
+#define HEX 16
+#define DEC 10
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LOW 0
+#define HIGH 1
+#define FALLING 2
+#define RISING 3
+#define CHANGE 4
+#define digitalPinToInterrupt(p) (p)
+
+/*
+    Virtuelle Uhr in Mikrosekunden, sie läuft nur durch 'delay' und
+    'nativeAdvance' weiter. So vergeht ein simulierter Tag in Sekunden.
+*/
+
+extern unsigned long long nativeMicros;
+
+inline void nativeAdvance(unsigned long long us) { nativeMicros += us; }
+inline unsigned long millis() { return nativeMicros / 1000; }
+inline unsigned long micros() { return nativeMicros; }
+inline void delay(unsigned long ms) { nativeAdvance(ms * 1000ULL); }
+inline void delayMicroseconds(unsigned int us) { nativeAdvance(us); }
+
+inline void pinMode(int pin, int mode) {}
+inline int digitalRead(int pin) { return HIGH; }
+inline void digitalWrite(int pin, int value) {}
+
+/*
+    Interrupts werden nur gespeichert, 'nativeInterrupt' löst sie aus
+    (z.B. Szenario 'button').
+*/
+
+typedef void (*NativeInterruptHandler)();
+
+inline NativeInterruptHandler &nativeInterruptHandler(int pin)
+{
+    static NativeInterruptHandler handlers[64];
+    return handlers[pin & 63];
+}
+
+inline void attachInterrupt(int pin, void (*isr)(), int mode) { nativeInterruptHandler(pin) = isr; }
+inline void detachInterrupt(int pin) { nativeInterruptHandler(pin) = NULL; }
+
+inline bool nativeInterrupt(int pin)
+{
+    if (nativeInterruptHandler(pin) == NULL)
+    {
+        return false;
+    }
+    nativeInterruptHandler(pin)();
+    return true;
+}
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline long random(long min, long max) { return min + rand() % (max - min); }
+inline long random(long max) { return rand() % max; }
+inline void randomSeed(unsigned long seed) { srand(seed); }
+
+class String : public std::string
+{
+public:
+    String(const char *s = "") : std::string(s) {}
+    String(const std::string &s) : std::string(s) {}
+    char charAt(unsigned int i) const { return i < size() ? (*this)[i] : 0; }
+    String substring(unsigned int from, unsigned int to) const { return String(substr(from, to - from)); }
+    long toInt() const { return atol(c_str()); }
+    double toDouble() const { return atof(c_str()); }
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (n < size && write(buffer[n]))
+        {
+            n++;
+        }
+        return n;
+    }
+    size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+    size_t print(const char *str) { return write(str); }
+    size_t print(const String &str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(double value, int digits = 2) { return printFormatted("%.*f", digits, value); }
+    size_t print(long value, int base = DEC) { return printFormatted(base == HEX ? "%lx" : "%ld", value); }
+    size_t print(unsigned long value, int base = DEC) { return printFormatted(base == HEX ? "%lx" : "%lu", value); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t println() { return write("\r\n"); }
+
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+
+    template <typename T>
+    size_t println(T value, int format) { return print(value, format) + println(); }
+
+private:
+    template <typename T>
+    size_t printFormatted(const char *format, T value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), format, value);
+        return write(buffer);
+    }
+
+    size_t printFormatted(const char *format, int digits, double value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), format, digits, value);
+        return write(buffer);
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    virtual void flush() {}
+
+    String readString()
+    {
+        std::string str;
+        int c;
+        while ((c = read()) >= 0)
+        {
+            str += (char)c;
+        }
+        return String(str);
+    }
+};
+
+class HardwareSerial;
+
+/**
+ *
+ * Gerät an einer seriellen Schnittstelle, z.B. der SDS011 an Serial1.
+ * Empfängt die gesendeten Bytes und antwortet über 'HardwareSerial::inject'.
+ *
+ **/
+class SerialDevice
+{
+public:
+    virtual ~SerialDevice() {}
+    virtual void receive(HardwareSerial &port, uint8_t c) = 0;
+};
+
+/**
+ *
+ * Serielle Schnittstelle. Ohne Gerät wird die Ausgabe auf stdout
+ * geschrieben, sofern 'echo' gesetzt ist.
+ *
+ **/
+class HardwareSerial : public Stream
+{
+private:
+    std::deque<uint8_t> rx;
+
+public:
+    SerialDevice *device = NULL;
+    bool echo = false;
+
+    void begin(unsigned long baud) {}
+
+    size_t write(uint8_t c)
+    {
+        if (device != NULL)
+        {
+            device->receive(*this, c);
+        }
+        else if (echo)
+        {
+            putchar(c);
+        }
+        return 1;
+    }
+    using Print::write;
+
+    void inject(const uint8_t *data, size_t length) { rx.insert(rx.end(), data, data + length); }
+
+    int available() { return rx.size(); }
+    int read()
+    {
+        if (rx.empty())
+        {
+            return -1;
+        }
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    int peek() { return rx.empty() ? -1 : rx.front(); }
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+class IPAddress
+{
+public:
+    uint8_t bytes[4];
+
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0)
+    {
+        bytes[0] = a;
+        bytes[1] = b;
+        bytes[2] = c;
+        bytes[3] = d;
+    }
+
+    uint8_t operator[](int i) const { return bytes[i]; }
+};
+
+class Client : public Stream
+{
+public:
+    virtual int connect(IPAddress ip, uint16_t port) = 0;
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void stop() = 0;
+    virtual int read(uint8_t *buffer, size_t size) = 0;
+    using Stream::read;
+    using Print::write;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __NATIVE_TSL45315_H_INC__
+#define __NATIVE_TSL45315_H_INC__
+
+#include <Wire.h>
+#include "environment.h"
+
+#define TSL45315_TIME_M1 0
+#define TSL45315_TIME_M2 1
+#define TSL45315_TIME_M4 2
+
+class Makerblog_TSL45315
+{
+public:
+    Makerblog_TSL45315(uint8_t timing) {}
+    bool begin() { return true; }
+    uint32_t readLux()
+    {
+        Wire.transferTime(5);
+        return nativeEnvironment.getLux();
+    }
+};
+
+#endif
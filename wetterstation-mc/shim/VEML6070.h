@@ -0,0 +1,18 @@
+#ifndef __NATIVE_VEML6070_H_INC__
+#define __NATIVE_VEML6070_H_INC__
+
+#include <Wire.h>
+#include "environment.h"
+
+class VEML6070
+{
+public:
+    void begin() {}
+    uint16_t getUV()
+    {
+        Wire.transferTime(4);
+        return nativeEnvironment.getUv();
+    }
+};
+
+#endif
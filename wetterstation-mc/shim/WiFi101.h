@@ -0,0 +1,329 @@
+#ifndef __NATIVE_WIFI101_H_INC__
+#define __NATIVE_WIFI101_H_INC__
+
+#include <Arduino.h>
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#define WL_NO_SHIELD 255
+#define WL_IDLE_STATUS 0
+#define WL_NO_SSID_AVAIL 1
+#define WL_SCAN_COMPLETED 2
+#define WL_CONNECTED 3
+#define WL_CONNECT_FAILED 4
+#define WL_CONNECTION_LOST 5
+#define WL_DISCONNECTED 6
+
+// Unix Zeit beim Start der virtuellen Uhr
+#define NATIVE_EPOCH_START 1618473600UL
+
+// Dauer einer Verbindung mit Suche über alle Kanäle bzw. mit dem
+// gespeicherten Profil des WINC1500 (Kanal und BSSID bekannt)
+#define NATIVE_JOIN_TIME 2500
+#define NATIVE_FAST_JOIN_TIME 400
+
+/**
+ *
+ * UDP Paket im simulierten Netzwerk, siehe WiFiUdp.h.
+ *
+ **/
+struct NativeDatagram
+{
+    uint16_t port;
+    std::string data;
+};
+
+/**
+ *
+ * Zustand des simulierten Netzwerks und Statistiken aller Clients.
+ * 'windradBody' ist die Antwort des Windrads auf ein GET. 'posts' und
+ * 'postedLines' zählen die POST Requests und die Zeilen (Messungen) ihrer Bodys.
+ *
+ **/
+struct NativeNetwork
+{
+    bool online = true;
+    // Das WiFi Modul hat ein Profil der letzten Verbindung gespeichert
+    bool profile = false;
+    // Signalstärke, Dauer einer Verbindung mit Suche und Anzahl der
+    // folgenden Versuche welche der Access Point ablehnt (Szenario)
+    int32_t rssi = -60;
+    unsigned long joinTime = NATIVE_JOIN_TIME;
+    unsigned long rejectJoins = 0;
+    // Statuscode der Antworten auf POST Requests, 0 = keine Antwort (Szenario)
+    uint16_t postStatus = 201;
+    // Verzögerung der Antworten in ms, z.B. ein langsamer Server
+    unsigned long responseDelay = 0;
+    // Wird mit dem Body jedes POST Requests aufgerufen, z.B. für Tests
+    void (*onPost)(const std::string &body) = NULL;
+    const char *windradBody = "3,270,9.5,15.1\n";
+
+    unsigned long associations = 0;
+    unsigned long connects = 0;
+    unsigned long requests = 0;
+    unsigned long bytesSent = 0;
+    unsigned long bytesReceived = 0;
+    unsigned long posts = 0;
+    unsigned long postedLines = 0;
+
+    // Gesendete, noch nicht gelesene UDP Pakete aller Ports
+    std::deque<NativeDatagram> datagrams;
+    unsigned long datagramsSent = 0;
+    unsigned long datagramBytes = 0;
+};
+
+extern NativeNetwork nativeNetwork;
+
+class WiFiClass
+{
+private:
+    uint8_t state = WL_IDLE_STATUS;
+    unsigned long timeout = 60000;
+    // Ende des laufenden Verbindungsversuchs, 0 ohne Versuch
+    unsigned long millisJoined = 0;
+
+    // Der laufende Versuch wird vom Access Point abgelehnt
+    bool rejected = false;
+
+    /**
+     *
+     * Verbindet nach 'duration' ms. Wie in der WiFi101 Bibliothek wartet
+     * 'begin' bis zur Verbindung, mit 'setTimeout(0)' kehrt es sofort
+     * zurück und 'status' meldet die Verbindung später.
+     *
+     **/
+    uint8_t join(unsigned long duration)
+    {
+        nativeNetwork.associations++;
+        millisJoined = 0;
+        if (!nativeNetwork.online)
+        {
+            state = WL_CONNECT_FAILED;
+            return state;
+        }
+        rejected = nativeNetwork.rejectJoins > 0;
+        if (rejected)
+        {
+            nativeNetwork.rejectJoins--;
+        }
+        state = WL_IDLE_STATUS;
+        millisJoined = millis() + duration;
+        if (timeout > 0)
+        {
+            delay(duration);
+        }
+        return status();
+    }
+
+public:
+    uint8_t begin()
+    {
+        if (!nativeNetwork.profile)
+        {
+            state = WL_CONNECT_FAILED;
+            return state;
+        }
+        return join(NATIVE_FAST_JOIN_TIME);
+    }
+    uint8_t begin(const char *ssid, const char *key) { return join(nativeNetwork.joinTime); }
+
+    /**
+     *
+     * Ohne Netzwerk geht die Verbindung verloren und bleibt getrennt
+     * bis zum nächsten 'begin'.
+     *
+     **/
+    uint8_t status()
+    {
+        if (!nativeNetwork.online)
+        {
+            if (state != WL_IDLE_STATUS || millisJoined != 0)
+            {
+                state = WL_DISCONNECTED;
+                millisJoined = 0;
+            }
+            return state;
+        }
+        if (millisJoined != 0 && (long)(millis() - millisJoined) >= 0)
+        {
+            millisJoined = 0;
+            state = rejected ? WL_DISCONNECTED : WL_CONNECTED;
+            nativeNetwork.profile = nativeNetwork.profile || !rejected;
+        }
+        return state;
+    }
+    void disconnect()
+    {
+        state = WL_DISCONNECTED;
+        millisJoined = 0;
+    }
+    void end()
+    {
+        state = WL_IDLE_STATUS;
+        millisJoined = 0;
+    }
+    int32_t RSSI() { return state == WL_CONNECTED ? nativeNetwork.rssi : 0; }
+    uint8_t *macAddress(uint8_t *mac)
+    {
+        const uint8_t simulated[6] = {0xf8, 0xf0, 0x05, 0x00, 0x00, 0x01};
+        memcpy(mac, simulated, 6);
+        return mac;
+    }
+    uint8_t *BSSID(uint8_t *bssid)
+    {
+        const uint8_t simulated[6] = {0x02, 0x00, 0x5e, 0x10, 0x00, 0x01};
+        memcpy(bssid, simulated, 6);
+        return bssid;
+    }
+    uint32_t getTime() { return nativeNetwork.online ? NATIVE_EPOCH_START + millis() / 1000 : 0; }
+    void setTimeout(unsigned long timeout) { this->timeout = timeout; }
+    void lowPowerMode() {}
+    void maxLowPowerMode() {}
+    void noLowPowerMode() {}
+};
+
+extern WiFiClass WiFi;
+
+/**
+ *
+ * TCP/TLS Client mit einem simulierten Server. Ein vollständiger Request
+ * (Header und 'Content-Length' Bytes) wird nach 'responseDelay' ms
+ * beantwortet: POST mit "201 Created" bzw. 'postStatus' (keep-alive), GET mit 'windradBody' (Verbindung wird geschlossen).
+ *
+ **/
+class WiFiClient : public Client
+{
+private:
+    bool open = false;
+    bool closeAfterResponse = false;
+    std::string request;
+    std::string response;
+    // Ab diesem Zeitpunkt ist die Antwort lesbar
+    unsigned long millisResponse = 0;
+
+    void handleRequest()
+    {
+        size_t headerEnd = request.find("\r\n\r\n");
+        if (headerEnd == std::string::npos)
+        {
+            return;
+        }
+
+        size_t contentLength = 0;
+        size_t field = request.find("Content-Length: ");
+        if (field != std::string::npos && field < headerEnd)
+        {
+            contentLength = atol(request.c_str() + field + 16);
+        }
+        if (request.size() < headerEnd + 4 + contentLength)
+        {
+            return;
+        }
+
+        nativeNetwork.requests++;
+        if (request.compare(0, 4, "POST") == 0)
+        {
+            nativeNetwork.posts++;
+            nativeNetwork.postedLines += std::count(request.begin() + headerEnd + 4,
+                                                    request.begin() + headerEnd + 4 + contentLength, '\n');
+            if (nativeNetwork.onPost != NULL)
+            {
+                nativeNetwork.onPost(request.substr(headerEnd + 4, contentLength));
+            }
+            if (nativeNetwork.postStatus == 201)
+            {
+                response += "HTTP/1.1 201 Created\r\nContent-Type: application/json\r\n"
+                            "Connection: keep-alive\r\nContent-Length: 25\r\n\r\n"
+                            "Measurements saved in box";
+            }
+            else if (nativeNetwork.postStatus != 0)
+            {
+                response += "HTTP/1.1 " + std::to_string(nativeNetwork.postStatus) +
+                            " Error\r\nConnection: keep-alive\r\nContent-Length: 0\r\n\r\n";
+            }
+        }
+        else
+        {
+            response += "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n";
+            response += nativeNetwork.windradBody;
+            closeAfterResponse = true;
+        }
+        request.erase(0, headerEnd + 4 + contentLength);
+        millisResponse = millis() + nativeNetwork.responseDelay;
+    }
+
+    int open_()
+    {
+        stop();
+        if (!nativeNetwork.online)
+        {
+            return 0;
+        }
+        open = true;
+        nativeNetwork.connects++;
+        return 1;
+    }
+
+public:
+    int connect(IPAddress ip, uint16_t port) { return open_(); }
+    int connect(const char *host, uint16_t port) { return open_(); }
+    int connectSSL(const char *host, uint16_t port) { return open_(); }
+
+    uint8_t connected()
+    {
+        if (open && !nativeNetwork.online)
+        {
+            open = false;
+        }
+        return open || !response.empty();
+    }
+
+    void stop()
+    {
+        open = false;
+        closeAfterResponse = false;
+        request.clear();
+        response.clear();
+    }
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size)
+    {
+        if (!open)
+        {
+            return 0;
+        }
+        request.append((const char *)buffer, size);
+        nativeNetwork.bytesSent += size;
+        handleRequest();
+        return size;
+    }
+    using Print::write;
+
+    int available() { return (long)(millis() - millisResponse) >= 0 ? response.size() : 0; }
+
+    int read()
+    {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    int read(uint8_t *buffer, size_t size)
+    {
+        size_t n = (size_t)available() < size ? available() : size;
+        memcpy(buffer, response.data(), n);
+        response.erase(0, n);
+        nativeNetwork.bytesReceived += n;
+        if (response.empty() && closeAfterResponse)
+        {
+            open = false;
+            closeAfterResponse = false;
+        }
+        return n;
+    }
+
+    operator bool() { return open; }
+};
+
+#endif
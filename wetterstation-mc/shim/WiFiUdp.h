@@ -0,0 +1,112 @@
+#ifndef __NATIVE_WIFIUDP_H_INC__
+#define __NATIVE_WIFIUDP_H_INC__
+
+#include <Arduino.h>
+#include <WiFi101.h>
+
+/**
+ *
+ * UDP über das simulierte Netzwerk. Alle Pakete landen unabhängig von der
+ * Adresse in 'nativeNetwork.datagrams' und werden von dem Socket gelesen,
+ * der ihren Port mit 'begin' geöffnet hat. Ohne Verbindung gehen Pakete
+ * verloren, wie beim WINC1500 gibt es keine Bestätigung.
+ *
+ **/
+class WiFiUDP : public Stream
+{
+private:
+    uint16_t localPort = 0;
+    uint16_t remotePort = 0;
+    std::string packet;
+    size_t packetIndex = 0;
+    bool writing = false;
+
+public:
+    uint8_t begin(uint16_t port)
+    {
+        localPort = port;
+        return 1;
+    }
+
+    void stop() { localPort = 0; }
+
+    int beginPacket(IPAddress ip, uint16_t port)
+    {
+        remotePort = port;
+        packet.clear();
+        writing = true;
+        return 1;
+    }
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size)
+    {
+        if (!writing)
+        {
+            return 0;
+        }
+        packet.append((const char *)buffer, size);
+        return size;
+    }
+    using Print::write;
+
+    int endPacket()
+    {
+        if (!writing)
+        {
+            return 0;
+        }
+        writing = false;
+        if (nativeNetwork.online)
+        {
+            nativeNetwork.datagrams.push_back({remotePort, packet});
+            nativeNetwork.datagramsSent++;
+            nativeNetwork.datagramBytes += packet.size();
+        }
+        packet.clear();
+        return 1;
+    }
+
+    /**
+     *
+     * Nächstes Paket für den eigenen Port, der Rest des vorherigen
+     * Pakets wird verworfen. Rückgabewert ist die Größe, 0 ohne Paket.
+     *
+     **/
+    int parsePacket()
+    {
+        writing = false;
+        packet.clear();
+        packetIndex = 0;
+        for (auto it = nativeNetwork.datagrams.begin(); it != nativeNetwork.datagrams.end(); ++it)
+        {
+            if (localPort != 0 && it->port == localPort)
+            {
+                packet = it->data;
+                nativeNetwork.datagrams.erase(it);
+                return packet.size();
+            }
+        }
+        return 0;
+    }
+
+    int available() { return writing ? 0 : packet.size() - packetIndex; }
+
+    int read()
+    {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    int read(uint8_t *buffer, size_t size)
+    {
+        size_t n = (size_t)available() < size ? available() : size;
+        memcpy(buffer, packet.data() + packetIndex, n);
+        packetIndex += n;
+        return n;
+    }
+
+    IPAddress remoteIP() { return IPAddress(0, 0, 0, 0); }
+};
+
+#endif
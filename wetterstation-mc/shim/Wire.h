@@ -0,0 +1,102 @@
+#ifndef __NATIVE_WIRE_H_INC__
+#define __NATIVE_WIRE_H_INC__
+
+#include <Arduino.h>
+
+/**
+ *
+ * Gerät am simulierten I2C Bus, z.B. der HDC1080 in native.cpp.
+ * 'receive' erhält die geschriebenen Bytes, 'stop' das Ende der
+ * Übertragung und 'request' füllt die Antwort auf 'requestFrom'.
+ *
+ **/
+class WireDevice
+{
+public:
+    virtual void receive(uint8_t c) {}
+    virtual void stop() {}
+    virtual uint8_t request(uint8_t *buffer, uint8_t count) { return count; }
+};
+
+/**
+ *
+ * I2C Bus, alle Geräte antworten, ohne angeschlossenes 'WireDevice' mit
+ * Nullen. Gezählt werden Übertragungen und geschriebene Bytes, z.B. für die
+ * Datenmenge des Displays. Jedes Byte auf dem Bus (inklusive Adresse) lässt
+ * die virtuelle Uhr um 9 Takte weiterlaufen, so geht die Busdauer in die
+ * Laufzeiten der Simulation ein.
+ *
+ **/
+class TwoWire : public Stream
+{
+private:
+    WireDevice *devices[128] = {};
+    uint8_t address = 0;
+    uint32_t clock = 100000;
+
+    uint8_t rx[32];
+    uint8_t rxLength = 0;
+    uint8_t rxIndex = 0;
+
+public:
+    unsigned long transmissions = 0;
+    unsigned long bytesWritten = 0;
+
+    void begin() {}
+    void setClock(uint32_t clock) { this->clock = clock; }
+
+    void attach(uint8_t address, WireDevice *device) { devices[address & 0x7F] = device; }
+
+    // Dauer von 'bytes' Bytes auf dem Bus, auch für die Sensor Nachbildungen
+    void transferTime(unsigned int bytes) { nativeAdvance(bytes * 9 * 1000000ULL / clock); }
+
+    void beginTransmission(uint8_t address)
+    {
+        this->address = address & 0x7F;
+        transmissions++;
+        transferTime(1);
+    }
+
+    uint8_t endTransmission(bool stop = true)
+    {
+        if (devices[address] != NULL)
+        {
+            devices[address]->stop();
+        }
+        return 0;
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t count)
+    {
+        this->address = address & 0x7F;
+        if (count > sizeof(rx))
+        {
+            count = sizeof(rx);
+        }
+        memset(rx, 0, count);
+        transferTime(1 + count);
+
+        rxLength = devices[this->address] != NULL ? devices[this->address]->request(rx, count) : count;
+        rxIndex = 0;
+        return rxLength;
+    }
+
+    size_t write(uint8_t c)
+    {
+        bytesWritten++;
+        transferTime(1);
+        if (devices[address] != NULL)
+        {
+            devices[address]->receive(c);
+        }
+        return 1;
+    }
+    using Print::write;
+
+    int available() { return rxLength - rxIndex; }
+    int read() { return rxIndex < rxLength ? rx[rxIndex++] : -1; }
+};
+
+extern TwoWire Wire;
+
+#endif
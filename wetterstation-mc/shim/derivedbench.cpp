@@ -0,0 +1,180 @@
+/*
+    Abgeleitete Werte (derived.cpp) für '-d': Abweichung von den Formeln in
+    double über den Messbereich, feste Stützstellen des AQI, Tendenz einer
+    gleichmäßig fallenden Messreihe und Dauer pro Aktualisierung.
+*/
+
+#include <Arduino.h>
+#include <chrono>
+#include "native.h"
+
+#include "config.h"
+#include "derived.cpp"
+
+// Luftdruck auf Meereshöhe nach der Formel des DWD (Standardatmosphäre)
+double referenceSeaLevel(double pressure, double temperature, double altitude)
+{
+    return pressure * pow(1 - 0.0065 * altitude / (temperature + 0.0065 * altitude + 273.15), -5.257);
+}
+
+// Wie 'DerivedMetrics::seaLevelPressure' mit exp() statt der Reihe
+double exactSeaLevel(double pressure, double temperature, double altitude)
+{
+    return pressure * exp(0.034163 * altitude / (temperature + 273.15 + 0.00325 * altitude));
+}
+
+double referenceDewPoint(double temperature, double humidity)
+{
+    double gamma = log(humidity / 100) + 17.62 * temperature / (243.12 + temperature);
+    return 243.12 * gamma / (17.62 - gamma);
+}
+
+/**
+ *
+ * Dauer eines Aufrufs von 'function' in ns auf dem Host, gemittelt über
+ * 'count' Aufrufe.
+ *
+ **/
+template <typename Function>
+double derivedCost(unsigned long count, Function function)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < count; i++)
+    {
+        function(i);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / count * 1e9;
+}
+
+/**
+ *
+ * Prüfung und Benchmark der abgeleiteten Werte für '-d'. Der Luftdruck auf
+ * Meereshöhe darf von der Rechnung mit exp() höchstens 0.01 hPa abweichen
+ * (Reihe und float), von der Formel des DWD höchstens 0.3 hPa (anderes
+ * Modell der Luftsäule, bis 1200 m). Der Taupunkt höchstens 0.02 °C von
+ * Magnus in double, bei 100 % Feuchte entspricht er der Temperatur. Der AQI
+ * muss an den Stützstellen der EPA genau stimmen, die Tendenz einer um
+ * 1 hPa pro Stunde fallenden Messreihe -3.00 hPa ergeben. 'count' ist die
+ * Anzahl der Aufrufe für die Zeitmessung.
+ *
+ **/
+int benchmarkDerived(unsigned long count)
+{
+    unsigned long errors = 0;
+
+    double exactError = 0, modelError = 0;
+    for (int altitude = 0; altitude <= 1200; altitude += 50)
+    {
+        for (int temperature = -30; temperature <= 45; temperature += 5)
+        {
+            for (int32_t pressure = 85000; pressure <= 105000; pressure += 500)
+            {
+                double value = DerivedMetrics::seaLevelPressure(pressure, temperature, altitude) / 100.0;
+                double exact = fabs(value - exactSeaLevel(pressure / 100.0, temperature, altitude));
+                double model = fabs(value - referenceSeaLevel(pressure / 100.0, temperature, altitude));
+                exactError = exact > exactError ? exact : exactError;
+                modelError = model > modelError ? model : modelError;
+            }
+        }
+    }
+    errors += exactError > 0.01 ? 1 : 0;
+    errors += modelError > 0.3 ? 1 : 0;
+    printf("Sea level pressure: max error %.4f hPa (exp), %.4f hPa (DWD formula)\n", exactError, modelError);
+
+    double dewError = 0, saturatedError = 0;
+    for (int t = -400; t <= 900; t++)
+    {
+        float temperature = t / 20.0f;
+        for (int humidity = 2; humidity <= 100; humidity++)
+        {
+            double error = fabs(DerivedMetrics::dewPoint(temperature, humidity) / 100.0 -
+                                referenceDewPoint(temperature, humidity));
+            dewError = error > dewError ? error : dewError;
+        }
+        double error = fabs(DerivedMetrics::dewPoint(temperature, 100) / 100.0 - temperature);
+        saturatedError = error > saturatedError ? error : saturatedError;
+    }
+    errors += dewError > 0.02 ? 1 : 0;
+    errors += saturatedError > 0.01 ? 1 : 0;
+    printf("Dew point:          max error %.4f °C (Magnus), %.4f °C at 100 %%\n", dewError, saturatedError);
+
+    // PM2.5 und PM10 in Zehntel µg/m³, erwarteter Index
+    static const uint16_t aqiCases[][3] = {
+        {0, 0, 0}, {90, 0, 50}, {91, 0, 51}, {120, 0, 56}, {354, 0, 100}, {355, 0, 101},
+        {554, 0, 150}, {1254, 0, 200}, {2254, 0, 300}, {3254, 0, 500}, {5000, 0, 500},
+        {0, 540, 50}, {0, 550, 51}, {0, 1549, 100}, {0, 1550, 101}, {0, 4249, 300},
+        {0, 6040, 500}, {120, 1000, 73}, {400, 100, 112}};
+    unsigned long aqiErrors = 0;
+    for (const uint16_t *c : aqiCases)
+    {
+        uint16_t index = DerivedMetrics::airQualityIndex(c[0], c[1]);
+        if (index != c[2])
+        {
+            printf("  AQI(%.1f, %.1f) = %u, expected %u\n", c[0] / 10.0, c[1] / 10.0, index, c[2]);
+            aqiErrors++;
+        }
+    }
+    errors += aqiErrors;
+    printf("AQI:                %lu breakpoints, %lu wrong\n", sizeof(aqiCases) / sizeof(aqiCases[0]), aqiErrors);
+
+    // Alle 10 s eine Messung, der Luftdruck fällt gleichmäßig um 1 hPa pro Stunde
+    static DerivedMetrics metrics;
+    Measurment data;
+    unsigned long first = 0;
+    int32_t tendency = 0;
+    for (unsigned long now = 0; now <= 4 * 3600000UL; now += 10000)
+    {
+        data.Pressure.setHundredths(101325 - (int32_t)(now / 36000));
+        data.setValid(FIELD_PRESSURE);
+        metrics.update(data, now);
+        if (data.isValid(FIELD_PRESSURE_TENDENCY))
+        {
+            first = first == 0 ? now : first;
+            tendency = data.PressureTendency.hundredths();
+        }
+    }
+    errors += tendency < -301 || tendency > -299 ? 1 : 0;
+    errors += first < 3 * 3600000UL ? 1 : 0;
+    printf("Pressure tendency:  %.2f hPa/3h (-3.00 expected), first after %.1f h\n", tendency / 100.0,
+           first / 3600000.0);
+
+    // Eine Lücke von einer Stunde verwirft die Vergleichswerte
+    DerivedMetrics gap;
+    for (unsigned long now = 0; now <= 4 * 3600000UL; now += now == 7200000UL ? 3600000UL : 10000)
+    {
+        gap.addPressure(101325, now);
+    }
+    errors += gap.hasTendency() ? 1 : 0;
+    printf("  after a gap:      %s\n", gap.hasTendency() ? "tendency (wrong)" : "restarted");
+
+    data.Temperature = 21.5f;
+    data.Humidity = 63.2f;
+    data.pm25 = 12.3f;
+    data.pm10 = 20.1f;
+    data.valid = (1 << FIELD_TEMPERATURE) | (1 << FIELD_PRESSURE) | (1 << FIELD_HUMIDITY) | (1 << FIELD_PM25) |
+                 (1 << FIELD_PM10);
+    volatile int32_t sink = 0;
+    unsigned long allocationsBefore = nativeAllocations;
+    double seaLevel = derivedCost(count, [&](unsigned long i)
+                                  { sink = DerivedMetrics::seaLevelPressure(101325 + (int32_t)(i & 255), 21.5f); });
+    double dewPoint = derivedCost(count, [&](unsigned long i)
+                                  { sink = DerivedMetrics::dewPoint(21.5f + (i & 15) * 0.1f, 63.2f); });
+    double aqi = derivedCost(count, [&](unsigned long i)
+                             { sink = DerivedMetrics::airQualityIndex(123 + (i & 255), 201); });
+    double update = derivedCost(count, [&](unsigned long i)
+                                {
+                                    data.Pressure.setHundredths(101325 + (int32_t)(i & 255));
+                                    metrics.update(data, 4 * 3600000UL + i * 10000);
+                                    sink = data.Aqi.hundredths();
+                                });
+    (void)sink;
+    unsigned long allocations = nativeAllocations - allocationsBefore;
+    errors += allocations;
+    printf("%-18s %10s\n", "host cost", "ns/call");
+    printf("%-18s %10.1f\n", "seaLevelPressure", seaLevel);
+    printf("%-18s %10.1f\n", "dewPoint", dewPoint);
+    printf("%-18s %10.1f\n", "airQualityIndex", aqi);
+    printf("%-18s %10.1f\n", "update (all)", update);
+    printf("Heap allocations: %lu\n", allocations);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+/*
+    Benchmark des Displays (display.cpp) für '-r'.
+*/
+
+#include <Arduino.h>
+#include <chrono>
+#include "native.h"
+
+#include "config.h"
+#ifdef SSD1306_CONNECTED
+#include "display.cpp"
+#endif
+
+#ifdef SSD1306_CONNECTED
+/**
+ *
+ * Misst 'count' Aktualisierungen der Seite 'page' mit sich ändernden
+ * Messwerten, je Aktualisierung Dauer auf dem Host, Heap Anforderungen und
+ * Bytes zum Display. 'full' zeichnet jedes Mal die ganze Seite neu (wie
+ * beim Wechsel der Seite), sonst nur die geänderten Zeichen.
+ *
+ **/
+unsigned long benchmarkPage(WSDisplay &screen, Measurment &data, int page, bool full, unsigned long count)
+{
+    screen.setDisplayPage(page);
+    unsigned long allocationsBefore = nativeAllocations;
+    unsigned long bytesBefore = screen.bytesTransferred;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < count; i++)
+    {
+        // Wie zwischen zwei Aktualisierungen: die letzten Stellen ändern sich
+        data.Temperature.setHundredths(2150 + (int32_t)(i % 40));
+        data.Pressure.setHundredths(101325 - (int32_t)(i % 17));
+        data.SeaLevelPressure.setHundredths(102600 - (int32_t)(i % 17));
+        data.PressureTendency.setHundredths(-30 - (int32_t)(i % 3));
+        data.DewPoint.setHundredths(1210 + (int32_t)(i % 25));
+        data.Lux.setHundredths(4520000 + (int32_t)(i % 9) * 100);
+        data.UV.setHundredths(21000 + (int32_t)(i % 7) * 100);
+        data.pm25.setHundredths(1230 + (int32_t)(i % 5) * 10);
+        data.Aqi.setRaw(56 + i % 3);
+        if (full)
+        {
+            screen.setDisplayPage(page);
+        }
+        else
+        {
+            screen.refreshDisplay();
+        }
+    }
+    double nanos = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / count * 1e9;
+    unsigned long allocations = nativeAllocations - allocationsBefore;
+    printf("  %-6d %-8s %12.1f %12.2f %12.1f\n", page, full ? "full" : "cells", nanos / 1000,
+           (double)allocations / count, (double)(screen.bytesTransferred - bytesBefore) / count);
+    return allocations;
+}
+
+/**
+ *
+ * Benchmark des Displays für '-r': jede Seite einmal mit vollständigem
+ * Neuzeichnen und einmal mit dem Vergleich der Zeichenzellen, 'count'
+ * Aktualisierungen je Messung. Ziel sind keine Heap Anforderungen.
+ *
+ **/
+int benchmarkDisplay(unsigned long count)
+{
+    static Measurment data;
+    data.valid = 0xFFFF;
+    unsigned long allocationsBefore = nativeAllocations;
+    WSDisplay screen(&data);
+    unsigned long setup = nativeAllocations - allocationsBefore;
+
+    printf("Display pages (%lu updates each):\n", count);
+    printf("  %-6s %-8s %12s %12s %12s\n", "page", "redraw", "us/frame", "allocs", "bytes/frame");
+    unsigned long allocations = 0;
+    for (int page = 0; page <= 3; page++)
+    {
+        allocations += benchmarkPage(screen, data, page, true, count);
+        allocations += benchmarkPage(screen, data, page, false, count);
+    }
+    printf("Heap allocations: %lu while drawing, %lu in the constructor\n", allocations, setup);
+    return allocations == 0 ? 0 : 1;
+}
+#else
+int benchmarkDisplay(unsigned long count)
+{
+    printf("The display is not enabled (SSD1306_CONNECTED)\n");
+    return 1;
+}
+#endif
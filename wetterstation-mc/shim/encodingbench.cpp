@@ -0,0 +1,149 @@
+/*
+    Benchmark der Formate für den Body der Postrequests (encoding.cpp) für '-e'.
+*/
+
+#include <Arduino.h>
+#include <Client.h>
+#include <WiFi101.h>
+#include <chrono>
+#include "native.h"
+
+#include "config.h"
+#include "encoding.cpp"
+
+/**
+ *
+ * Client welcher die Daten eines Webrequests nur zählt, für '-e'.
+ *
+ **/
+class NativeSink : public Client
+{
+public:
+    unsigned long bytes = 0;
+
+    int connect(IPAddress ip, uint16_t port) { return 1; }
+    int connect(const char *host, uint16_t port) { return 1; }
+    uint8_t connected() { return 1; }
+    void stop() {}
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size)
+    {
+        bytes += size;
+        return size;
+    }
+    int available() { return 0; }
+    int read() { return -1; }
+    int read(uint8_t *buffer, size_t size) { return 0; }
+};
+
+/**
+ *
+ * Messzyklen mit 'channels' Messungen für den Benchmark der Encoder,
+ * Werte wie bei einer Station (Temperatur, Luftdruck, Lux, ...).
+ *
+ **/
+class NativeBatch
+{
+private:
+    char ids[128][25];
+    uint8_t count;
+    uint16_t entries;
+    bool timestamps;
+
+public:
+    NativeBatch(uint8_t channels, uint16_t entries, bool timestamps = true)
+        : count(channels), entries(entries), timestamps(timestamps)
+    {
+        for (uint8_t j = 0; j < channels; j++)
+        {
+            snprintf(ids[j], sizeof(ids[j]), "5cf8c8fa07460b001b4d%04x", j);
+        }
+    }
+
+    uint16_t size() { return entries; }
+    uint8_t channels(uint16_t i) { return count; }
+    bool valid(uint16_t i, uint8_t j) { return true; }
+    int32_t value(uint16_t i, uint8_t j)
+    {
+        static const int32_t values[] = {2153, 101325, 4520, 12, 6890, -350, 950, 1510};
+        return values[j % 8] + i;
+    }
+    uint32_t epoch(uint16_t i) { return timestamps ? NATIVE_EPOCH_START + i * 60 : 0; }
+    const char *sensorId(uint8_t j) { return ids[j]; }
+};
+
+UploadWriter benchmarkWriter;
+
+/**
+ *
+ * Misst ein Format: Länge des Bodys für einen Messzyklus (mit und ohne
+ * Zeitstempel) und für 'OSM_BACKFILL_BATCH' nachgeholte Messzyklen sowie
+ * die Dauer für Berechnung der Länge und Schreiben eines Messzyklus. Prüft
+ * das die berechnete Länge den geschriebenen Bytes entspricht.
+ *
+ **/
+template <typename Encoder>
+bool benchmarkEncoder(const char *name, uint8_t channels, unsigned long count)
+{
+    NativeSink sink;
+    NativeBatch single(channels, 1);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned long errors = 0;
+    for (unsigned long n = 0; n < count; n++)
+    {
+        UploadCounter counter;
+        Encoder::write(counter, single);
+        unsigned long before = sink.bytes;
+        benchmarkWriter.begin(sink);
+        Encoder::write(benchmarkWriter, single);
+        benchmarkWriter.flush();
+        if (sink.bytes - before != counter.length)
+        {
+            errors++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Nachholen: je Request höchstens 'maxEntries()' Messzyklen
+    uint16_t perRequest = Encoder::maxEntries() < OSM_BACKFILL_BATCH ? Encoder::maxEntries() : OSM_BACKFILL_BATCH;
+    NativeBatch backfill(channels, perRequest);
+    UploadCounter counter;
+    Encoder::write(counter, backfill);
+    unsigned long requests = OSM_BACKFILL_BATCH / perRequest;
+
+    NativeBatch untimed(channels, 1, false);
+    UploadCounter one, oneUntimed;
+    Encoder::write(one, single);
+    Encoder::write(oneUntimed, untimed);
+    printf("%-10s %8u %9lu %10.1f %10.1f %7lu %9lu %10.2f %7lu\n", name, channels, (unsigned long)one.length,
+           (double)one.length / channels, (double)oneUntimed.length / channels, requests,
+           counter.length * requests, seconds / count * 1e6, errors);
+    return errors == 0;
+}
+
+/**
+ *
+ * Benchmark der Formate aus encoding.cpp für 6, 20 und 100 Messungen pro
+ * Messzyklus, 'count' Durchläufe je Format. Die Bytes des HTTP Headers
+ * (etwa 170 pro Request) sind nicht enthalten.
+ *
+ **/
+int benchmarkEncoders(unsigned long count)
+{
+    static const uint8_t channels[] = {6, 20, 100};
+    unsigned long allocationsBefore = nativeAllocations;
+    bool ok = true;
+
+    printf("%-10s %8s %9s %10s %10s %7s %9s %10s %7s\n", "format", "channels", "bytes", "bytes/val",
+           "(no time)", "backfill", "bytes", "us/cycle", "errors");
+    for (uint8_t i = 0; i < sizeof(channels); i++)
+    {
+        ok = benchmarkEncoder<CsvPaddedEncoder>("csv-padded", channels[i], count) && ok;
+        ok = benchmarkEncoder<CsvEncoder>("csv", channels[i], count) && ok;
+        ok = benchmarkEncoder<JsonEncoder>("json", channels[i], count) && ok;
+    }
+    printf("Backfill: %u cycles, 'backfill' requests with 'bytes' in total\n", OSM_BACKFILL_BATCH);
+    printf("Heap allocations: %lu\n", nativeAllocations - allocationsBefore);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#ifndef __NATIVE_ENVIRONMENT_H_INC__
+#define __NATIVE_ENVIRONMENT_H_INC__
+
+#include <Arduino.h>
+
+/**
+ *
+ * Simulierte Umgebung der Wetterstation. Die Sensor Nachbildungen lesen ihre
+ * Werte von hier, standardmäßig ein Tagesgang abhängig von der virtuellen Uhr.
+ * Über 'override' können einzelne Werte fest vorgegeben werden.
+ *
+ **/
+struct NativeEnvironment
+{
+    // Feste Werte, NAN bedeutet Tagesgang
+    float temperature = NAN;
+    float humidity = NAN;
+    float pressure = NAN;
+    float lux = NAN;
+    float uv = NAN;
+    float pm25 = NAN;
+    float pm10 = NAN;
+
+    // Anteil des Tages (0 = Mitternacht), beginnt um 'startHour'
+    float dayPhase(float startHour = 6) const
+    {
+        float hours = millis() / 3600e3f + startHour;
+        return fmodf(hours, 24) / 24;
+    }
+
+    // Tageslicht, 0 in der Nacht und 1 am Mittag
+    float daylight() const
+    {
+        float sun = sinf((dayPhase() - 0.25f) * 2 * (float)M_PI);
+        return sun > 0 ? sun : 0;
+    }
+
+    float getTemperature() const { return isnan(temperature) ? 12 + 6 * sinf((dayPhase() - 0.375f) * 2 * (float)M_PI) : temperature; }
+    float getHumidity() const { return isnan(humidity) ? 70 - 20 * daylight() : humidity; }
+    float getPressure() const { return isnan(pressure) ? 101325 + 150 * sinf(millis() / 43200e3f) : pressure; }
+    float getLux() const { return isnan(lux) ? 20000 * daylight() : lux; }
+    float getUv() const { return isnan(uv) ? 300 * daylight() : uv; }
+    float getPm25() const { return isnan(pm25) ? 8.5f + 2 * (1 - daylight()) : pm25; }
+    float getPm10() const { return isnan(pm10) ? 14.2f + 3 * (1 - daylight()) : pm10; }
+};
+
+extern NativeEnvironment nativeEnvironment;
+
+#endif
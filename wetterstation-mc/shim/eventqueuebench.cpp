@@ -0,0 +1,71 @@
+/*
+    Belastungstest der EventQueue (eventqueue.cpp) für '-i'.
+*/
+
+#include <Arduino.h>
+#include <atomic>
+#include <thread>
+#include "native.h"
+
+#include "config.h"
+#include "eventqueue.cpp"
+
+/**
+ *
+ * Belastungstest der EventQueue: ein zweiter Thread übernimmt die Rolle des
+ * Interrupts und legt 'count' fortlaufend nummerierte Ereignisse ab, der
+ * Hauptthread entnimmt sie wie die loop(). Mit 'yield' gibt der Erzeuger nach
+ * jedem Ereignis die CPU ab, sonst erzeugt er so schnell wie möglich und die
+ * Warteschlange läuft über.
+ * Jede Lücke in der Nummerierung muss durch 'dropped' erklärt sein, kein
+ * Ereignis darf doppelt oder in falscher Reihenfolge ankommen.
+ *
+ **/
+bool stressEventQueue(unsigned long count, bool yield)
+{
+    static EventQueue<uint32_t, INPUT_EVENT_QUEUE_SIZE> queue;
+    std::atomic<bool> done(false);
+    unsigned long droppedBefore = queue.dropped;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            queue.push(i);
+            if (yield)
+            {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    unsigned long received = 0, duplicated = 0, gaps = 0;
+    long last = -1;
+    uint32_t value;
+    while (!done || !queue.isEmpty())
+    {
+        while (queue.pop(value))
+        {
+            if ((long)value <= last)
+            {
+                duplicated++;
+                continue;
+            }
+            gaps += value - last - 1;
+            last = value;
+            received++;
+        }
+        if (yield)
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    gaps += count - 1 - last;
+
+    unsigned long dropped = queue.dropped - droppedBefore;
+    unsigned long lost = gaps > dropped ? gaps - dropped : 0;
+    printf("%s %lu events, %lu received, %lu dropped (full), %lu lost, %lu duplicated\n",
+           yield ? "Yielding:" : "Burst:   ", count, received, dropped, lost, duplicated);
+    return lost == 0 && duplicated == 0 && received + dropped == count;
+}
@@ -0,0 +1,288 @@
+/*
+    Filter der Messwerte (filter.cpp) für '-f': Prüfung des gleitenden
+    Medians gegen Sortieren, Kosten pro Messung und Genauigkeit auf
+    Messreihen mit eingestreuten Störungen.
+*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <vector>
+#include "native.h"
+
+#include "config.h"
+#include "filter.cpp"
+
+/**
+ *
+ * Median der letzten 'size' Werte durch Kopieren und Sortieren, Referenz
+ * für 'RunningMedian' und Vergleich der Kosten.
+ *
+ **/
+template <uint8_t N>
+class SortedMedian
+{
+private:
+    int32_t values[N];
+    uint8_t index = 0;
+    uint8_t count = 0;
+
+public:
+    void add(int32_t value)
+    {
+        values[index] = value;
+        index = index + 1 < N ? index + 1 : 0;
+        count = count < N ? count + 1 : N;
+    }
+
+    int32_t median()
+    {
+        int32_t sorted[N];
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint8_t j = i;
+            for (; j > 0 && sorted[j - 1] > values[i]; j--)
+            {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = values[i];
+        }
+        int32_t value = sorted[count / 2];
+        if ((count & 1) == 0)
+        {
+            value = sorted[count / 2 - 1] + (value - sorted[count / 2 - 1]) / 2;
+        }
+        return value;
+    }
+};
+
+/**
+ *
+ * Vergleicht 'RunningMedian' nach jedem Wert mit dem sortierten Median, die
+ * Werte haben viele Wiederholungen (kleiner Wertebereich) und Sprünge.
+ *
+ **/
+template <uint8_t N>
+unsigned long checkRunningMedian(unsigned long count)
+{
+    NativeRandom random;
+    RunningMedian<N> running;
+    SortedMedian<N> sorted;
+    unsigned long errors = 0;
+    for (unsigned long i = 0; i < count; i++)
+    {
+        int32_t value = i % 1000 < 500 ? random.uniform(-5, 5) : random.uniform(-100000, 100000);
+        running.add(value);
+        sorted.add(value);
+        if (running.median() != sorted.median())
+        {
+            errors++;
+        }
+        // Gelegentlich neu beginnen, prüft auch das teilweise gefüllte Fenster
+        if (i % 9973 == 9972)
+        {
+            running.clear();
+            sorted = SortedMedian<N>();
+        }
+    }
+    return errors;
+}
+
+/**
+ *
+ * Dauer pro Messung für Einfügen und Median, in ns auf dem Host.
+ *
+ **/
+template <typename Median>
+double medianCost(unsigned long count)
+{
+    static Median median;
+    NativeRandom random;
+    volatile int32_t sink = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < count; i++)
+    {
+        median.add(random.uniform(-100000, 100000));
+        sink = median.median();
+    }
+    (void)sink;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / count * 1e9;
+}
+
+/**
+ *
+ * Messreihe eines Kanals in Hundertstel: ungestörter Verlauf 'clean' und
+ * die gemessenen Werte mit Rauschen und Störungen. Eine Störung betrifft ein
+ * oder zwei aufeinanderfolgende Messungen (Lesefehler am I2C Bus bzw. der
+ * UART) und weicht um 'spikeMin' bis 'spikeMax' ab.
+ *
+ **/
+struct SpikeTrace
+{
+    const char *name;
+    unsigned long interval;
+    std::vector<int32_t> clean;
+    std::vector<int32_t> measured;
+    std::vector<bool> spiked;
+
+    SpikeTrace(const char *name, unsigned long interval) : name(name), interval(interval) {}
+
+    void inject(NativeRandom &random, uint32_t permille, int32_t spikeMin, int32_t spikeMax)
+    {
+        for (size_t i = 0; i < measured.size(); i++)
+        {
+            if (random.next() % 1000 >= permille)
+            {
+                continue;
+            }
+            int32_t spike = random.uniform(spikeMin, spikeMax) * (random.next() & 1 ? 1 : -1);
+            size_t length = random.next() % 4 == 0 ? 2 : 1;
+            for (size_t j = i; j < i + length && j < measured.size(); j++)
+            {
+                measured[j] += spike;
+                spiked[j] = true;
+            }
+            i += length;
+        }
+    }
+};
+
+// Heap Anforderungen während die Filter laufen
+unsigned long filterAllocations = 0;
+
+/**
+ *
+ * Wendet 'Filter' auf die Messreihe an. Gezählt werden durchgelassene
+ * Störungen (Abweichung vom Verlauf über 'tolerance'), der mittlere Fehler
+ * der ungestörten Messungen und die Dauer pro Messung. Rückgabewert ist
+ * die Anzahl der verfälschten ungestörten Messungen.
+ *
+ **/
+template <typename Filter>
+unsigned long evaluateFilter(const char *name, const SpikeTrace &trace, int32_t tolerance)
+{
+    static Filter filter;
+    filter = Filter();
+    unsigned long spikes = 0, passed = 0, distorted = 0, clean = 0;
+    double squares = 0;
+
+    std::vector<int32_t> output(trace.measured.size());
+    unsigned long allocationsBefore = nativeAllocations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < trace.measured.size(); i++)
+    {
+        output[i] = filter.apply(trace.measured[i], i * trace.interval);
+    }
+    filterAllocations += nativeAllocations - allocationsBefore;
+    double nanos = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / output.size() * 1e9;
+
+    for (size_t i = 0; i < output.size(); i++)
+    {
+        int32_t error = output[i] - trace.clean[i];
+        bool wrong = error > tolerance || error < -tolerance;
+        if (trace.spiked[i])
+        {
+            spikes++;
+            passed += wrong ? 1 : 0;
+        }
+        else
+        {
+            clean++;
+            distorted += wrong ? 1 : 0;
+            squares += (double)error * error;
+        }
+    }
+    printf("  %-16s %8lu/%-6lu %10lu %12.2f %9.1f %9lu\n", name, passed, spikes, distorted,
+           sqrt(squares / clean) / 100, nanos, filter.outliers);
+    return distorted;
+}
+
+// Ohne Filter, für den Vergleich
+struct NoFilter
+{
+    unsigned long outliers = 0;
+    int32_t apply(int32_t value, unsigned long now) { return value; }
+};
+
+// Fehler wenn der konfigurierte Filter ungestörte Messungen häufiger
+// verfälscht als ohne Filter
+template <typename Configured>
+unsigned long evaluateTrace(const char *configured, const SpikeTrace &trace, int32_t tolerance)
+{
+    printf("%s (every %lu ms, tolerance %.2f):\n", trace.name, trace.interval, tolerance / 100.0);
+    printf("  %-16s %15s %10s %12s %9s %9s\n", "filter", "spikes passed", "distorted", "rms error", "ns/value",
+           "outliers");
+    unsigned long raw = evaluateFilter<NoFilter>("raw", trace, tolerance);
+    evaluateFilter<SampleFilter<FILTER_WINDOW, FILTER_MEDIAN>>("median", trace, tolerance);
+    evaluateFilter<SampleFilter<FILTER_WINDOW, FILTER_HAMPEL, 0>>("hampel", trace, tolerance);
+    return evaluateFilter<Configured>(configured, trace, tolerance) > raw ? 1 : 0;
+}
+
+/**
+ *
+ * Benchmark und Prüfung der Filter für '-f'. Der gleitende Median muss nach
+ * jedem von 'count' Werten dem sortierten Median entsprechen. Die Kosten
+ * werden für mehrere Fenstergrößen mit dem Sortieren verglichen. Die
+ * Messreihen (Luftdruck jede Sekunde, Beleuchtungsstärke und UV alle 5 s
+ * mit Wolken, je ein Tag) erhalten 1 % Störungen. Die konfigurierten Filter
+ * dürfen ungestörte Messungen nicht häufiger verfälschen als ohne Filter. Die Filter rechnen nur mit
+ * 32 Bit Ganzzahlen wie auf dem Cortex-M0+, einzig der Vergleich der
+ * Hampel Stufe multipliziert in 64 Bit. Die Zeiten gelten für den Host.
+ *
+ **/
+int benchmarkFilters(unsigned long count)
+{
+    unsigned long errors = checkRunningMedian<1>(count) + checkRunningMedian<2>(count) +
+                           checkRunningMedian<3>(count) + checkRunningMedian<4>(count) +
+                           checkRunningMedian<5>(count) + checkRunningMedian<15>(count) +
+                           checkRunningMedian<31>(count) + checkRunningMedian<127>(count);
+    printf("Running median:   %lu values per window size, %lu wrong\n", count, errors);
+
+    printf("%-8s %14s %14s\n", "window", "running ns", "sorted ns");
+    printf("%-8u %14.1f %14.1f\n", 5, medianCost<RunningMedian<5>>(count), medianCost<SortedMedian<5>>(count));
+    printf("%-8u %14.1f %14.1f\n", 15, medianCost<RunningMedian<15>>(count), medianCost<SortedMedian<15>>(count));
+    printf("%-8u %14.1f %14.1f\n", 31, medianCost<RunningMedian<31>>(count), medianCost<SortedMedian<31>>(count));
+    printf("%-8u %14.1f %14.1f\n", 127, medianCost<RunningMedian<127>>(count), medianCost<SortedMedian<127>>(count));
+
+    NativeRandom random;
+    SpikeTrace pressure("Pressure (hundredths of hPa)", 1000);
+    for (unsigned long i = 0; i < 86400; i++)
+    {
+        int32_t value = 101325 + (int32_t)(150 * sin(i / 6875.0)) - (i > 60000 ? 300 : (int32_t)(i / 200));
+        pressure.clean.push_back(value);
+        pressure.measured.push_back(value + random.noise(2));
+        pressure.spiked.push_back(false);
+    }
+    pressure.inject(random, 10, 500, 100000);
+    errors += evaluateTrace<SampleFilter<FILTER_WINDOW, FILTER_PRESSURE>>("configured", pressure, 10);
+
+    SpikeTrace lux("Lux (hundredths of lx)", 5000);
+    SpikeTrace uv("UV (hundredths of uW/cm2)", 5000);
+    // Eigene Zufallszahlen, die Messreihe des Lichts bleibt unverändert
+    NativeRandom uvRandom;
+    uvRandom.state = 88675123UL;
+    int32_t cloud = 100;
+    for (unsigned long i = 0; i < 17280; i++)
+    {
+        float sun = sinf((i / 17280.0f - 0.25f) * 2 * (float)M_PI);
+        // Wolken wechseln alle paar Minuten, der Übergang dauert eine Messung
+        if (random.next() % 60 == 0)
+        {
+            cloud = random.uniform(30, 100);
+        }
+        int32_t value = (int32_t)(sun > 0 ? sun * 8000000 : 0) * cloud / 100;
+        lux.clean.push_back(value);
+        lux.measured.push_back(value + random.noise(value / 100 + 10));
+        lux.spiked.push_back(false);
+        value = (int32_t)(sun > 0 ? sun * 30000 : 0) * cloud / 100;
+        uv.clean.push_back(value);
+        uv.measured.push_back(value + uvRandom.noise(value / 100 + 10));
+        uv.spiked.push_back(false);
+    }
+    lux.inject(random, 10, 500000, 5000000);
+    errors += evaluateTrace<SampleFilter<FILTER_WINDOW, FILTER_LUX>>("configured", lux, 100000);
+    uv.inject(uvRandom, 10, 5000, 50000);
+    errors += evaluateTrace<SampleFilter<FILTER_WINDOW, FILTER_UV>>("configured", uv, 1000);
+
+    printf("Heap allocations while filtering: %lu\n", filterAllocations);
+    return errors == 0 && filterAllocations == 0 ? 0 : 1;
+}
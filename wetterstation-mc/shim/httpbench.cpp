@@ -0,0 +1,126 @@
+/*
+    Benchmark der HTTP Parser (http.cpp) für '-p'.
+*/
+
+#include <Arduino.h>
+#include <chrono>
+#include "native.h"
+
+#include "config.h"
+#include "http.cpp"
+
+// Wie im Network liegen die Parser nicht auf dem Stack
+HttpResponseParser benchmarkResponse;
+HttpBodyFields benchmarkFields;
+
+/**
+ *
+ * Liest eine Antwort in Stücken der Längen 'chunks' (wie sie 'available()'
+ * liefern würde), liefert true wenn die Antwort vollständig war.
+ *
+ **/
+__attribute__((noinline)) bool parseFragmented(const char *text, size_t length, const uint8_t *chunks)
+{
+    benchmarkResponse.begin();
+    benchmarkFields.begin();
+
+    size_t offset = 0;
+    for (size_t i = 0; offset < length; i++)
+    {
+        size_t end = offset + chunks[i];
+        if (end > length)
+        {
+            end = length;
+        }
+        for (; offset < end && !benchmarkResponse.isDone(); offset++)
+        {
+            if (benchmarkResponse.feed(text[offset]))
+            {
+                benchmarkFields.feed(text[offset]);
+            }
+        }
+    }
+    // Verbindung geschlossen
+    benchmarkResponse.finish();
+    benchmarkFields.finish();
+    return benchmarkResponse.isDone();
+}
+
+/**
+ *
+ * Benchmark der Parser für die Antwort des Windrads: 'count' Antworten
+ * (CSV und JSON, mit und ohne 'Content-Length', chunked) werden zufällig in
+ * Stücke von 1 bis 64 Bytes zerteilt gelesen. Die Werte werden geprüft,
+ * ausgegeben werden Durchsatz, Heap Anforderungen und der größte benutzte
+ * Stack.
+ *
+ **/
+int benchmarkHttpParser(unsigned long count)
+{
+    static const char *const responses[] = {
+        "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n3,270,9.5,15.1\n",
+        "HTTP/1.1 200 OK\r\nContent-Type: text/csv\r\nContent-Length: 21\r\n\r\n12.345,-45,0.07,123.4",
+        "HTTP/1.1 200 OK\r\nServer: windrad\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n"
+        "{\"name\":\"Windrad 2\",\"speed\":3.25,\"direction\":270,\"pm\":[9.5,15.1]}",
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n6\r\n3,270,\r\n8\r\n9.5,15.1\r\n0\r\n\r\n"};
+    static const int32_t expected[][HTTP_BODY_FIELDS] = {
+        {300, 27000, 950, 1510}, {1234, -4500, 7, 12340}, {325, 27000, 950, 1510}, {300, 27000, 950, 1510}};
+    const uint8_t kinds = sizeof(responses) / sizeof(responses[0]);
+
+    uint8_t chunks[256];
+    for (size_t i = 0; i < sizeof(chunks); i++)
+    {
+        chunks[i] = 1 + rand() % 64;
+    }
+
+    unsigned long allocationsBefore = nativeAllocations;
+    unsigned long errors = 0;
+    size_t bytes = 0;
+    size_t peakStack = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < count; n++)
+    {
+        uint8_t kind = n % kinds;
+        size_t length = strlen(responses[kind]);
+        // Andere Zerteilung in jedem Durchlauf
+        const uint8_t *fragments = chunks + n % (sizeof(chunks) - 128);
+
+        // Nicht im ersten Durchlauf messen, das Auflösen der Bibliotheksfunktionen
+        // (strchr, atoi, ...) durch den dynamischen Linker braucht viel Stack
+        bool complete;
+        if (n % 1024 == 1023)
+        {
+            paintStack();
+            complete = parseFragmented(responses[kind], length, fragments);
+            size_t used = paintedStackUsed();
+            peakStack = used > peakStack ? used : peakStack;
+        }
+        else
+        {
+            complete = parseFragmented(responses[kind], length, fragments);
+        }
+        bytes += length;
+
+        bool valid = complete && benchmarkResponse.getStatusCode() == 200 &&
+                     benchmarkFields.size() == HTTP_BODY_FIELDS;
+        for (uint8_t i = 0; valid && i < HTTP_BODY_FIELDS; i++)
+        {
+            valid = benchmarkFields.get(i) == expected[kind][i];
+        }
+        if (!valid)
+        {
+            errors++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Responses:        %lu (%lu wrong)\n", count, errors);
+    printf("Throughput:       %.1f MB/s (%.0f bytes/s)\n", bytes / seconds / 1e6, bytes / seconds);
+    printf("Heap allocations: %lu\n", nativeAllocations - allocationsBefore);
+    printf("Peak stack:       %lu bytes\n", (unsigned long)peakStack);
+    printf("Parser state:     %lu bytes (HttpResponseParser %lu, HttpBodyFields %lu)\n",
+           (unsigned long)(sizeof(HttpResponseParser) + sizeof(HttpBodyFields)),
+           (unsigned long)sizeof(HttpResponseParser), (unsigned long)sizeof(HttpBodyFields));
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+/*
+    Benchmark und Prüfung des Messdaten Logs (measurementlog.cpp) für '-l',
+    auf einer Datei über 'FileLogStorage'. Gemessen werden die Rate beim
+    Anhängen und die Dauer der Wiederherstellung nach einem Neustart,
+    geprüft werden Inhalt, Anzahl der gelesenen Blöcke und der Verlust
+    bei einem unterbrochenen Schreibvorgang.
+*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <math.h>
+#include "native.h"
+
+#include "measurementlog.cpp"
+
+#define LOG_BENCH_FILE "logbench.bin"
+
+/**
+ *
+ * Reicht Zugriffe an eine Datei weiter und zählt die Lesezugriffe. Mit
+ * 'tearAfter' wird ein Schreibvorgang nach so vielen Bytes abgebrochen,
+ * wie bei einem Reset während des Schreibens.
+ *
+ **/
+class BenchLogStorage : public LogStorage
+{
+public:
+    FileLogStorage file;
+    unsigned long reads = 0;
+    int tearAfter = -1;
+
+    bool read(uint32_t offset, uint8_t *data, uint16_t length)
+    {
+        reads++;
+        return file.read(offset, data, length);
+    }
+
+    bool write(uint32_t offset, const uint8_t *data, uint16_t length)
+    {
+        if (tearAfter >= 0 && tearAfter < length)
+        {
+            file.write(offset, data, tearAfter);
+            return false;
+        }
+        return file.write(offset, data, length);
+    }
+};
+
+static logRecord benchRecord(uint32_t i)
+{
+    logRecord record;
+    memset(&record, 0, sizeof(record));
+    record.timestamp = i;
+    for (uint8_t j = 0; j < NUM_SENSORS; j++)
+    {
+        record.values[j] = (int32_t)(i * (j + 1));
+    }
+    record.valid = (1 << NUM_SENSORS) - 1;
+    record.count = NUM_SENSORS;
+    return record;
+}
+
+/**
+ *
+ * Öffnet das Log neu wie nach einem Reset und prüft Anzahl und Inhalt
+ * der Einträge, 'first' ist der Zeitstempel des ältesten erwarteten
+ * Eintrags. Liefert die Anzahl der Fehler.
+ *
+ **/
+static unsigned long checkRecovery(const char *name, uint32_t blocks, uint32_t expected, uint32_t first)
+{
+    BenchLogStorage storage;
+    storage.file.begin(LOG_BENCH_FILE);
+    MeasurementLog log;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t recovered = log.begin(storage, blocks);
+    double millis = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3;
+    unsigned long reads = storage.reads;
+
+    unsigned long errors = 0;
+    for (uint32_t i = 0; i < log.size(); i++)
+    {
+        logRecord record;
+        logRecord reference = benchRecord(first + i);
+        if (!log.read(i, record) || memcmp(&record, &reference, sizeof(record)) != 0)
+        {
+            errors++;
+        }
+    }
+
+    // Das Log muss an der wiederhergestellten Position weiterschreiben
+    logRecord next = benchRecord(first + recovered);
+    logRecord record;
+    if (!log.append(next) || !log.read(log.size() - 1, record) || memcmp(&record, &next, sizeof(record)) != 0)
+    {
+        errors++;
+    }
+
+    // Kopf des ersten und letzten Blocks, binäre Suche, ältester und aktueller Block
+    unsigned long maxReads = (unsigned long)ceil(log2((double)blocks)) + 4;
+    printf("%-22s %8u records (expected %u), %lu reads (max %lu), %.2f ms, %lu wrong\n",
+           name, recovered, expected, reads, maxReads, millis, errors);
+    return errors + (recovered != expected) + (reads > maxReads);
+}
+
+/**
+ *
+ * Hängt 'count' Einträge an und bricht den letzten Schreibvorgang nach
+ * 'tear' Bytes ab (-1 für keinen Abbruch).
+ *
+ **/
+static double appendRecords(uint32_t blocks, uint32_t count, int tear)
+{
+    remove(LOG_BENCH_FILE);
+    BenchLogStorage storage;
+    storage.file.begin(LOG_BENCH_FILE);
+    MeasurementLog log;
+    log.begin(storage, blocks);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i == count - 1)
+        {
+            storage.tearAfter = tear;
+        }
+        log.append(benchRecord(i));
+    }
+    return count / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ *
+ * '-l': 'count' Einträge in ein Log mit 'LOG_CAPACITY_BLOCKS' Blöcken,
+ * danach Wiederherstellung und unterbrochene Schreibvorgänge in einem
+ * kleinen Log, welches schon mehrmals umgelaufen ist.
+ *
+ **/
+int benchmarkLog(unsigned long count)
+{
+    const uint32_t perBlock = LOG_RECORDS_PER_BLOCK;
+    const uint32_t capacity = LOG_CAPACITY_BLOCKS * perBlock;
+    printf("Log: %u records per %u byte block, %u blocks\n", perBlock, LOG_BLOCK_SIZE, LOG_CAPACITY_BLOCKS);
+
+    double rate = appendRecords(LOG_CAPACITY_BLOCKS, count, -1);
+    printf("Append:                %8lu records, %.0f records/s\n", count, rate);
+    // Nach dem Umlaufen fehlt der gerade überschriebene älteste Block
+    uint32_t kept = count < capacity ? count : (LOG_CAPACITY_BLOCKS - 1) * perBlock + count % perBlock;
+    unsigned long errors = checkRecovery("Recovery", LOG_CAPACITY_BLOCKS, kept, count - kept);
+
+    // Klein und umgelaufen, Abbruch mitten in einem Block verliert nur diesen Eintrag
+    const uint32_t blocks = 16;
+    uint32_t records = 5 * blocks * perBlock + perBlock / 2;
+    appendRecords(blocks, records, sizeof(logSlot) / 2);
+    uint32_t expected = (blocks - 1) * perBlock + perBlock / 2 - 1;
+    errors += checkRecovery("Torn record", blocks, expected, records - 1 - expected);
+
+    // Abbruch beim Kopf eines neuen Blocks, verloren ist nur der überschriebene älteste Block
+    records = 5 * blocks * perBlock + 1;
+    appendRecords(blocks, records, sizeof(logBlockHeader) / 2);
+    expected = (blocks - 1) * perBlock;
+    errors += checkRecovery("Torn block header", blocks, expected, records - 1 - expected);
+
+    // Abbruch beim ersten Block eines neuen Logs
+    appendRecords(blocks, 1, 4);
+    errors += checkRecovery("Torn first block", blocks, 0, 0);
+
+    remove(LOG_BENCH_FILE);
+    return errors == 0 ? 0 : 1;
+}
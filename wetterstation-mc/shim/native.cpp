@@ -0,0 +1,532 @@
+/*
+    Einstiegspunkt der Umgebung 'native' (siehe platformio.ini).
+
+    Simuliert die Wetterstation ereignisgesteuert: setup() und loop() laufen
+    mit virtueller Uhr, nach jedem Durchlauf springt die Uhr direkt zur
+    nächsten Deadline des Schedulers bzw. zum nächsten Ereignis des Szenarios.
+    Ausgegeben wird ein Zeitstrahl der Posts, Verbindungen und Display
+    Übertragungen, welcher sich zwischen zwei Versionen vergleichen lässt.
+    Am Ende steht der nach dem Energiemodell (power.cpp) erwartete Strom
+    der übersetzten Konfiguration, z.B. mit -D LOW_POWER_MODE.
+    Aufruf:
+
+        program [-s Sekunden] [-v] [-w] [Szenario ...]
+        program -i Anzahl
+        program -p Anzahl
+        program -e Anzahl
+        program -t
+        program -f Anzahl
+        program -d Anzahl
+        program -r Anzahl
+        program -l Anzahl
+        program -a [-s Sekunden] [Szenario ...]
+        program -g Stationen [-s Sekunden]
+
+    '-s' ist die simulierte Laufzeit (Standard ein Tag), '-v' gibt die Debug
+    Ausgaben auf stdout aus. Nach setup() steht der Zeitstrahl des Starts,
+    '-w' startet dabei wie nach einem Reset mit gespeichertem WLAN Profil. Szenarien beschreiben Messreihen, WLAN
+    Ausfälle und Tastendrücke, siehe scenario.h und shim/scenarios/.
+    '-i' führt statt der Simulation einen Belastungstest der EventQueue aus,
+    '-p' einen Benchmark des HTTP Parsers mit zerteilten Antworten, '-e' der
+    Formate für den Body der Postrequests, '-t' das Zeitmodell einer Sensor
+    Messung (bisher, nacheinander und überlappend), '-f' prüft die Filter der
+    Messwerte und misst Kosten und Genauigkeit auf gestörten Messreihen,
+    '-d' vergleicht die abgeleiteten Werte (derived.cpp) mit Referenzen in
+    double und misst die Dauer einer Aktualisierung, '-r' misst Dauer, Heap
+    Anforderungen und übertragene Bytes beim Zeichnen der Display Seiten.
+    '-l' schreibt Anzahl Einträge in das Messdaten Log (logbench.cpp) und
+    prüft die Wiederherstellung, auch nach unterbrochenen Schreibvorgängen.
+    '-a' spielt die Messwerte der Szenarien (z.B. shim/scenarios/summer-day.txt)
+    ohne Firmware ab und vergleicht das adaptive Sendeintervall
+    (uploadpolicy.cpp) mit dem festen: gesparte Posts und Verzögerung der
+    Änderungen über dem Schwellwert.
+    '-g' (nur mit GATEWAY_MODE) simuliert zusätzlich Stationen, welche ihre
+    Messungen per UDP an das Gateway senden.
+    Die Modi außer der Simulation liegen je in einer eigenen Datei, siehe
+    native.h. "pio test -e native" übersetzt die Unity Tests unter test/ mit
+    den gleichen Teilen, main() entfällt dann (PIO_UNIT_TESTING).
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <WiFi101.h>
+#include <WiFiUdp.h>
+#include <senseBoxIO.h>
+#include <new>
+#include "native.h"
+
+#include "config.h"
+#include "network.cpp"
+#include "scheduler.cpp"
+#include "uploadpolicy.cpp"
+
+#ifdef SSD1306_CONNECTED
+#include "display.cpp"
+#endif
+
+unsigned long long nativeMicros = 0;
+HardwareSerial Serial;
+HardwareSerial Serial1;
+TwoWire Wire;
+WiFiClass WiFi;
+SenseBoxIO senseBoxIO;
+NativeEnvironment nativeEnvironment;
+NativeNetwork nativeNetwork;
+NativeSds011 sds011;
+NativeHdc1080 hdc1080;
+
+void setup();
+void loop();
+
+extern Network network;
+extern Scheduler scheduler;
+extern BootSequencer boot;
+#ifdef ADAPTIVE_UPLOAD
+extern UploadPolicy uploadPolicy;
+#endif
+#ifdef SSD1306_CONNECTED
+extern WSDisplay *display;
+#endif
+
+Scenario scenario;
+
+/**
+ *
+ * Schreibt eine Zeile des Zeitstrahls mit der virtuellen Zeit.
+ *
+ **/
+void timeline(const char *text)
+{
+    unsigned long now = millis();
+    unsigned long seconds = now / 1000;
+    // Die Debug Ausgaben stehen sonst in der gleichen Zeile
+    if (Serial.echo)
+    {
+        putchar('\n');
+    }
+    printf("[%3lud %02lu:%02lu:%02lu.%03lu] %s\n", seconds / 86400, seconds / 3600 % 24,
+           seconds / 60 % 60, seconds % 60, now % 1000, text);
+}
+
+/**
+ *
+ * Zählerstände der Firmware, Änderungen werden als Ereignis ausgegeben.
+ *
+ **/
+struct Counters
+{
+    unsigned long posts;
+    unsigned long failedPosts;
+    unsigned long handshakes;
+    unsigned long associations;
+    unsigned long linkJoins;
+    unsigned long linkLosses;
+    unsigned long displayFlushes;
+    unsigned long displayBytes;
+
+    void read()
+    {
+        posts = network.posts;
+        failedPosts = network.failedPosts;
+        handshakes = network.handshakes;
+        associations = nativeNetwork.associations;
+        linkJoins = network.getLink().joins;
+        linkLosses = network.getLink().linkLosses;
+#ifdef SSD1306_CONNECTED
+        displayFlushes = display->flushes;
+        displayBytes = display->bytesTransferred;
+#else
+        displayFlushes = 0;
+        displayBytes = 0;
+#endif
+    }
+};
+
+void reportChanges(const Counters &before, const Counters &after)
+{
+    char text[96];
+    if (after.associations != before.associations)
+    {
+        timeline("wifi associate");
+    }
+    if (after.linkJoins != before.linkJoins)
+    {
+        WifiLink &link = network.getLink();
+        snprintf(text, sizeof(text), "wifi up after %lu ms, rssi %ld dBm", link.lastJoinTime, (long)link.rssi);
+        timeline(text);
+    }
+    if (after.linkLosses != before.linkLosses)
+    {
+        timeline("wifi lost");
+    }
+    if (after.handshakes != before.handshakes)
+    {
+        timeline("tls handshake");
+    }
+    if (after.posts != before.posts)
+    {
+        snprintf(text, sizeof(text), "post %u latency %lu ms", network.lastStatusCode, network.lastPostLatency);
+        timeline(text);
+    }
+    if (after.failedPosts != before.failedPosts)
+    {
+        snprintf(text, sizeof(text), "post failed (status %u)", network.lastStatusCode);
+        timeline(text);
+    }
+    if (after.displayFlushes != before.displayFlushes)
+    {
+        snprintf(text, sizeof(text), "display refresh %lu bytes", after.displayBytes - before.displayBytes);
+        timeline(text);
+    }
+}
+
+/*
+    Zählt alle Anforderungen von Heap Speicher, so lässt sich prüfen ob ein
+    Programmteil ohne Heap auskommt.
+*/
+
+unsigned long nativeAllocations = 0;
+
+void *operator new(size_t size)
+{
+    nativeAllocations++;
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept
+{
+    free(p);
+}
+
+/*
+    Messung des Stacks: 'paintStack' füllt den Bereich unterhalb des
+    aktuellen Stacks mit einem Muster, 'paintedStackUsed' zählt nach einem
+    Aufruf auf gleicher Tiefe die überschriebenen Bytes.
+*/
+
+#define STACK_PAINT_SIZE 8192
+#define STACK_PAINT_PATTERN 0xA5
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((noinline)) void paintStack()
+{
+    volatile uint8_t region[STACK_PAINT_SIZE];
+    for (size_t i = 0; i < STACK_PAINT_SIZE; i++)
+    {
+        region[i] = STACK_PAINT_PATTERN;
+    }
+}
+
+__attribute__((noinline)) size_t paintedStackUsed()
+{
+    // Absichtlich nicht initialisiert, enthält das Muster von 'paintStack'
+    volatile uint8_t region[STACK_PAINT_SIZE];
+    size_t untouched = 0;
+    while (untouched < STACK_PAINT_SIZE && region[untouched] == STACK_PAINT_PATTERN)
+    {
+        untouched++;
+    }
+    return STACK_PAINT_SIZE - untouched;
+}
+#pragma GCC diagnostic pop
+
+#ifdef GATEWAY_MODE
+// Messungen je Frame einer simulierten Station (BMP280, HDC1080, TSL45315, VEML6070)
+#define NATIVE_STATION_READINGS 6
+
+/**
+ *
+ * Simulierte Stationen für '-g': jede sendet im Intervall
+ * 'OSM_REFRESH_INTERVAL' einen Frame an das Gateway, über das Intervall
+ * verteilt. Die IDs werden aus der Nummer der Station erzeugt.
+ *
+ **/
+class NativeStations
+{
+private:
+    WiFiUDP udp;
+    uint8_t frame[GATEWAY_FRAME_SIZE];
+
+    unsigned long offset(unsigned int station)
+    {
+        return 1000 + (unsigned long)station * (unsigned long)OSM_REFRESH_INTERVAL / count;
+    }
+
+public:
+    unsigned int count = 0;
+    unsigned long frames = 0;
+    unsigned long readings = 0;
+
+    // Nächster Sendezeitpunkt (millis) einer Station nach 'now'
+    unsigned long next(unsigned long now)
+    {
+        unsigned long next = (unsigned long)-1;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            unsigned long start = offset(i);
+            unsigned long time = start;
+            if (now >= start)
+            {
+                time = start + ((now - start) / (unsigned long)OSM_REFRESH_INTERVAL + 1) * (unsigned long)OSM_REFRESH_INTERVAL;
+            }
+            next = time < next ? time : next;
+        }
+        return next;
+    }
+
+    // Sendet die Frames aller Stationen deren Zeitpunkt in ('last', 'now'] liegt
+    void run(unsigned long last, unsigned long now)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            unsigned long start = offset(i);
+            if (now < start)
+            {
+                continue;
+            }
+            unsigned long due = start + (now - start) / (unsigned long)OSM_REFRESH_INTERVAL * (unsigned long)OSM_REFRESH_INTERVAL;
+            if (due <= last)
+            {
+                continue;
+            }
+
+            char boxId[25], sensorId[25];
+            snprintf(boxId, sizeof(boxId), "5d0000000000000000%06x", i & 0xFFFFFF);
+            GatewayFrameWriter writer;
+            writer.begin(frame, boxId, NATIVE_EPOCH_START + now / 1000);
+            for (uint8_t j = 0; j < NATIVE_STATION_READINGS; j++)
+            {
+                snprintf(sensorId, sizeof(sensorId), "5e00000000000000%06x%02x", i & 0xFFFFFF, j);
+                writer.add(sensorId, 1000 + j * 150 + i);
+            }
+            uint16_t length = writer.finish();
+            udp.beginPacket(IPAddress(127, 0, 0, 1), GATEWAY_PORT);
+            udp.write(frame, length);
+            udp.endPacket();
+            frames++;
+            readings += NATIVE_STATION_READINGS;
+        }
+    }
+};
+
+NativeStations stations;
+
+/**
+ *
+ * Bericht für '-g': Posts pro Minute und übertragene Bytes je Messung.
+ *
+ **/
+void reportGateway(unsigned long seconds)
+{
+    Gateway &gateway = network.getGateway();
+    double minutes = seconds / 60.0;
+    printf("\nGateway stations: %u (frames %lu, readings %lu)\n", stations.count, stations.frames, stations.readings);
+    printf("Gateway queued:   %lu readings (rejected %lu, dropped %lu, posted %lu)\n",
+           gateway.readingsQueued, gateway.readingsRejected, gateway.readingsDropped(), network.gatewayReadingsPosted);
+    printf("HTTP posts/min:   %.2f (direct upload %.2f)\n", nativeNetwork.posts / minutes,
+           (stations.count + 1) * 60e3 / OSM_REFRESH_INTERVAL);
+    printf("HTTP bytes/reading: %.1f (%lu bytes, %lu readings)\n",
+           nativeNetwork.postedLines ? (double)nativeNetwork.bytesSent / nativeNetwork.postedLines : 0.0,
+           nativeNetwork.bytesSent, nativeNetwork.postedLines);
+    printf("UDP bytes/reading:  %.1f\n", stations.readings ? (double)nativeNetwork.datagramBytes / stations.readings : 0.0);
+}
+#endif
+
+void nativeSetup()
+{
+    Serial1.device = &sds011;
+    Wire.attach(0x40, &hdc1080);
+    scenario.apply(0, timeline);
+    setup();
+}
+
+unsigned long nativeRun(unsigned long end, bool report)
+{
+    Counters before, after;
+    before.read();
+
+    unsigned long iterations = 0;
+#ifdef GATEWAY_MODE
+    static unsigned long lastStations = 0;
+#endif
+    while (millis() < end)
+    {
+        scenario.apply(millis(), timeline);
+#ifdef GATEWAY_MODE
+        stations.run(lastStations, millis());
+        lastStations = millis();
+#endif
+        loop();
+        iterations++;
+
+        after.read();
+        if (report)
+        {
+            reportChanges(before, after);
+        }
+        before = after;
+
+        // Direkt zur nächsten Deadline, zum nächsten Ereignis oder zum Ende springen
+        unsigned long now = millis();
+        unsigned long wait = scheduler.timeUntilNext();
+        if (scenario.nextTime() > now && scenario.nextTime() - now < wait)
+        {
+            wait = scenario.nextTime() - now;
+        }
+#ifdef GATEWAY_MODE
+        if (stations.count > 0 && stations.next(now) - now < wait)
+        {
+            wait = stations.next(now) - now;
+        }
+#endif
+        if (end - now < wait)
+        {
+            wait = end - now;
+        }
+        nativeAdvance((wait > 0 ? wait : 1) * 1000ULL);
+    }
+    return iterations;
+}
+
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv)
+{
+    unsigned long seconds = 86400;
+    bool replay = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            Serial.echo = true;
+        }
+        else if (strcmp(argv[i], "-w") == 0)
+        {
+            uint8_t bssid[6];
+            nativeNetwork.profile = true;
+            wifiCache().remember(NET_SSID, WiFi.BSSID(bssid));
+        }
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+        {
+            unsigned long count = atol(argv[++i]);
+            bool ok = stressEventQueue(count, false) && stressEventQueue(count, true);
+            return ok ? 0 : 1;
+        }
+        else if (strcmp(argv[i], "-t") == 0)
+        {
+            Wire.attach(0x40, &hdc1080);
+            return timingModel();
+        }
+        else if (strcmp(argv[i], "-a") == 0)
+        {
+            replay = true;
+        }
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            return benchmarkFilters(atol(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            return benchmarkDerived(atol(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            return benchmarkDisplay(atol(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+        {
+            return benchmarkLog(atol(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            return benchmarkEncoders(atol(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            return benchmarkHttpParser(atol(argv[++i]));
+        }
+#ifdef GATEWAY_MODE
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+        {
+            stations.count = atol(argv[++i]);
+        }
+#endif
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            seconds = atol(argv[++i]);
+        }
+        else if (!scenario.load(argv[i]))
+        {
+            return 1;
+        }
+    }
+
+    if (replay)
+    {
+        return replayUploads(seconds);
+    }
+
+    nativeSetup();
+    timeline("setup done");
+    if (!Serial.echo)
+    {
+        Serial.echo = true;
+        boot.report(Serial);
+        Serial.echo = false;
+    }
+
+    unsigned long iterations = nativeRun(seconds * 1000, true);
+
+    printf("\nSimulated:        %lu s in %lu loop iterations\n", seconds, iterations);
+    printf("Posts:            %lu (failed %lu, rejected %lu)\n", network.posts, network.failedPosts,
+           network.rejectedPosts);
+    printf("POST requests:    %lu\n", nativeNetwork.posts);
+    printf("TLS handshakes:   %lu (avoided %lu)\n", network.handshakes, network.handshakesAvoided);
+    printf("WiFi associations:%lu\n", nativeNetwork.associations);
+    printf("Bytes sent:       %lu\n", nativeNetwork.bytesSent);
+    printf("Max post latency: %lu ms\n", network.maxPostLatency);
+    printf("Task executions:  %lu\n", scheduler.getExecutions());
+    printf("Max jitter:       %lu ms\n", scheduler.getMaxJitter());
+    printf("I2C bytes:        %lu\n", Wire.bytesWritten);
+#ifdef SSD1306_CONNECTED
+    printf("Display bytes:    %lu (%lu flushes, %lu skipped)\n",
+           display->bytesTransferred, display->flushes, display->skippedFlushes);
+#endif
+#ifdef GATEWAY_MODE
+    if (stations.count > 0)
+    {
+        reportGateway(seconds);
+    }
+#endif
+
+    // Projektierter Stromverbrauch dieser Konfiguration
+    printf("Sleeps:           %lu standby, %lu idle\n", power().standbys, power().idles);
+    printf("\n");
+    Serial.echo = true;
+    network.getLink().report(Serial);
+#ifdef ADAPTIVE_UPLOAD
+    uploadPolicy.report(Serial);
+#endif
+    power().report(Serial);
+    Serial.echo = false;
+#ifdef ENABLE_PROFILING
+    printf("\n");
+    Serial.echo = true;
+    profiler().report(Serial);
+#endif
+    return 0;
+}
+#endif
@@ -0,0 +1,188 @@
+#ifndef __NATIVE_H_INC__
+#define __NATIVE_H_INC__
+
+/*
+    Gemeinsame Teile der Umgebung 'native' (siehe platformio.ini): die
+    nachgebildeten Sensoren, die Simulation von setup() und loop() mit
+    virtueller Uhr (native.cpp) sowie die Benchmarks, je Datei ein Modus
+    des Programms. Die Unity Tests unter test/ nutzen die gleichen Teile.
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "environment.h"
+#include "scenario.h"
+
+/**
+ *
+ * SDS011 an Serial1: beantwortet Abfragen (0x04) mit den Werten der
+ * simulierten Umgebung, alle anderen Kommandos mit einer Bestätigung.
+ *
+ **/
+class NativeSds011 : public SerialDevice
+{
+private:
+    uint8_t frame[19];
+    uint8_t index = 0;
+
+public:
+    void receive(HardwareSerial &port, uint8_t c)
+    {
+        if (index == 0 && c != 0xAA)
+        {
+            return;
+        }
+        frame[index++] = c;
+        if (index < sizeof(frame))
+        {
+            return;
+        }
+        index = 0;
+
+        uint16_t pm25 = nativeEnvironment.getPm25() * 10;
+        uint16_t pm10 = nativeEnvironment.getPm10() * 10;
+        uint8_t reply[10] = {0xAA, 0xC5, frame[2], frame[3], frame[4], 0, 0xA1, 0x60, 0, 0xAB};
+        if (frame[2] == 0x04)
+        {
+            reply[1] = 0xC0;
+            reply[2] = pm25 & 0xFF;
+            reply[3] = pm25 >> 8;
+            reply[4] = pm10 & 0xFF;
+            reply[5] = pm10 >> 8;
+        }
+        for (uint8_t i = 2; i < 8; i++)
+        {
+            reply[8] += reply[i];
+        }
+        port.inject(reply, sizeof(reply));
+    }
+};
+
+extern NativeSds011 sds011;
+
+/**
+ *
+ * HDC1080 am I2C Bus: das Schreiben des Zeigers 0x00 startet die Messung
+ * von Temperatur und Feuchte. Wird vor Ende der Wandlung gelesen, antwortet
+ * der Sensor wie das Original nicht (NACK) und 'earlyReads' wird gezählt.
+ *
+ **/
+class NativeHdc1080 : public WireDevice
+{
+private:
+    uint8_t pointer = 0xFF;
+    bool triggered = false;
+    unsigned long long microsTrigger = 0;
+
+public:
+    // Wandlungszeit bei 14 Bit laut Datenblatt
+    static const unsigned long conversionMicros = 6350 + 6500;
+
+    unsigned long conversions = 0;
+    unsigned long earlyReads = 0;
+
+    void receive(uint8_t c)
+    {
+        pointer = c;
+    }
+
+    void stop()
+    {
+        if (pointer == 0x00)
+        {
+            triggered = true;
+            microsTrigger = micros();
+            conversions++;
+        }
+    }
+
+    uint8_t request(uint8_t *buffer, uint8_t count)
+    {
+        if (!triggered || micros() - microsTrigger < conversionMicros || count < 4)
+        {
+            earlyReads++;
+            return 0;
+        }
+        triggered = false;
+
+        uint16_t temperature = (nativeEnvironment.getTemperature() + 40) / 165 * 65536;
+        uint16_t humidity = nativeEnvironment.getHumidity() / 100 * 65535;
+        buffer[0] = temperature >> 8;
+        buffer[1] = temperature & 0xFF;
+        buffer[2] = humidity >> 8;
+        buffer[3] = humidity & 0xFF;
+        return 4;
+    }
+};
+
+extern NativeHdc1080 hdc1080;
+
+// Reproduzierbare Zufallszahlen (xorshift32), unabhängig von rand()
+struct NativeRandom
+{
+    uint32_t state = 2463534242UL;
+
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Gleichverteilt in [low, high]
+    int32_t uniform(int32_t low, int32_t high) { return low + (int32_t)(next() % (uint32_t)(high - low + 1)); }
+
+    // Näherungsweise normalverteilt (Summe von vier Gleichverteilungen)
+    int32_t noise(int32_t sigma)
+    {
+        int32_t sum = 0;
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            sum += uniform(-1000, 1000);
+        }
+        return sum * sigma / 1155;
+    }
+};
+
+extern Scenario scenario;
+
+// Anzahl der Anforderungen von Heap Speicher seit dem Start
+extern unsigned long nativeAllocations;
+
+// Messung des Stacks, siehe native.cpp
+void paintStack();
+size_t paintedStackUsed();
+
+void timeline(const char *text);
+
+/**
+ *
+ * Schließt die nachgebildeten Sensoren an, wendet den Beginn des Szenarios
+ * an und ruft setup() auf.
+ *
+ **/
+void nativeSetup();
+
+/**
+ *
+ * Ruft loop() auf bis die virtuelle Uhr 'end' (millis) erreicht, dazwischen
+ * springt die Uhr zur nächsten Deadline oder zum nächsten Ereignis. Mit
+ * 'report' werden Posts, Verbindungen usw. im Zeitstrahl ausgegeben.
+ * Rückgabewert ist die Anzahl der Durchläufe.
+ *
+ **/
+unsigned long nativeRun(unsigned long end, bool report);
+
+// Modi des Programms, je in einer eigenen Datei
+bool stressEventQueue(unsigned long count, bool yield);
+int benchmarkHttpParser(unsigned long count);
+int benchmarkEncoders(unsigned long count);
+int timingModel();
+int benchmarkFilters(unsigned long count);
+int benchmarkDerived(unsigned long count);
+int benchmarkDisplay(unsigned long count);
+int benchmarkLog(unsigned long count);
+int replayUploads(unsigned long seconds);
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef __NATIVE_SCENARIO_H_INC__
+#define __NATIVE_SCENARIO_H_INC__
+
+#include <Arduino.h>
+#include <WiFi101.h>
+#include <vector>
+#include "environment.h"
+
+/**
+ *
+ * Ein Ereignis des Szenarios: zum Zeitpunkt 'time' (ms seit Start) wird
+ * die Größe 'name' auf 'value' gesetzt.
+ *
+ **/
+struct ScenarioEvent
+{
+    unsigned long time;
+    std::string name;
+    float value;
+};
+
+/**
+ *
+ * Ablauf einer Simulation aus Textdateien, eine Zeile pro Ereignis:
+ *
+ *     <Sekunden> <Größe> <Wert>
+ *
+ * Größen sind 'temperature', 'humidity', 'pressure' (Pa), 'lux', 'uv',
+ * 'pm25', 'pm10' (Wert "auto" für den Tagesgang), 'wifi' ("on"/"off"),
+ * 'rssi' (dBm), 'jointime' (Dauer einer Verbindung in ms), 'reject' (Anzahl
+ * der folgenden Verbindungsversuche welche der Access Point ablehnt),
+ * 'status' (Statuscode der openSenseMap auf Posts, 0 = keine Antwort) und
+ * 'button' (Wert ist der Pin, dessen Interrupt ausgelöst wird).
+ * Zeilen mit '#' sind Kommentare. Messreihen eines Sensors und
+ * Ausfallzeiten des WLANs können so in getrennten Dateien stehen.
+ *
+ **/
+class Scenario
+{
+private:
+    std::vector<ScenarioEvent> events;
+    size_t next = 0;
+
+    static float *field(const std::string &name)
+    {
+        NativeEnvironment &env = nativeEnvironment;
+        if (name == "temperature") return &env.temperature;
+        if (name == "humidity") return &env.humidity;
+        if (name == "pressure") return &env.pressure;
+        if (name == "lux") return &env.lux;
+        if (name == "uv") return &env.uv;
+        if (name == "pm25") return &env.pm25;
+        if (name == "pm10") return &env.pm10;
+        return NULL;
+    }
+
+public:
+    /**
+     *
+     * Liest eine Szenario Datei, false bei einem Fehler.
+     *
+     **/
+    bool load(const char *path)
+    {
+        FILE *file = fopen(path, "r");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Cannot open scenario %s\n", path);
+            return false;
+        }
+
+        char line[128];
+        unsigned int number = 0;
+        while (fgets(line, sizeof(line), file) != NULL)
+        {
+            number++;
+            double seconds;
+            char name[32], value[32];
+            if (line[0] == '#' || sscanf(line, "%lf %31s %31s", &seconds, name, value) != 3)
+            {
+                continue;
+            }
+
+            ScenarioEvent event;
+            event.time = seconds * 1000;
+            event.name = name;
+            if (event.name == "wifi")
+            {
+                event.value = strcmp(value, "on") == 0 ? 1 : 0;
+            }
+            else if (event.name == "button" || event.name == "rssi" || event.name == "jointime" ||
+                     event.name == "reject" || event.name == "status")
+            {
+                event.value = atoi(value);
+            }
+            else if (field(event.name) != NULL)
+            {
+                event.value = strcmp(value, "auto") == 0 ? NAN : atof(value);
+            }
+            else
+            {
+                fprintf(stderr, "%s:%u: unknown quantity '%s'\n", path, number, name);
+                fclose(file);
+                return false;
+            }
+            events.push_back(event);
+        }
+        fclose(file);
+
+        // Stabile Sortierung, Ereignisse zur gleichen Zeit behalten ihre Reihenfolge
+        for (size_t i = 1; i < events.size(); i++)
+        {
+            for (size_t j = i; j > 0 && events[j].time < events[j - 1].time; j--)
+            {
+                std::swap(events[j], events[j - 1]);
+            }
+        }
+        return true;
+    }
+
+    // Zeitpunkt des nächsten Ereignisses, 0xFFFFFFFF wenn keines mehr folgt
+    unsigned long nextTime() const
+    {
+        return next < events.size() ? events[next].time : 0xFFFFFFFF;
+    }
+
+    /**
+     *
+     * Führt alle Ereignisse bis zum Zeitpunkt 'now' aus und ruft für jedes
+     * 'log' mit einer Beschreibung auf.
+     *
+     **/
+    void apply(unsigned long now, void (*log)(const char *))
+    {
+        while (next < events.size() && events[next].time <= now)
+        {
+            const ScenarioEvent &event = events[next++];
+            char text[64];
+            if (event.name == "wifi")
+            {
+                nativeNetwork.online = event.value != 0;
+                snprintf(text, sizeof(text), "scenario wifi %s", nativeNetwork.online ? "on" : "off");
+            }
+            else if (event.name == "button")
+            {
+                bool attached = nativeInterrupt((int)event.value);
+                snprintf(text, sizeof(text), "scenario button %d%s", (int)event.value, attached ? "" : " (no interrupt)");
+            }
+            else if (event.name == "rssi" || event.name == "jointime" || event.name == "reject" ||
+                     event.name == "status")
+            {
+                if (event.name == "rssi")
+                {
+                    nativeNetwork.rssi = event.value;
+                }
+                else if (event.name == "jointime")
+                {
+                    nativeNetwork.joinTime = event.value;
+                }
+                else if (event.name == "status")
+                {
+                    nativeNetwork.postStatus = event.value;
+                }
+                else
+                {
+                    nativeNetwork.rejectJoins = event.value;
+                }
+                snprintf(text, sizeof(text), "scenario %s %d", event.name.c_str(), (int)event.value);
+            }
+            else if (isnan(event.value))
+            {
+                *field(event.name) = event.value;
+                snprintf(text, sizeof(text), "scenario %s auto", event.name.c_str());
+            }
+            else
+            {
+                *field(event.name) = event.value;
+                snprintf(text, sizeof(text), "scenario %s %.2f", event.name.c_str(), event.value);
+            }
+            log(text);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef __NATIVE_SENSEBOXIO_H_INC__
+#define __NATIVE_SENSEBOXIO_H_INC__
+
+class SenseBoxIO
+{
+public:
+    void SPIselectXB1() {}
+    void SPIselectXB2() {}
+    void powerXB1(bool on) {}
+    void powerXB2(bool on) {}
+    void powerI2C(bool on) {}
+    void powerAll() {}
+};
+
+extern SenseBoxIO senseBoxIO;
+
+#endif
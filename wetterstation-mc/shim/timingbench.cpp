@@ -0,0 +1,80 @@
+/*
+    Zeitmodell einer Messung der I2C Sensoren (sensors.cpp) für '-t'.
+*/
+
+#include <Arduino.h>
+#include "native.h"
+
+#include "config.h"
+#include "sensors.cpp"
+
+/**
+ *
+ * Zeitmodell einer Messung aller I2C Sensoren mit der Busdauer aus Wire.h
+ * und den Wandlungszeiten der Treiber. Verglichen werden die bisherige
+ * Abfrage über die Bibliotheken (inklusive der festen Wartezeit beim
+ * HDC1080), das Lesen nacheinander mit Warten ('readAll') und die
+ * überlappende Messung ('poll'), bei der nur die Busdauer blockiert.
+ *
+ **/
+int timingModel()
+{
+    typedef SensorRegistry<Bmp280Driver, Hdc1080Driver, Tsl45315Driver, Veml6070Driver> AllSensors;
+    static AllSensors sensors;
+    Measurment data;
+
+    Adafruit_BMP280 bmp;
+    Adafruit_HDC1000 hdc;
+    Makerblog_TSL45315 tsl(TSL45315_TIME_M4);
+    VEML6070 veml;
+
+    unsigned long long start = micros();
+    data.Temperature = bmp.readTemperature();
+    data.Pressure = bmp.readPressure() / 100;
+    data.Altitute = bmp.readAltitude(1013.25);
+    data.Hdc1080Temperature = hdc.readTemperature();
+    delay(200);
+    data.Humidity = hdc.readHumidity();
+    data.Lux = tsl.readLux();
+    data.UV = veml.getUV();
+    unsigned long long before = micros() - start;
+
+    sensors.begin(millis());
+    delay(1000);
+    start = micros();
+    sensors.readAll(data);
+    unsigned long long serial = micros() - start;
+    unsigned long earlyReads = hdc1080.earlyReads;
+
+    // Neuer Start, nach den Startzeiten sind alle Sensoren gleichzeitig fällig.
+    // 'poll' startet die Messungen und wird erneut aufgerufen wenn die
+    // letzte Wandlung abgeschlossen ist.
+    sensors.begin(millis());
+    delay(1000);
+    unsigned long long busy = 0;
+    unsigned long long latency = 0;
+    unsigned long calls = 0;
+    const uint16_t all = (1 << FIELD_TEMPERATURE) | (1 << FIELD_PRESSURE) | (1 << FIELD_ALTITUDE) |
+                         (1 << FIELD_HUMIDITY) | (1 << FIELD_HDC1080_TEMPERATURE) | (1 << FIELD_LUX) |
+                         (1 << FIELD_UV);
+    start = micros();
+    data.valid = 0;
+    while (data.valid != all)
+    {
+        unsigned long long callStart = micros();
+        unsigned long wait = sensors.poll(data, millis());
+        busy += micros() - callStart;
+        latency = micros() - start;
+        calls++;
+        nativeAdvance(wait * 1000ULL);
+    }
+    earlyReads = hdc1080.earlyReads - earlyReads;
+
+    printf("Sensor cycle (BMP280, HDC1080, TSL45315, VEML6070 at 100 kHz):\n");
+    printf("  library (before): busy %7.2f ms\n", before / 1000.0);
+    printf("  serial readAll:   busy %7.2f ms\n", serial / 1000.0);
+    printf("  pipelined poll:   busy %7.2f ms in %lu calls, all results after %.2f ms\n",
+           busy / 1000.0, calls, latency / 1000.0);
+    printf("HDC1080 early reads: %lu\n", earlyReads);
+    return earlyReads == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+    Wiedergabe der Szenarien ohne Firmware für '-a', vergleicht das
+    adaptive Sendeintervall (uploadpolicy.cpp) mit dem festen.
+*/
+
+#include <Arduino.h>
+#include <WiFi101.h>
+#include "native.h"
+
+#include "config.h"
+#include "sensors.cpp"
+#include "uploadpolicy.cpp"
+
+/**
+ *
+ * Stand der openSenseMap bei einer Sende Strategie für '-a': ab der ersten
+ * Änderung über dem Schwellwert gegenüber dem zuletzt gesendeten Wert bis
+ * zum nächsten Post zählt die Verzögerung ('lag').
+ *
+ **/
+struct ReplayServer
+{
+    Measurment shown;
+    unsigned long posts = 0;
+    unsigned long changes = 0;
+    unsigned long maxLag = 0;
+    unsigned long long totalLag = 0;
+    unsigned long millisStale = 0;
+    bool stale = false;
+
+    void tick(const Measurment &data, uint16_t fields, unsigned long now, bool post)
+    {
+        if (!stale && UploadPolicy::changed(data, shown, fields) >= 0)
+        {
+            stale = true;
+            millisStale = now;
+        }
+        if (!post)
+        {
+            return;
+        }
+        if (stale)
+        {
+            unsigned long lag = now - millisStale;
+            maxLag = lag > maxLag ? lag : maxLag;
+            totalLag += lag;
+            changes++;
+            stale = false;
+        }
+        shown = data;
+        posts++;
+    }
+
+    void print(const char *name)
+    {
+        printf("%-10s %7lu %9lu %11.1f %11.1f\n", name, posts, changes,
+               changes > 0 ? totalLag / 1000.0 / changes : 0.0, maxLag / 1000.0);
+    }
+};
+
+void replayLog(const char *text) {}
+
+/**
+ *
+ * Wiedergabe für '-a': im Intervall 'UPLOAD_CHECK_INTERVAL' werden die
+ * Werte der Umgebung (Tagesgang bzw. Szenarien) wie von den Treibern in
+ * eine Messung übernommen und von 'UploadPolicy' bewertet, zum Vergleich
+ * wird fest im Intervall 'OSM_REFRESH_INTERVAL' gesendet. Die Signalstärke
+ * kommt aus dem Szenario ('rssi'), die Dauer der Posts bleibt unberücksichtigt.
+ *
+ **/
+int replayUploads(unsigned long seconds)
+{
+    const uint16_t fields = uploadedFields<Sensors>();
+    UploadPolicy policy;
+    ReplayServer fixed, adaptive;
+    policy.begin(fields, millis());
+
+    unsigned long end = seconds * 1000;
+    for (unsigned long now = UPLOAD_CHECK_INTERVAL; now <= end; now += UPLOAD_CHECK_INTERVAL)
+    {
+        nativeAdvance((now - millis()) * 1000ULL);
+        scenario.apply(now, replayLog);
+
+        Measurment data;
+        data.Temperature = nativeEnvironment.getTemperature();
+        data.Pressure = nativeEnvironment.getPressure() / 100;
+        data.Humidity = nativeEnvironment.getHumidity();
+        data.Lux = nativeEnvironment.getLux();
+        data.UV = nativeEnvironment.getUv();
+        data.pm25 = nativeEnvironment.getPm25();
+        data.pm10 = nativeEnvironment.getPm10();
+        data.valid = (1 << FIELD_TEMPERATURE) | (1 << FIELD_PRESSURE) | (1 << FIELD_HUMIDITY) |
+                     (1 << FIELD_LUX) | (1 << FIELD_UV) | (1 << FIELD_PM25) | (1 << FIELD_PM10);
+
+        policy.link(nativeNetwork.rssi, 0);
+        adaptive.tick(data, fields, now, policy.check(data, now) != UPLOAD_WAIT);
+        fixed.tick(data, fields, now, now % (unsigned long)OSM_REFRESH_INTERVAL == 0);
+    }
+
+    printf("Replayed %lu s, uploaded fields 0x%03x\n", seconds, fields);
+    printf("%-10s %7s %9s %11s %11s\n", "policy", "posts", "changes", "avg lag s", "max lag s");
+    fixed.print("fixed");
+    adaptive.print("adaptive");
+    printf("Posts saved:      %lu (%.1f %%)\n", fixed.posts - adaptive.posts,
+           fixed.posts > 0 ? 100.0 * ((double)fixed.posts - adaptive.posts) / fixed.posts : 0.0);
+    printf("\n");
+    Serial.echo = true;
+    policy.report(Serial);
+    return 0;
+}
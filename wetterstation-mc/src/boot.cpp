@@ -0,0 +1,231 @@
+#include <Arduino.h>
+#include "config.h"
+
+#ifndef __BOOT_H_INC__
+#define __BOOT_H_INC__
+
+#define BOOT_MAX_STAGES 8
+
+// Bitmaske der Schritte auf die ein Schritt warten muss (siehe 'BootSequencer::add')
+#define BOOT_AFTER(stage) (1 << (stage))
+
+#ifdef ARDUINO
+// Wird beim Start nicht gelöscht und überlebt so einen Reset (nicht das Ausschalten)
+#define BOOT_NOINIT __attribute__((section(".noinit")))
+#else
+#define BOOT_NOINIT
+#endif
+
+#define WIFI_CACHE_MAGIC 0x57534331UL
+
+/**
+ *
+ * Merkt sich im RAM über einen Reset hinweg mit welchem Netzwerk (SSID)
+ * und Access Point (BSSID) die letzte Verbindung zustande kam. Kanal und
+ * BSSID selbst speichert das WiFi Modul in seinem Verbindungsprofil, die
+ * WiFi101 Bibliothek kann sie nur über 'WiFi.begin()' ohne Parameter
+ * nutzen. Der Eintrag hier sagt ob dieses Profil zum konfigurierten
+ * Netzwerk gehört und zuletzt funktioniert hat, dann wird ohne Suche
+ * über alle Kanäle verbunden.
+ *
+ * Nur Member ohne Initialisierung, sonst würde der Inhalt beim Start
+ * überschrieben. Nach dem Einschalten ist er zufällig, daher die Prüfsumme.
+ *
+ **/
+class WifiCache
+{
+private:
+    uint32_t magic;
+    uint32_t ssidHash;
+    uint8_t bssid[6];
+    uint16_t joins;
+    uint32_t check;
+
+    // FNV-1a
+    static uint32_t hash(const char *text)
+    {
+        uint32_t value = 2166136261UL;
+        while (*text != '\0')
+        {
+            value = (value ^ (uint8_t)*text++) * 16777619UL;
+        }
+        return value;
+    }
+
+    uint32_t checksum()
+    {
+        uint32_t value = magic ^ ssidHash ^ joins;
+        for (uint8_t i = 0; i < 6; i++)
+        {
+            value = (value ^ bssid[i]) * 16777619UL;
+        }
+        return value;
+    }
+
+public:
+    /**
+     *
+     * true wenn die letzte Verbindung vor dem Reset mit 'ssid' bestand.
+     *
+     **/
+    bool matches(const char *ssid)
+    {
+        return magic == WIFI_CACHE_MAGIC && check == checksum() && ssidHash == hash(ssid);
+    }
+
+    void remember(const char *ssid, const uint8_t *bssid)
+    {
+        if (!matches(ssid))
+        {
+            joins = 0;
+        }
+        magic = WIFI_CACHE_MAGIC;
+        ssidHash = hash(ssid);
+        memcpy(this->bssid, bssid, 6);
+        joins++;
+        check = checksum();
+    }
+
+    void forget()
+    {
+        magic = 0;
+    }
+
+    const uint8_t *getBssid() { return bssid; }
+
+    // Verbindungen mit diesem Access Point seit dem Einschalten
+    uint16_t getJoins() { return joins; }
+};
+
+/**
+ *
+ * Einzige Instanz, auch über mehrere Übersetzungseinheiten.
+ *
+ **/
+inline WifiCache &wifiCache()
+{
+    static WifiCache instance BOOT_NOINIT;
+    return instance;
+}
+
+/**
+ *
+ * Ein Schritt des Starts. 'step' wird bis zur Bereitschaft wiederholt
+ * aufgerufen und gibt dann true zurück, 'elapsed' ist die Zeit seit dem
+ * ersten Aufruf (dort 0, der Schritt beginnt dann seine Arbeit).
+ *
+ **/
+typedef bool (*BootStep)(unsigned long elapsed);
+
+typedef struct bootStage
+{
+    const char *name;
+    BootStep step;
+    uint8_t after;
+    bool started;
+    unsigned long millisStart;
+    unsigned long millisReady;
+} bootStage;
+
+/**
+ *
+ * Führt die Schritte von setup() nebeneinander aus: jeder Schritt beginnt
+ * sobald die Schritte in 'after' bereit sind und wartet nicht blockierend,
+ * so überlappen z.B. das Verbinden mit dem WLAN und die erste Messung.
+ * Die Zeiten jedes Schritts bleiben für 'report' erhalten.
+ *
+ **/
+class BootSequencer
+{
+private:
+    bootStage stages[BOOT_MAX_STAGES];
+    uint8_t count = 0;
+    uint8_t ready = 0;
+    unsigned long millisBegin = 0;
+    unsigned long millisDone = 0;
+
+    uint8_t all() { return (uint8_t)((1 << count) - 1); }
+
+public:
+    /**
+     *
+     * Fügt einen Schritt hinzu, Rückgabewert ist seine Nummer für
+     * 'BOOT_AFTER'. Abhängigkeiten können nur auf frühere Schritte zeigen.
+     *
+     **/
+    int8_t add(const char *name, BootStep step, uint8_t after = 0)
+    {
+        if (count >= BOOT_MAX_STAGES)
+        {
+            return -1;
+        }
+        bootStage &stage = stages[count];
+        stage.name = name;
+        stage.step = step;
+        stage.after = after & all();
+        stage.started = false;
+        return count++;
+    }
+
+    /**
+     *
+     * Führt alle Schritte aus bis jeder bereit ist.
+     *
+     **/
+    void run()
+    {
+        millisBegin = millis();
+        while (ready != all())
+        {
+            for (uint8_t i = 0; i < count; i++)
+            {
+                bootStage &stage = stages[i];
+                if ((ready & BOOT_AFTER(i)) || (ready & stage.after) != stage.after)
+                {
+                    continue;
+                }
+                if (!stage.started)
+                {
+                    stage.started = true;
+                    stage.millisStart = millis();
+                }
+                if (stage.step(millis() - stage.millisStart))
+                {
+                    stage.millisReady = millis();
+                    ready |= BOOT_AFTER(i);
+                }
+            }
+            if (ready != all())
+            {
+                delay(BOOT_POLL_INTERVAL);
+            }
+        }
+        millisDone = millis();
+    }
+
+    unsigned long duration() { return millisDone - millisBegin; }
+
+    /**
+     *
+     * Gibt Beginn und Bereitschaft jedes Schritts in ms ab dem Start aus.
+     *
+     **/
+    void report(Print &out)
+    {
+        out.println(F("[Boot] Timeline (start - ready ms):"));
+        for (uint8_t i = 0; i < count; i++)
+        {
+            out.print(F("  "));
+            out.print(stages[i].name);
+            out.print(F(": "));
+            out.print(stages[i].millisStart - millisBegin);
+            out.print(F(" - "));
+            out.println(stages[i].millisReady - millisBegin);
+        }
+        out.print(F("[Boot] Total: "));
+        out.print(duration());
+        out.println(F(" ms"));
+    }
+};
+
+#endif
@@ -17,37 +17,174 @@
 #define SERVER_ADDRESS "ingress.opensensemap.org"
 #define SENSEBOX_ID "5cf8c8fa07460b001b4dccad"
 #define OSM_REFRESH_INTERVAL 60e3
+// Abfrageintervall des WiFi Clients (Antworten des Servers)
+#define NETWORK_POLL_INTERVAL 100
+// Größe des Sendefensters für Webrequests, entspricht der maximalen
+// Paketgröße eines Sockets im WINC1500 (SOCKET_BUFFER_MAX_LENGTH)
+#define UPLOAD_WINDOW_SIZE 1400
+// Wartezeit auf die Antwort des Servers und Grenzen der Wartezeit
+// zwischen zwei fehlgeschlagenen Verbindungsversuchen
+#define HTTP_RESPONSE_TIMEOUT 10e3
+#define HTTP_LINE_SIZE 64
+// Höchstens gelesene Zahlen im Body einer Antwort (Windrad)
+#define HTTP_BODY_FIELDS 4
+#define OSM_BACKOFF_MIN 5e3
+#define OSM_BACKOFF_MAX 600e3
+// Ringpuffer für Messungen ohne Verbindung, ein Eintrag je OSM_REFRESH_INTERVAL
+// (4 + 4 * NUM_SENSORS + 4 Bytes), 360 Einträge entsprechen 6 Stunden.
+// Nachgeholt werden höchstens OSM_BACKFILL_BATCH Einträge pro Request.
+#define OFFLINE_BUFFER_SIZE 360
+#define OSM_BACKFILL_BATCH 20
+// Format des Bodys (encoding.cpp): ohne Auswahl CSV ohne Auffüllen,
+// OSM_PAYLOAD_CSV_PADDED das bisherige CSV mit "%9.2f", OSM_PAYLOAD_JSON
+// ein JSON Objekt mit jeder Sensor ID einmal (ein Messzyklus pro Request).
+//#define OSM_PAYLOAD_CSV_PADDED
+//#define OSM_PAYLOAD_JSON
+#define OSM_TIME_SYNC_INTERVAL 3600e3
+// WLAN Verbindung (wifilink.cpp): ein Verbindungsversuch gilt nach
+// WIFI_JOIN_TIMEOUT als gescheitert, mit dem gespeicherten Profil des WiFi
+// Moduls (Kanal und BSSID, siehe boot.cpp) nach WIFI_FAST_JOIN_TIMEOUT.
+// Danach wird mit zufällig gestreuter, exponentiell steigender Wartezeit
+// (WIFI_BACKOFF_MIN bis WIFI_BACKOFF_MAX) erneut verbunden. Die
+// Signalstärke wird im Intervall WIFI_RSSI_INTERVAL gelesen.
+#define WIFI_JOIN_TIMEOUT 15e3
+#define WIFI_FAST_JOIN_TIMEOUT 3e3
+#define WIFI_BACKOFF_MIN 2e3
+#define WIFI_BACKOFF_MAX 300e3
+#define WIFI_RSSI_INTERVAL 30e3
+// Adaptives Sendeintervall (uploadpolicy.cpp): statt fest im Intervall
+// OSM_REFRESH_INTERVAL wird im Intervall UPLOAD_CHECK_INTERVAL geprüft ob
+// gesendet werden soll. Ändert sich ein Messwert seit dem letzten Post um
+// seinen Schwellwert, wird nach frühestens UPLOAD_INTERVAL_MIN gesendet,
+// sonst verdoppelt sich das Intervall bis UPLOAD_INTERVAL_MAX. Bei einer
+// Signalstärke unter UPLOAD_RSSI_WEAK (dBm) bzw. Antworten langsamer als
+// UPLOAD_LATENCY_SLOW (ms) verdoppeln sich beide Intervalle jeweils.
+//#define ADAPTIVE_UPLOAD
+#define UPLOAD_CHECK_INTERVAL 10e3
+#define UPLOAD_INTERVAL_MIN 20e3
+#define UPLOAD_INTERVAL_MAX 900e3
+#define UPLOAD_RSSI_WEAK -80
+#define UPLOAD_LATENCY_SLOW 3000
+// Schwellwerte in Hundertstel der Einheit (0 = ignorieren): 0.5 °C, 0.5 hPa,
+// 3 %, 10000 lx, 50 µW/cm², 2 m/s, 45° und 5 µg/m³ (PM2.5 und PM10)
+#define UPLOAD_DELTA_TEMPERATURE 50
+#define UPLOAD_DELTA_PRESSURE 50
+#define UPLOAD_DELTA_HUMIDITY 300
+#define UPLOAD_DELTA_LUX 1000000
+#define UPLOAD_DELTA_UV 5000
+#define UPLOAD_DELTA_WINDSPEED 200
+#define UPLOAD_DELTA_WINDDIRECTION 4500
+#define UPLOAD_DELTA_PM 500
+
+// Gateway für mehrere Stationen (gateway.cpp): Stationen mit GATEWAY_IPADDR
+// senden ihre Messungen als binäre Frames per UDP an das Gateway statt selbst
+// an die openSenseMap. Das Gateway (GATEWAY_MODE) sammelt sie je senseBox und
+// sendet sie gebündelt über seine bestehende Sitzung, sobald
+// GATEWAY_BATCH_READINGS Messungen warten oder die älteste GATEWAY_BATCH_DELAY
+// alt ist. Je Station werden GATEWAY_BOX_QUEUE Messungen zu 20 Bytes
+// gepuffert, ggf. OFFLINE_BUFFER_SIZE verkleinern.
+//#define GATEWAY_MODE
+//#define GATEWAY_IPADDR 192, 168, 43, 10
+#define GATEWAY_PORT 4210
+// Kann für Tests (platformio.ini) überschrieben werden
+#ifndef GATEWAY_MAX_BOXES
+#define GATEWAY_MAX_BOXES 8
+#endif
+#define GATEWAY_BOX_QUEUE 30
+#define GATEWAY_BATCH_READINGS 24
+#define GATEWAY_BATCH_DELAY 300e3
 
 // Sensors
-#define NUM_SENSORS 6
-#define SENSOR_REFRESH_INTERVAL 10e3;
+// Die Anzahl der gesendeten Messungen (NUM_SENSORS) ergibt sich aus den
+// aktivierten Sensoren und ihren IDs, siehe sensors.cpp
+// Abfrage des Windrads, die übrigen Sensoren haben eigene Abtastraten.
+// Bis zum nächsten Postrequest werden alle Messungen gemittelt.
+#define SENSOR_REFRESH_INTERVAL 10e3
+// Filter zwischen Sensor und Messwert (filter.cpp), je Kanal: Stufen
+// (FILTER_HAMPEL ersetzt Ausreißer über FILTER_HAMPEL_K mal der Streuung
+// durch den Median der letzten FILTER_WINDOW Messungen, FILTER_MEDIAN gibt
+// immer den Median weiter, FILTER_RATE begrenzt die Änderung pro Sekunde),
+// kleinste Abweichung welche als Ausreißer gilt und größte Änderung pro
+// Sekunde, beides in Hundertstel der Einheit. FILTER_HAMPEL_K ebenso.
+// Optional zuletzt ein Anteil des Medians in Prozent, welcher zur kleinsten
+// Abweichung hinzukommt: Licht und UV ändern sich mit Wolken zwischen zwei
+// Messungen um ein Vielfaches, solche Sprünge sind keine Ausreißer.
+#define FILTER_WINDOW 5
+#define FILTER_HAMPEL_K 300
+#define FILTER_TEMPERATURE FILTER_HAMPEL | FILTER_RATE, 30, 20 // 0.3 °C, 0.2 °C/s
+#define FILTER_PRESSURE FILTER_HAMPEL | FILTER_RATE, 10, 50    // 0.1 hPa, 0.5 hPa/s
+#define FILTER_HUMIDITY FILTER_HAMPEL | FILTER_RATE, 100, 200  // 1 %, 2 %/s
+#define FILTER_LUX FILTER_HAMPEL, 5000, 0, 200                 // 50 lx + 200 %
+#define FILTER_UV FILTER_HAMPEL, 500, 0, 200                   // 5 µW/cm² + 200 %
 
 #define BMP280_CONNECTED
 #define TEMPERATURE_ID "5d055d2483fbe0001aaa185d"
 #define PRESSURE_ID "5cf8c8fa07460b001b4dccae"
 //#define ALTITUDE_ID   ""
+#define BMP280_SAMPLE_INTERVAL 1e3
+// Bezugsdruck der Höhe (hPa) und Höhe der Station über dem Meer (m) für den
+// auf Meereshöhe reduzierten Luftdruck
+#define ALTITUDE_P0 1013.25
+#define STATION_ALTITUDE 107
+
+// Abgeleitete Werte (derived.cpp), mit jeder Messung berechnet: Luftdruck
+// auf Meereshöhe, Taupunkt (nur mit HDC1080), Änderung des Luftdrucks in
+// 3 Stunden aus Mittelwerten über DERIVED_TENDENCY_SLOT und Luftqualitäts-
+// index (US EPA) aus PM2.5 und PM10. Gesendet wird nur mit ID.
+#define DERIVED_TENDENCY_SLOT 600e3
+//#define SEA_LEVEL_PRESSURE_ID ""
+//#define DEW_POINT_ID ""
+//#define PRESSURE_TENDENCY_ID ""
+//#define AQI_ID ""
 
 //#define HDC1080_CONNECTED
-//#define TEMPERATURE_ID  ""
+//#define HDC1080_TEMPERATURE_ID  ""
 //#define HUMIDITY_ID     ""
+#define HDC1080_SAMPLE_INTERVAL 10e3
 
 #define TSL45315_CONNECTED
 #define ILLUMINANCE_ID "5d553f70953683001a0e12ea"
+#define TSL45315_SAMPLE_INTERVAL 5e3
 
 #define VEML6070_CONNECTED
 #define UV_RADIATION_ID "5d553f9f953683001a0e1fa2"
+#define VEML6070_SAMPLE_INTERVAL 5e3
 
 //#define WINDRAD_CONNECTED
 //#define WINDRAD_SPEED_ID "5dcadb76306947001ae4cfe7"
 //#define WINDRAD_DIRECTION_ID "5dcadb76306947001ae4cfe6"
+// Position der Werte in der Antwort des Windrads, z.B. "3.2,270,9.5,15.1"
+#define WINDRAD_SPEED_FIELD 0
+#define WINDRAD_DIRECTION_FIELD 1
+#define WINDRAD_PM25_FIELD 2
+#define WINDRAD_PM10_FIELD 3
 
 #define PM_CONNECTED
 #define PM_PM25_ID "6077e1c15795a3001b3a4149"
 #define PM_PM10_ID "6077e1c15795a3001b3a414a"
 #define PM_UART (Serial1)
+// Messzyklus: Aufwecken, Aufwärmen, Messungen abfragen, Schlafen. Lüfter und
+// Laser laufen etwa 38 s je Zyklus, bei 5 Minuten sind das 13 % der Zeit
+#define PM_REFRESH_INTERVAL 300e3
+#define PM_WARMUP_TIME 30e3
+#define PM_SAMPLES 5
+#define PM_SAMPLE_INTERVAL 2e3
+#define PM_POLL_INTERVAL 100
 //#define PM_IPADDR 192, 168, 43, 122
 //#define PM_PORT 80
 
+// Messdaten Log auf der SD Karte (SD Bee auf XBEE2)
+//#define SD_CONNECTED
+#define SD_CS_PIN 28
+#define LOG_FILE_NAME "WSLOG.BIN"
+// Blockgröße entspricht einem Sektor der SD Karte,
+// 8192 Blöcke (4 MB) fassen mit 6 Sensoren über 100000 Einträge
+#define LOG_BLOCK_SIZE 512
+#define LOG_CAPACITY_BLOCKS 8192
+// Einträge vor der ersten Synchronisation der Uhrzeit warten im RAM
+// auf ihren Zeitstempel (4 + 8 + 4 * NUM_SENSORS Bytes je Eintrag)
+#define LOG_PENDING_RECORDS 30
+
 // Display
 #define SSD1306_CONNECTED
 
@@ -55,10 +192,75 @@
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define SCREEN_RESET 0
+#define SCREEN_ADDRESS 0x3D
 
 #define SCREEN_REFRESH_INTERVAL 10e3
+#define SCREEN_STANDBY_TIME 30e3
+#define SCREEN_STANDBY_CHECK_INTERVAL 1e3
 #endif
 
+// Taster für den Seitenwechsel, der Interrupt legt nur ein Ereignis ab
+// (eventqueue.cpp), entprellt wird in der Hauptschleife über den Zeitstempel.
+#define BUTTON_PIN 0
+#define BUTTON_DEBOUNCE_TIME 15
+// Zweierpotenz, ein Platz bleibt frei
+#define INPUT_EVENT_QUEUE_SIZE 8
+
+// Laufzeitmessung der Programmteile und der Hauptschleife (profiler.cpp),
+// der Bericht wird im Intervall PROFILE_REPORT_INTERVAL auf Serial ausgegeben.
+// Optional werden die längste Schleife (ms) und die Auslastung (%) gesendet.
+//#define ENABLE_PROFILING
+#define PROFILE_REPORT_INTERVAL 3600e3
+//#define PROFILE_LOOP_ID ""
+//#define PROFILE_BUSY_ID ""
+
+// Start (boot.cpp): die Schritte in setup() laufen nebeneinander und warten
+// nur auf ihre Bereitschaft. Mit ENABLE_DEBUG wird bis BOOT_SERIAL_TIMEOUT
+// auf den seriellen Monitor gewartet. BOOT_POWER_CYCLE_TIME ist die Zeit
+// ohne Versorgung für XB1 und I2C, BOOT_I2C_POWER_UP die längste Anlaufzeit
+// der I2C Sensoren laut Datenblatt (HDC1080 15 ms). Das Display wird bis
+// BOOT_I2C_TIMEOUT abgefragt bis es antwortet.
+#define BOOT_POLL_INTERVAL 1
+#define BOOT_SERIAL_TIMEOUT 5e3
+#define BOOT_POWER_CYCLE_TIME 200
+#define BOOT_I2C_POWER_UP 20
+#define BOOT_I2C_TIMEOUT 500
+
+// Stromsparbetrieb (power.cpp): die MCU schläft zwischen den Aufgaben
+// (Standby bis zum RTC Alarm oder Taster, bei Wartezeiten unter
+// POWER_STANDBY_MIN nur bis zum nächsten SysTick), das WiFi Modul nutzt
+// seinen Stromsparmodus und die Netzwerk Abfrage läuft ohne offenen Request
+// nur im Intervall POWER_IDLE_POLL_INTERVAL. Mit LOW_POWER_RADIO_OFF wird das
+// WiFi Modul zwischen den Postrequests ausgeschaltet (XB1), lohnt sich aber
+// erst bei langen Intervallen (Verbindung und TLS Handshake bei jedem Post).
+//#define LOW_POWER_MODE
+//#define LOW_POWER_RADIO_OFF
+#define POWER_STANDBY_MIN 10
+#define POWER_IDLE_POLL_INTERVAL 5e3
+// Energiemodell, typische Ströme laut Datenblättern in µA
+#define POWER_BASE_UA 400UL
+#define POWER_MCU_ACTIVE_UA 6000UL
+#define POWER_MCU_IDLE_UA 2500UL
+#define POWER_MCU_STANDBY_UA 10UL
+#define POWER_RADIO_LISTEN_UA 60000UL
+#define POWER_RADIO_SAVE_UA 1500UL
+#define POWER_RADIO_ACTIVE_UA 110000UL
+#define POWER_DISPLAY_ON_UA 10000UL
+#define POWER_DISPLAY_OFF_UA 10UL
+// Dauer der Vorgänge des WiFi Moduls in ms (Verbinden mit Suche über alle
+// Kanäle bzw. mit gespeichertem Profil), Datenrate in Bytes pro ms
+#define POWER_RADIO_JOIN_TIME 2000
+#define POWER_RADIO_FAST_JOIN_TIME 500
+#define POWER_RADIO_HANDSHAKE_TIME 1500
+#define POWER_RADIO_REQUEST_TIME 150
+#define POWER_RADIO_BYTES_PER_MS 50
+#define POWER_BATTERY_MAH 2000
+
+// Scheduler
+// Maximale Anzahl an gleichzeitig registrierten Aufgaben, setup() braucht
+// mit Windrad, PM Sensor, Profiling und Display alle 8 (SETUP_TASKS in main.cpp)
+#define SCHEDULER_MAX_TASKS 8
+
 // BKB Logo
 #define BKB_LOGO                                                                                            \
     {                                                                                                       \
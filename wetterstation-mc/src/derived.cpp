@@ -0,0 +1,213 @@
+#include <Arduino.h>
+#include <math.h>
+#include "config.h"
+
+#include "measurement.h"
+
+#ifndef __DERIVED_H_INC__
+#define __DERIVED_H_INC__
+
+// Vergleichswerte der Luftdrucktendenz: die letzten 3 Stunden in Abschnitten
+// von DERIVED_TENDENCY_SLOT, dazu der Abschnitt vor 3 Stunden
+#define DERIVED_TENDENCY_SLOTS ((uint8_t)(3 * 3600e3 / DERIVED_TENDENCY_SLOT) + 1)
+
+/**
+ *
+ * Abschnitt des Luftqualitätsindex: Konzentrationen in Zehntel µg/m³ und
+ * Index an Anfang und Ende.
+ *
+ **/
+typedef struct aqiBreakpoint
+{
+    uint16_t concentrationLow;
+    uint16_t concentrationHigh;
+    uint16_t indexLow;
+    uint16_t indexHigh;
+} aqiBreakpoint;
+
+/**
+ *
+ * Aus den Messungen abgeleitete Werte, fortlaufend bei jeder Messung
+ * berechnet: auf Meereshöhe reduzierter Luftdruck, Taupunkt (nur mit
+ * Feuchte, HDC1080), Luftdrucktendenz über 3 Stunden und Luftqualitätsindex
+ * aus dem Feinstaub. Die Formeln sind einzeln aufrufbar, 'update' schreibt
+ * alle in 'Measurment' und markiert sie gültig sobald ihre Eingaben es sind.
+ *
+ **/
+class DerivedMetrics
+{
+private:
+    // Mittelwerte der abgeschlossenen Abschnitte in Hundertstel hPa (Ring)
+    int32_t slots[DERIVED_TENDENCY_SLOTS];
+    uint8_t slotIndex = 0;
+    uint8_t slotCount = 0;
+
+    // Laufender Abschnitt
+    int32_t slotSum = 0;
+    uint16_t slotSamples = 0;
+    unsigned long millisSlot = 0;
+    bool started = false;
+
+    // Lineare Interpolation im Abschnitt von 'concentration', gerundet
+    static uint16_t interpolate(const aqiBreakpoint *table, uint8_t size, uint16_t concentration)
+    {
+        for (uint8_t i = 0; i < size; i++)
+        {
+            const aqiBreakpoint &b = table[i];
+            if (concentration <= b.concentrationHigh)
+            {
+                uint32_t span = b.concentrationHigh - b.concentrationLow;
+                uint32_t offset = concentration > b.concentrationLow ? concentration - b.concentrationLow : 0;
+                return b.indexLow + ((b.indexHigh - b.indexLow) * offset * 2 + span) / (2 * span);
+            }
+        }
+        return table[size - 1].indexHigh;
+    }
+
+public:
+    /**
+     *
+     * Reduziert den Luftdruck 'pressure' (Hundertstel hPa) der Station auf
+     * Meereshöhe, barometrische Höhenformel mit der Mitteltemperatur der
+     * Luftsäule aus 'temperature' (°C) und dem Temperaturgradienten
+     * 0.65 K / 100 m. Die Exponentialfunktion wird für die kleinen Exponenten
+     * (unter 0.15 bis 1200 m) als Reihe bis zur vierten Ordnung berechnet.
+     *
+     **/
+    static int32_t seaLevelPressure(int32_t pressure, float temperature, float altitude = STATION_ALTITUDE)
+    {
+        // g / R (trockene Luft) in K/m
+        float x = 0.034163f * altitude / (temperature + 273.15f + 0.00325f * altitude);
+        float factor = 1 + x * (1 + x * (0.5f + x * (1.0f / 6 + x * (1.0f / 24))));
+        return (int32_t)(pressure * factor + 0.5f);
+    }
+
+    /**
+     *
+     * Taupunkt in Hundertstel °C nach der Magnus Formel (Sonntag 1990),
+     * 'temperature' in °C und 'humidity' in %.
+     *
+     **/
+    static int32_t dewPoint(float temperature, float humidity)
+    {
+        if (humidity < 1)
+        {
+            humidity = 1;
+        }
+        float gamma = logf(humidity / 100) + 17.62f * temperature / (243.12f + temperature);
+        float dew = 243.12f * gamma / (17.62f - gamma);
+        return (int32_t)(dew < 0 ? dew * 100 - 0.5f : dew * 100 + 0.5f);
+    }
+
+    /**
+     *
+     * Luftqualitätsindex (US EPA AQI, Stützstellen seit 2024) aus PM2.5 und
+     * PM10 in Zehntel µg/m³, der höhere der beiden. Die EPA bezieht den Index
+     * auf 24 Stunden Mittel, hier dient der letzte Messzyklus als Eingabe.
+     *
+     **/
+    static uint16_t airQualityIndex(uint16_t pm25, uint16_t pm10)
+    {
+        static const aqiBreakpoint pm25Table[] = {
+            {0, 90, 0, 50}, {91, 354, 51, 100}, {355, 554, 101, 150},
+            {555, 1254, 151, 200}, {1255, 2254, 201, 300}, {2255, 3254, 301, 500}};
+        static const aqiBreakpoint pm10Table[] = {
+            {0, 540, 0, 50}, {550, 1540, 51, 100}, {1550, 2540, 101, 150},
+            {2550, 3540, 151, 200}, {3550, 4240, 201, 300}, {4250, 6040, 301, 500}};
+        // PM10 wird laut EPA auf ganze µg/m³ abgeschnitten
+        uint16_t a = interpolate(pm25Table, sizeof(pm25Table) / sizeof(pm25Table[0]), pm25);
+        uint16_t b = interpolate(pm10Table, sizeof(pm10Table) / sizeof(pm10Table[0]), pm10 / 10 * 10);
+        return a > b ? a : b;
+    }
+
+    /**
+     *
+     * Übernimmt eine Messung des Luftdrucks (Hundertstel hPa) für die
+     * Tendenz. Jeder Abschnitt wird gemittelt, die Tendenz ist der Mittelwert
+     * des letzten Abschnitts abzüglich dem von vor 3 Stunden.
+     *
+     **/
+    void addPressure(int32_t pressure, unsigned long now)
+    {
+        if (!started)
+        {
+            started = true;
+            millisSlot = now;
+        }
+        slotSum += pressure;
+        slotSamples++;
+        if (now - millisSlot < DERIVED_TENDENCY_SLOT)
+        {
+            return;
+        }
+
+        slots[slotIndex] = slotSum / slotSamples;
+        slotIndex = slotIndex + 1 < DERIVED_TENDENCY_SLOTS ? slotIndex + 1 : 0;
+        slotCount = slotCount < DERIVED_TENDENCY_SLOTS ? slotCount + 1 : slotCount;
+        slotSum = 0;
+        slotSamples = 0;
+        millisSlot += DERIVED_TENDENCY_SLOT;
+
+        // Nach einer Lücke (z.B. Sensor ausgefallen) neu beginnen
+        if (now - millisSlot >= DERIVED_TENDENCY_SLOT)
+        {
+            slotCount = 0;
+            millisSlot = now;
+        }
+    }
+
+    bool hasTendency() { return slotCount == DERIVED_TENDENCY_SLOTS; }
+
+    // Änderung des Luftdrucks in 3 Stunden in Hundertstel hPa
+    int32_t tendency()
+    {
+        // 'slotIndex' zeigt auf den ältesten Abschnitt, davor liegt der neueste
+        uint8_t newest = slotIndex > 0 ? slotIndex - 1 : DERIVED_TENDENCY_SLOTS - 1;
+        return slots[newest] - slots[slotIndex];
+    }
+
+    /**
+     *
+     * Berechnet alle abgeleiteten Werte aus 'data', wird mit jeder Messung
+     * aufgerufen (Treiber 'DerivedDriver' in sensors.cpp).
+     *
+     **/
+    void update(Measurment &data, unsigned long now)
+    {
+        float temperature = data.isValid(FIELD_TEMPERATURE) ? data.Temperature.toFloat() : 15;
+
+        if (data.isValid(FIELD_PRESSURE))
+        {
+            int32_t pressure = data.Pressure.hundredths();
+            data.SeaLevelPressure.setHundredths(seaLevelPressure(pressure, temperature));
+            data.setValid(FIELD_SEA_LEVEL_PRESSURE);
+
+            addPressure(pressure, now);
+            if (hasTendency())
+            {
+                data.PressureTendency.setHundredths(tendency());
+                data.setValid(FIELD_PRESSURE_TENDENCY);
+            }
+        }
+
+        // Die relative Feuchte gilt für die Temperatur des HDC1080
+        if (data.isValid(FIELD_HDC1080_TEMPERATURE) && data.isValid(FIELD_HUMIDITY))
+        {
+            data.DewPoint.setHundredths(dewPoint(data.Hdc1080Temperature.toFloat(), data.Humidity.toFloat()));
+            data.setValid(FIELD_DEW_POINT);
+        }
+        else if (data.isValid(FIELD_TEMPERATURE) && data.isValid(FIELD_HUMIDITY))
+        {
+            data.DewPoint.setHundredths(dewPoint(temperature, data.Humidity.toFloat()));
+            data.setValid(FIELD_DEW_POINT);
+        }
+
+        if (data.isValid(FIELD_PM25) && data.isValid(FIELD_PM10))
+        {
+            data.Aqi.setRaw(airQualityIndex(data.pm25.raw, data.pm10.raw));
+            data.setValid(FIELD_AQI);
+        }
+    }
+};
+
+#endif
@@ -1,14 +1,37 @@
 #include "config.h"
+#include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 
 #include "measurement.h"
+#include "fixedpoint.cpp"
+#include "power.cpp"
+
+// Textzeilen auf dem Display (Schriftgröße 1, 8 Pixel je Zeile) und
+// Puffergröße einer Zeile, Umlaute belegen in UTF-8 zwei Bytes
+#define SCREEN_LINES (SCREEN_HEIGHT / 8)
+#define SCREEN_LINE_SIZE 32
+
+// SSD1306 Steuerbytes und Kommandos für das Adressfenster
+#define SSD1306_CONTROL_COMMAND 0x00
+#define SSD1306_CONTROL_DATA 0x40
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+// Nutzdaten je I2C Übertragung, der Puffer der Wire Bibliothek fasst 32 Bytes
+#define SCREEN_I2C_CHUNK 31
+
+// Zeichenzellen (6x8 Pixel) je Zeile und Zeichen deren Muster beim Start
+// gerastert werden, die Ausgabe von 'FixedPoint::format'
+#define SCREEN_CELLS (SCREEN_WIDTH / 6)
+#define SCREEN_GLYPHS "0123456789.- "
+#define SCREEN_GLYPH_COUNT (sizeof(SCREEN_GLYPHS) - 1)
 
 class WSDisplay
 {
 private:
     // Gibt die wie viele Seiten es gibt
-    const int maxDisplayPages = 2;
+    const int maxDisplayPages = 3;
 
     // Die aktuel dargestellte Seite
     int currentPage = 0;
@@ -16,14 +39,253 @@ private:
     // Ermittelt ob das Display ein-/ausgeschaltet ist
     bool displayStandby = false;
 
-    // Display Zeiten für (Display aktualisierung, Display ein-/ausschalten)
-    unsigned long millisUpdateDisplay, millisShutdownDisplay;
+    // Zeitpunkt der letzten Interaktion, für das Ausschalten des Displays
+    unsigned long millisShutdownDisplay;
 
     // Zeigt auf die Messwerte aus dem Hauptprogramm um diese darstellen zu können
     Measurment *data;
 
     Adafruit_SSD1306 display;
 
+    // Der zuletzt gezeichnete Text jeder Zeile, nur geänderte Zeichen
+    // werden neu gezeichnet.
+    char shownLines[SCREEN_LINES][SCREEN_LINE_SIZE];
+    bool shownInverted[SCREEN_LINES];
+
+    // Spalten (je ein Byte, 8 Pixel hoch) der Zeichen aus SCREEN_GLYPHS
+    uint8_t glyphs[SCREEN_GLYPH_COUNT][6];
+
+    // Geänderte Spalten je Page (8 Pixel Zeile) seit der letzten Übertragung,
+    // 'dirtyStart' > 'dirtyEnd' bedeutet unverändert.
+    uint8_t dirtyStart[SCREEN_LINES];
+    uint8_t dirtyEnd[SCREEN_LINES];
+
+    /**
+     * 
+     * Markiert die Spalten 'x0' bis 'x1' der Page 'page' als geändert.
+     * 
+     **/
+    void markDirty(uint8_t page, uint8_t x0, uint8_t x1)
+    {
+        if (x0 < dirtyStart[page])
+        {
+            dirtyStart[page] = x0;
+        }
+        if (x1 > dirtyEnd[page])
+        {
+            dirtyEnd[page] = x1;
+        }
+    }
+
+    void clearDirty()
+    {
+        memset(dirtyStart, SCREEN_WIDTH - 1, sizeof(dirtyStart));
+        memset(dirtyEnd, 0, sizeof(dirtyEnd));
+    }
+
+    /**
+     * 
+     * Löscht den Bildspeicher und markiert das ganze Display als geändert,
+     * z.B. beim Wechsel der Seite.
+     * 
+     **/
+    void invalidate()
+    {
+        display.clearDisplay();
+        memset(shownLines, 0, sizeof(shownLines));
+        memset(shownInverted, 0, sizeof(shownInverted));
+        for (uint8_t page = 0; page < SCREEN_LINES; page++)
+        {
+            markDirty(page, 0, SCREEN_WIDTH - 1);
+        }
+    }
+
+    /**
+     * 
+     * Rastert die Zeichen aus SCREEN_GLYPHS einmalig mit dem Font der
+     * Bibliothek und speichert ihre Spalten. Der Bildspeicher wird dabei
+     * benutzt und danach gelöscht.
+     * 
+     **/
+    void rasterizeGlyphs()
+    {
+        const uint8_t *buffer = display.getBuffer();
+        for (uint8_t i = 0; i < SCREEN_GLYPH_COUNT; i++)
+        {
+            display.drawChar(0, 0, SCREEN_GLYPHS[i], WHITE, BLACK, 1);
+            memcpy(glyphs[i], buffer, sizeof(glyphs[i]));
+        }
+        display.clearDisplay();
+    }
+
+    /**
+     * 
+     * Zeichnet das Zeichen 'c' in die Zelle 'cell' der Zeile 'line'. Zeichen
+     * aus SCREEN_GLYPHS werden als 6 Bytes in den Bildspeicher kopiert,
+     * alle anderen (Beschriftungen, Einheiten) zeichnet die Bibliothek.
+     * '\0' löscht die Zelle.
+     * 
+     **/
+    void drawCell(uint8_t line, uint8_t cell, char c, bool inverted)
+    {
+        uint8_t *target = display.getBuffer() + line * SCREEN_WIDTH + cell * 6;
+        if (c == '\0')
+        {
+            memset(target, 0, 6);
+            return;
+        }
+
+        const char *glyph = strchr(SCREEN_GLYPHS, c);
+        if (glyph == NULL)
+        {
+            display.drawChar(cell * 6, line * 8, c, inverted ? BLACK : WHITE, inverted ? WHITE : BLACK, 1);
+            return;
+        }
+        const uint8_t *columns = glyphs[glyph - SCREEN_GLYPHS];
+        for (uint8_t x = 0; x < 6; x++)
+        {
+            target[x] = inverted ? ~columns[x] : columns[x];
+        }
+    }
+
+    /**
+     * 
+     * Setzt den Text der Zeile 'line'. Verglichen wird Zeichen für Zeichen
+     * mit dem zuletzt gezeichneten Text, nur geänderte Zellen werden neu
+     * gezeichnet und als geändert markiert. Ändert sich z.B. nur die letzte
+     * Ziffer eines Messwerts, werden 6 Spalten übertragen. Text über die
+     * Breite des Displays hinaus entfällt.
+     * 
+     **/
+    void setLine(uint8_t line, const char *text, bool inverted = false)
+    {
+        char *shown = shownLines[line];
+        bool redraw = shownInverted[line] != inverted;
+        uint8_t first = SCREEN_CELLS;
+        uint8_t last = 0;
+
+        // Bis zum Ende des längeren Textes, danach sind beide Zellen leer
+        for (uint8_t i = 0; i < SCREEN_CELLS && (shown[i] != '\0' || *text != '\0'); i++)
+        {
+            char c = *text;
+            if (c != '\0')
+            {
+                text++;
+            }
+            if (c == shown[i] && !redraw)
+            {
+                continue;
+            }
+            drawCell(line, i, c, inverted);
+            shown[i] = c;
+            first = i < first ? i : first;
+            last = i;
+        }
+
+        shownInverted[line] = inverted;
+        if (first <= last)
+        {
+            markDirty(line, first * 6, last * 6 + 5);
+        }
+    }
+
+    /**
+     * 
+     * Formatiert einen Messwert mit 'decimals' Nachkommastellen und der
+     * Einheit 'unit' und setzt ihn als Zeile 'line', ohne Fließkomma und
+     * ohne Heap (String). Ein ungültiger Wert wird als "-" angezeigt.
+     * 
+     **/
+    template <typename T, int32_t SCALE>
+    void setValueLine(uint8_t line, const FixedValue<T, SCALE> &value, uint8_t decimals, const char *unit, bool valid = true)
+    {
+        char buffer[SCREEN_LINE_SIZE];
+        uint8_t length = 1;
+        if (valid)
+        {
+            int32_t scaled = value.hundredths();
+            for (uint8_t i = decimals; i < 2; i++)
+            {
+                scaled /= 10;
+            }
+            length = FixedPoint::format(buffer, scaled, decimals);
+        }
+        else
+        {
+            buffer[0] = '-';
+        }
+        strncpy(buffer + length, unit, SCREEN_LINE_SIZE - 1 - length);
+        buffer[SCREEN_LINE_SIZE - 1] = '\0';
+        setLine(line, buffer);
+    }
+
+    void sendCommand(uint8_t command)
+    {
+        Wire.beginTransmission(SCREEN_ADDRESS);
+        Wire.write((uint8_t)SSD1306_CONTROL_COMMAND);
+        Wire.write(command);
+        Wire.endTransmission();
+        bytesTransferred += 2;
+    }
+
+    /**
+     * 
+     * Überträgt nur die geänderten Spalten jeder Page an das Display.
+     * Ohne Änderung findet keine I2C Übertragung statt.
+     * 
+     **/
+    void flush()
+    {
+        const uint8_t *buffer = display.getBuffer();
+        bool sent = false;
+
+        for (uint8_t page = 0; page < SCREEN_LINES; page++)
+        {
+            if (dirtyStart[page] > dirtyEnd[page])
+            {
+                continue;
+            }
+
+            // Adressfenster auf die geänderten Spalten der Page setzen
+            Wire.beginTransmission(SCREEN_ADDRESS);
+            Wire.write((uint8_t)SSD1306_CONTROL_COMMAND);
+            Wire.write(SSD1306_COLUMNADDR);
+            Wire.write(dirtyStart[page]);
+            Wire.write(dirtyEnd[page]);
+            Wire.write(SSD1306_PAGEADDR);
+            Wire.write(page);
+            Wire.write(page);
+            Wire.endTransmission();
+            bytesTransferred += 7;
+
+            const uint8_t *row = buffer + page * SCREEN_WIDTH;
+            for (uint16_t x = dirtyStart[page]; x <= dirtyEnd[page]; x += SCREEN_I2C_CHUNK)
+            {
+                uint16_t count = dirtyEnd[page] + 1 - x;
+                if (count > SCREEN_I2C_CHUNK)
+                {
+                    count = SCREEN_I2C_CHUNK;
+                }
+                Wire.beginTransmission(SCREEN_ADDRESS);
+                Wire.write((uint8_t)SSD1306_CONTROL_DATA);
+                Wire.write(row + x, count);
+                Wire.endTransmission();
+                bytesTransferred += count + 1;
+            }
+            sent = true;
+        }
+
+        if (sent)
+        {
+            flushes++;
+        }
+        else
+        {
+            skippedFlushes++;
+        }
+        clearDirty();
+    }
+
     /**
      * 
      * Zeigt auf dem Display die Status Seite an.
@@ -31,39 +293,25 @@ private:
      **/
     void displayStatusPage()
     {
-        display.clearDisplay();
-        display.setCursor(0, 0);
-        display.setTextSize(1.4);
-        display.setTextColor(BLACK, WHITE);
-        display.println("> Status Nachricht\n");
-        display.setTextColor(WHITE, BLACK);
-        display.println();
-        display.println("");
-        display.display();
+        setLine(0, "> Status Nachricht", true);
     }
 
     /**
      * 
      * Zeigt auf dem Display die Luft Werte an.
-     * unter anderem die Temperatur, Luftdruck und die Höhe.
+     * unter anderem die Temperatur, Luftdruck und die Höhe, dazu die
+     * abgeleiteten Werte Luftdruck auf Meereshöhe, Tendenz und Taupunkt.
      * 
      **/
     void displayAirPage()
     {
-        display.clearDisplay();
-        display.setCursor(0, 0);
-        display.setTextSize(1.4);
-        display.setTextColor(BLACK, WHITE);
-        display.print("Luft Daten");
-        display.setTextColor(WHITE, BLACK);
-        display.println();
-        display.println();
-        display.print(this->data->Temperature);
-        display.print((char)247);
-        display.println("C");
-        display.println(String(this->data->Pressure) + " mBar");
-        display.println(String(this->data->Altitute) + " Meter");
-        display.display();
+        setLine(0, "Luft Daten", true);
+        setValueLine(2, this->data->Temperature, 2, "\367C");
+        setValueLine(3, this->data->Pressure, 2, " mBar");
+        setValueLine(4, this->data->Altitute, 2, " Meter");
+        setValueLine(5, this->data->SeaLevelPressure, 2, " mBar NN", this->data->isValid(FIELD_SEA_LEVEL_PRESSURE));
+        setValueLine(6, this->data->PressureTendency, 2, " mBar/3h", this->data->isValid(FIELD_PRESSURE_TENDENCY));
+        setValueLine(7, this->data->DewPoint, 2, "\367C Taupunkt", this->data->isValid(FIELD_DEW_POINT));
     }
 
     /**
@@ -73,34 +321,38 @@ private:
      **/
     void displayLightPage()
     {
-        display.clearDisplay();
-        display.setCursor(0, 0);
-        display.setTextSize(1.4);
-        display.setTextColor(BLACK, WHITE);
-        display.print("Licht Daten");
-        display.setTextColor(WHITE, BLACK);
-        display.println();
-        display.println();
-        display.println(String(this->data->Lux) + " Lux");
-        display.println(String(this->data->UV) + " µW/cm² (UV)");
-        display.display();
+        setLine(0, "Licht Daten", true);
+        setValueLine(2, this->data->Lux, 0, " Lux");
+        setValueLine(3, this->data->UV, 0, " µW/cm² (UV)");
+    }
+
+    /**
+     * 
+     * Zeigt auf dem Display den Feinstaub (PM2.5, PM10) und den daraus
+     * berechneten Luftqualitätsindex an.
+     * 
+     **/
+    void displayDustPage()
+    {
+        setLine(0, "Feinstaub", true);
+        setValueLine(2, this->data->pm25, 1, " µg/m³ PM2.5", this->data->isValid(FIELD_PM25));
+        setValueLine(3, this->data->pm10, 1, " µg/m³ PM10", this->data->isValid(FIELD_PM10));
+        setValueLine(4, this->data->Aqi, 0, " AQI", this->data->isValid(FIELD_AQI));
     }
 
     /**
      * 
      * Aktuallisiert das Display.
-     * Wenn durch die 'handleDisplay' Methode der Wert 'displayStandby' wahr ist, dann
-     * wird das Display geleert (ausgeschalten), ist dies nicht der Fall wird per
-     * Wert 'currentPage' ermittelt welche Seite zuletzt offen war. Diese Seite
-     * wird folglich aktualisiert.
+     * Im Standby ist das Display ausgeschaltet, der Inhalt bleibt im Speicher
+     * des Displays erhalten und es wird nichts übertragen. Ansonsten wird per
+     * Wert 'currentPage' ermittelt welche Seite zuletzt offen war, diese Seite
+     * wird gezeichnet und nur die Änderungen werden übertragen.
      * 
      **/
     void updateDisplay()
     {
         if (displayStandby == true)
         {
-            display.clearDisplay();
-            display.display();
             return;
         }
 
@@ -115,10 +367,35 @@ private:
         case 2:
             displayLightPage();
             break;
+        case 3:
+            displayDustPage();
+            break;
+        }
+        flush();
+    }
+
+    /**
+     * 
+     * Schaltet das Display aus dem Standby wieder ein.
+     * 
+     **/
+    void wakeUp()
+    {
+        millisShutdownDisplay = millis();
+        if (displayStandby == true)
+        {
+            displayStandby = false;
+            sendCommand(SSD1306_DISPLAYON);
+            power().set(POWER_DISPLAY, DISPLAY_ON);
         }
     }
 
 public:
+    // Statistik: übertragene Bytes, Übertragungen und Aktualisierungen ohne Änderung
+    unsigned long bytesTransferred = 0;
+    unsigned long flushes = 0;
+    unsigned long skippedFlushes = 0;
+
     /**
      * 
      * Setzt die Display Seite und aktualisiert dieses im Anschluss.
@@ -127,33 +404,33 @@ public:
      *  0: Status Seite         - Zeigt aktuelle Ereignisse, Fehlermeldungen und Warnungen
      *  1: Luftsensor Seite     - Zeigt Luftwerte (Temperatur, Luftdruck, Höhe)
      *  2: Lichtsensor Seite    - Zeigt Lichtinformationen (Lumen, Ultraviolet in µW/cm²)
+     *  3: Feinstaub Seite      - Zeigt PM2.5, PM10 und den Luftqualitätsindex
      * 
      **/
     void setDisplayPage(int page)
     {
         currentPage = page;
+        invalidate();
         updateDisplay();
     }
 
     /**
      * 
-     * Setzt alle Display Zeiten zurück.
+     * Setzt die Display Zeit zurück.
      * Die 'updateDisplay' Methode wird aufgerufen und sorgt dafür das nach dem
      * aktualisieren des Display's dieses auch wieder eingeschalten wird.
      * 
      **/
     void adjustmentMillis()
     {
-        millisUpdateDisplay = millis();
-        millisShutdownDisplay = millis();
-        displayStandby = false;
+        wakeUp();
         updateDisplay();
     }
 
     /**
      * 
      * Springt auf die nächste Seite und führt die
-     * 'updateDisplay' Methode aus.
+     * 'updateDisplay' Methode aus. Im Standby wird nur eingeschaltet.
      * 
      **/
     void nextPage()
@@ -161,42 +438,44 @@ public:
         if (displayStandby == false)
         {
             currentPage++;
-        }
-        if (currentPage > maxDisplayPages)
-        {
-            currentPage = 0;
+            if (currentPage > maxDisplayPages)
+            {
+                currentPage = 0;
+            }
+            invalidate();
         }
 
-        millisShutdownDisplay = millis();
-        displayStandby = false;
+        wakeUp();
         updateDisplay();
     }
 
     /**
      * 
-     * Diese Methode muss in die Hauptroutine vom Programm,
-     * sie sorgt für die Überprüfung der Display Zeiten.
-     * Jenachdem was in der Konfiguration eingestellt ist wird das
-     * display aktualisiert oder ein-/ausgeschalten.
-     * Dafür wird zunächst überprüft, wann 'millisShutdownDisplay'
-     * oder 'millisUpdateDisplay' zuletzt eine
-     * Interaktion hatten. Diese werden bspw. über die Methoden 'nextPage',
-     * 'adjustmentMillis', 'setDisplayPage' ausgeübt.
+     * Aktualisiert die aktuelle Seite des Displays.
+     * Diese Methode wird vom Scheduler im Intervall 'SCREEN_REFRESH_INTERVAL'
+     * aufgerufen.
      * 
      **/
-    void handleDisplay()
+    void refreshDisplay()
     {
-        if ((millis() - millisShutdownDisplay) >= 30e3)
-        {
-            displayStandby = true;
-            updateDisplay();
-            millisShutdownDisplay = millis();
-        }
+        updateDisplay();
+    }
 
-        if ((millis() - millisUpdateDisplay) >= 10e3)
+    /**
+     * 
+     * Überprüft wann die letzte Interaktion ('nextPage', 'adjustmentMillis')
+     * stattgefunden hat und schaltet das Display nach 'SCREEN_STANDBY_TIME'
+     * einmalig aus. Diese Methode wird vom Scheduler im Intervall
+     * 'SCREEN_STANDBY_CHECK_INTERVAL' aufgerufen.
+     * 
+     **/
+    void handleStandby()
+    {
+        if (displayStandby == false && (millis() - millisShutdownDisplay) >= SCREEN_STANDBY_TIME)
         {
-            updateDisplay();
-            millisUpdateDisplay = millis();
+            displayStandby = true;
+            sendCommand(SSD1306_DISPLAYOFF);
+            power().set(POWER_DISPLAY, DISPLAY_OFF);
         }
     }
 
@@ -212,10 +491,15 @@ public:
 
         // Initialisiere Display, zeige Logo
         const unsigned char logo[] PROGMEM = BKB_LOGO;
-        display.begin(SSD1306_SWITCHCAPVCC, 0x3D);
-        display.clearDisplay();
+        display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS);
+        rasterizeGlyphs();
         display.drawBitmap(0, 0, logo, 128, 64, WHITE);
         display.display();
-        delay(3000);
+        power().set(POWER_DISPLAY, DISPLAY_ON);
+
+        // Das Logo bleibt bis zur ersten Aktualisierung nach dem Start stehen,
+        // danach wird die erste Seite vollständig übertragen
+        clearDirty();
+        invalidate();
     }
 };
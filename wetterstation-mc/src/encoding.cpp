@@ -0,0 +1,191 @@
+#include <Arduino.h>
+#include "config.h"
+#include "upload.cpp"
+
+#ifndef __ENCODING_H_INC__
+#define __ENCODING_H_INC__
+
+/*
+    Formate für den Body der Postrequests an die openSenseMap, ausgewählt
+    wird über OSM_PAYLOAD_* in config.h. Jedes Format ist eine Klasse mit:
+
+      contentType()  Wert des 'Content-Type' Headers
+      maxEntries()   höchstens so viele Messzyklen pro Request
+      write(out, batch)
+
+    'out' ist ein 'UploadWriter' oder ein 'UploadCounter' (Länge des Bodys).
+    'batch' liefert die Messzyklen eines Requests:
+
+      size()           Anzahl der Messzyklen
+      channels(i)      Anzahl der Messungen eines Messzyklus
+      valid(i, j)      Messung 'j' ist gültig und wird gesendet
+      value(i, j)      Messwert in Hundertstel
+      epoch(i)         Unix Zeit des Messzyklus, 0 wenn unbekannt
+      sensorId(j)      openSenseMap ID der Messung 'j'
+*/
+
+// Breite eines Messwertes in 'CsvPaddedEncoder', entspricht dem bisherigen "%9.2f"
+#define OSM_VALUE_WIDTH 9
+
+/**
+ *
+ * Bisheriges Format, eine Zeile "<sensorId>,<wert>[,<zeitstempel>]" pro
+ * Messung, der Wert ist auf 'OSM_VALUE_WIDTH' Zeichen aufgefüllt.
+ *
+ **/
+class CsvPaddedEncoder
+{
+public:
+    static const char *contentType() { return "text/csv"; }
+    static uint16_t maxEntries() { return OSM_BACKFILL_BATCH; }
+
+    template <typename Out, typename Batch>
+    static void write(Out &out, Batch &batch)
+    {
+        for (uint16_t i = 0; i < batch.size(); i++)
+        {
+            uint32_t epoch = batch.epoch(i);
+            for (uint8_t j = 0; j < batch.channels(i); j++)
+            {
+                if (!batch.valid(i, j))
+                {
+                    continue;
+                }
+                out.print(batch.sensorId(j));
+                out.print(',');
+                out.printFixed(batch.value(i, j), 2, OSM_VALUE_WIDTH);
+                if (epoch != 0)
+                {
+                    out.print(',');
+                    out.printTimestamp(epoch);
+                }
+                out.print('\n');
+            }
+        }
+    }
+};
+
+/**
+ *
+ * CSV ohne Auffüllen, Nachkommastellen werden nur geschrieben soweit sie
+ * nicht Null sind, z.B. "1013" statt "  1013.00".
+ *
+ **/
+class CsvEncoder
+{
+public:
+    static const char *contentType() { return "text/csv"; }
+    static uint16_t maxEntries() { return OSM_BACKFILL_BATCH; }
+
+    /**
+     *
+     * Schreibt einen Wert in Hundertstel mit so wenig Zeichen wie möglich.
+     *
+     **/
+    template <typename Out>
+    static void printValue(Out &out, int32_t value)
+    {
+        if (value % 100 == 0)
+        {
+            out.printFixed(value / 100, 0);
+        }
+        else if (value % 10 == 0)
+        {
+            out.printFixed(value / 10, 1);
+        }
+        else
+        {
+            out.printFixed(value, 2);
+        }
+    }
+
+    template <typename Out, typename Batch>
+    static void write(Out &out, Batch &batch)
+    {
+        for (uint16_t i = 0; i < batch.size(); i++)
+        {
+            uint32_t epoch = batch.epoch(i);
+            for (uint8_t j = 0; j < batch.channels(i); j++)
+            {
+                if (!batch.valid(i, j))
+                {
+                    continue;
+                }
+                out.print(batch.sensorId(j));
+                out.print(',');
+                printValue(out, batch.value(i, j));
+                if (epoch != 0)
+                {
+                    out.print(',');
+                    out.printTimestamp(epoch);
+                }
+                out.print('\n');
+            }
+        }
+    }
+};
+
+/**
+ *
+ * JSON Objekt mit jeder Sensor ID genau einmal pro Request, z.B.
+ * {"<sensorId>":[21.5,"2021-04-15T12:30:00Z"],...}. Das Format der
+ * openSenseMap erlaubt nur einen Wert pro Sensor, daher enthält jeder
+ * Request genau einen Messzyklus.
+ *
+ **/
+class JsonEncoder
+{
+public:
+    static const char *contentType() { return "application/json"; }
+    static uint16_t maxEntries() { return 1; }
+
+    template <typename Out, typename Batch>
+    static void write(Out &out, Batch &batch)
+    {
+        out.print('{');
+        bool first = true;
+        for (uint16_t i = 0; i < batch.size(); i++)
+        {
+            uint32_t epoch = batch.epoch(i);
+            for (uint8_t j = 0; j < batch.channels(i); j++)
+            {
+                if (!batch.valid(i, j))
+                {
+                    continue;
+                }
+                if (!first)
+                {
+                    out.print(',');
+                }
+                first = false;
+
+                out.print('"');
+                out.print(batch.sensorId(j));
+                out.print("\":");
+                if (epoch != 0)
+                {
+                    out.print('[');
+                    CsvEncoder::printValue(out, batch.value(i, j));
+                    out.print(",\"");
+                    out.printTimestamp(epoch);
+                    out.print("\"]");
+                }
+                else
+                {
+                    CsvEncoder::printValue(out, batch.value(i, j));
+                }
+            }
+        }
+        out.print('}');
+    }
+};
+
+#if defined(OSM_PAYLOAD_JSON)
+typedef JsonEncoder PayloadEncoder;
+#elif defined(OSM_PAYLOAD_CSV_PADDED)
+typedef CsvPaddedEncoder PayloadEncoder;
+#else
+typedef CsvEncoder PayloadEncoder;
+#endif
+
+#endif
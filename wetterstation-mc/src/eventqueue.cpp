@@ -0,0 +1,97 @@
+#include <Arduino.h>
+
+#ifndef __EVENTQUEUE_H_INC__
+#define __EVENTQUEUE_H_INC__
+
+/**
+ *
+ * Ereignisse von Interrupts an die Hauptschleife.
+ *
+ **/
+enum InputEventType
+{
+    EVENT_BUTTON
+};
+
+typedef struct inputEvent
+{
+    uint8_t type;
+    // millis() zum Zeitpunkt des Interrupts
+    unsigned long time;
+} inputEvent;
+
+/**
+ *
+ * Warteschlange ohne Sperren für genau einen Erzeuger (Interrupt) und einen
+ * Verbraucher (Hauptschleife). Der Erzeuger schreibt nur 'tail', der
+ * Verbraucher nur 'head'. Die Indizes werden mit Acquire/Release gelesen bzw.
+ * geschrieben, so sieht der Verbraucher einen Eintrag erst wenn er
+ * vollständig ist. Es müssen keine Interrupts gesperrt werden.
+ *
+ * 'N' muss eine Zweierpotenz sein, ein Platz bleibt frei um voll und leer
+ * zu unterscheiden. Ist die Warteschlange voll, wird das neue Ereignis
+ * verworfen und 'dropped' hochgezählt.
+ *
+ **/
+template <typename T, uint8_t N>
+class EventQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+private:
+    T entries[N];
+    uint8_t head = 0;
+    uint8_t tail = 0;
+
+public:
+    // Verworfene Ereignisse, wird nur vom Erzeuger geschrieben
+    volatile unsigned long dropped = 0;
+
+    /**
+     *
+     * Fügt ein Ereignis hinzu, darf nur vom Erzeuger aufgerufen werden.
+     *
+     **/
+    bool push(const T &entry)
+    {
+        uint8_t current = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        uint8_t next = (current + 1) & (N - 1);
+        if (next == __atomic_load_n(&head, __ATOMIC_ACQUIRE))
+        {
+            dropped++;
+            return false;
+        }
+
+        entries[current] = entry;
+        __atomic_store_n(&tail, next, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /**
+     *
+     * Entnimmt das älteste Ereignis, darf nur vom Verbraucher aufgerufen
+     * werden. Liefert false wenn die Warteschlange leer ist.
+     *
+     **/
+    bool pop(T &entry)
+    {
+        uint8_t current = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        if (current == __atomic_load_n(&tail, __ATOMIC_ACQUIRE))
+        {
+            return false;
+        }
+
+        entry = entries[current];
+        __atomic_store_n(&head, (uint8_t)((current + 1) & (N - 1)), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    }
+
+    uint8_t capacity() const { return N - 1; }
+};
+
+#endif
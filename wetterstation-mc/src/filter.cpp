@@ -0,0 +1,354 @@
+#include <Arduino.h>
+#include "config.h"
+
+#include "measurement.h"
+
+#ifndef __FILTER_H_INC__
+#define __FILTER_H_INC__
+
+// Stufen eines 'SampleFilter', kombinierbar (siehe config.h)
+#define FILTER_NONE 0
+#define FILTER_MEDIAN 1
+#define FILTER_HAMPEL 2
+#define FILTER_RATE 4
+
+/**
+ *
+ * Gleitender Median über die letzten 'N' Werte ("Mediator"): die Werte
+ * liegen in einem Ringpuffer, ein Heap über ihre Indizes ist um den Median
+ * angeordnet, links (negative Positionen) ein Max-Heap der kleineren und
+ * rechts ein Min-Heap der größeren Werte. Ein neuer Wert ersetzt den
+ * ältesten an dessen Position und wird nur nach oben bzw. unten sortiert,
+ * Einfügen und Entfernen kosten so O(log N) Vergleiche. Nur Vergleiche und
+ * Vertauschungen von Bytes, kein Heap Speicher und keine Division.
+ *
+ **/
+template <uint8_t N>
+class RunningMedian
+{
+    static_assert(N > 0 && N < 128, "The window of a running median must hold 1 to 127 values");
+
+private:
+    int32_t values[N];
+    // Position jedes Werts im Heap und Index des Werts an jeder Position,
+    // 'heap' ist um N / 2 verschoben (Position 0 ist der Median)
+    int8_t pos[N];
+    int8_t heap[N];
+    uint8_t index = 0;
+    uint8_t count = 0;
+
+    int8_t &at(int i) { return heap[i + N / 2]; }
+    int minCount() { return (count - 1) / 2; }
+    int maxCount() { return count / 2; }
+
+    bool less(int i, int j) { return values[at(i)] < values[at(j)]; }
+
+    void exchange(int i, int j)
+    {
+        int8_t t = at(i);
+        at(i) = at(j);
+        at(j) = t;
+        pos[at(i)] = i;
+        pos[at(j)] = j;
+    }
+
+    // Vertauscht 'i' und 'j' wenn der Wert an 'i' kleiner ist
+    bool order(int i, int j)
+    {
+        if (!less(i, j))
+        {
+            return false;
+        }
+        exchange(i, j);
+        return true;
+    }
+
+    // Stellt den Min-Heap unterhalb von 'i' / 2 wieder her
+    void minSortDown(int i)
+    {
+        for (; i <= minCount(); i *= 2)
+        {
+            if (i > 1 && i < minCount() && less(i + 1, i))
+            {
+                i++;
+            }
+            if (!order(i, i / 2))
+            {
+                break;
+            }
+        }
+    }
+
+    // Stellt den Max-Heap unterhalb von 'i' / 2 wieder her
+    void maxSortDown(int i)
+    {
+        for (; i >= -maxCount(); i *= 2)
+        {
+            if (i < -1 && i > -maxCount() && less(i, i - 1))
+            {
+                i--;
+            }
+            if (!order(i / 2, i))
+            {
+                break;
+            }
+        }
+    }
+
+    // Sortiert 'i' nach oben, true wenn der Wert zum Median wurde
+    bool minSortUp(int i)
+    {
+        while (i > 0 && order(i, i / 2))
+        {
+            i /= 2;
+        }
+        return i == 0;
+    }
+
+    bool maxSortUp(int i)
+    {
+        while (i < 0 && order(i / 2, i))
+        {
+            i /= 2;
+        }
+        return i == 0;
+    }
+
+public:
+    RunningMedian()
+    {
+        clear();
+    }
+
+    /**
+     *
+     * Leert das Fenster. Die Positionen werden abwechselnd Median, Max- und
+     * Min-Heap zugeordnet, so bleiben beide Heaps beim Füllen gleich groß.
+     *
+     **/
+    void clear()
+    {
+        index = 0;
+        count = 0;
+        for (int i = N - 1; i >= 0; i--)
+        {
+            pos[i] = ((i + 1) / 2) * ((i & 1) ? -1 : 1);
+            at(pos[i]) = i;
+            values[i] = 0;
+        }
+    }
+
+    /**
+     *
+     * Fügt 'value' hinzu, ist das Fenster voll ersetzt er den ältesten Wert.
+     *
+     **/
+    void add(int32_t value)
+    {
+        bool fresh = count < N;
+        int p = pos[index];
+        int32_t old = values[index];
+        values[index] = value;
+        index = index + 1 < N ? index + 1 : 0;
+        if (fresh)
+        {
+            count++;
+        }
+
+        if (p > 0)
+        {
+            if (!fresh && old < value)
+            {
+                minSortDown(p * 2);
+            }
+            else if (minSortUp(p))
+            {
+                maxSortDown(-1);
+            }
+        }
+        else if (p < 0)
+        {
+            if (!fresh && value < old)
+            {
+                maxSortDown(p * 2);
+            }
+            else if (maxSortUp(p))
+            {
+                minSortDown(1);
+            }
+        }
+        else
+        {
+            if (maxCount() > 0)
+            {
+                maxSortDown(-1);
+            }
+            if (minCount() > 0)
+            {
+                minSortDown(1);
+            }
+        }
+    }
+
+    uint8_t size() const { return count; }
+    bool full() const { return count == N; }
+
+    /**
+     *
+     * Median der Werte im Fenster, bei gerader Anzahl der Mittelwert
+     * der beiden mittleren Werte.
+     *
+     **/
+    int32_t median()
+    {
+        int32_t value = values[at(0)];
+        if (count > 0 && (count & 1) == 0)
+        {
+            int32_t lower = values[at(-1)];
+            value = lower + (value - lower) / 2;
+        }
+        return value;
+    }
+
+    /**
+     *
+     * Median der absoluten Abweichungen von 'center' (MAD). Wird nicht
+     * fortlaufend geführt, kostet O(N²) und ist für kleine Fenster gedacht.
+     *
+     **/
+    int32_t medianDeviation(int32_t center)
+    {
+        int32_t deviations[N];
+        for (uint8_t i = 0; i < count; i++)
+        {
+            int32_t deviation = values[i] - center;
+            deviation = deviation < 0 ? -deviation : deviation;
+            uint8_t j = i;
+            for (; j > 0 && deviations[j - 1] > deviation; j--)
+            {
+                deviations[j] = deviations[j - 1];
+            }
+            deviations[j] = deviation;
+        }
+        if (count == 0)
+        {
+            return 0;
+        }
+        int32_t value = deviations[count / 2];
+        if ((count & 1) == 0)
+        {
+            value = deviations[count / 2 - 1] + (value - deviations[count / 2 - 1]) / 2;
+        }
+        return value;
+    }
+};
+
+/**
+ *
+ * Filter eines Messkanals zwischen Sensor und 'Measurment', die Stufen
+ * werden zur Compile-Zeit gewählt ('FLAGS', siehe config.h):
+ *
+ *   FILTER_HAMPEL  ein Wert welcher mehr als FILTER_HAMPEL_K mal die
+ *                  geschätzte Standardabweichung (1.4826 * MAD) und mehr als
+ *                  'FLOOR' plus 'RELATIVE' Prozent des Medians vom Median
+ *                  des Fensters abweicht, wird durch den Median ersetzt.
+ *                  Erst bei vollem Fenster. Der relative Anteil lässt
+ *                  Sprünge durch, welche das Signal selbst zwischen zwei
+ *                  Messungen macht (z.B. Wolken bei Licht und UV).
+ *   FILTER_MEDIAN  gibt immer den Median des Fensters weiter.
+ *   FILTER_RATE    begrenzt die Änderung auf 'RATE' pro Sekunde.
+ *
+ * Werte, 'FLOOR' und 'RATE' in Hundertstel der Einheit. Gerechnet wird
+ * nur mit Ganzzahlen, der Vergleich der Abweichung multipliziert in 64 Bit.
+ *
+ **/
+template <uint8_t WINDOW, uint8_t FLAGS, int32_t FLOOR = 0, int32_t RATE = 0, int32_t RELATIVE = 0>
+class SampleFilter
+{
+    static_assert(WINDOW % 2 == 1, "The filter window must be odd");
+    static_assert(RELATIVE >= 0 && RELATIVE <= 1000, "The relative floor must be between 0 and 1000 percent");
+    static_assert(!(FLAGS & FILTER_RATE) || (RATE > 0 && RATE <= 32767),
+                  "The rate limit must be between 1 and 32767 hundredths per second");
+
+private:
+    RunningMedian<WINDOW> window;
+    int32_t last = 0;
+    unsigned long millisLast = 0;
+    bool primed = false;
+
+public:
+    // Statistiken
+    unsigned long samples = 0;
+    unsigned long outliers = 0;
+    unsigned long limited = 0;
+
+    /**
+     *
+     * Filtert einen Wert gemessen zum Zeitpunkt 'now' (ms).
+     *
+     **/
+    int32_t apply(int32_t value, unsigned long now)
+    {
+        samples++;
+        if (FLAGS & (FILTER_MEDIAN | FILTER_HAMPEL))
+        {
+            window.add(value);
+            int32_t median = window.median();
+            if ((FLAGS & FILTER_HAMPEL) && window.full())
+            {
+                int32_t deviation = value - median;
+                deviation = deviation < 0 ? -deviation : deviation;
+                // 1.4826 als 95 / 64, FILTER_HAMPEL_K in Hundertstel
+                int32_t level = median < 0 ? -median : median;
+                if (deviation > FLOOR + (int32_t)((int64_t)level * RELATIVE / 100) &&
+                    (int64_t)deviation * 6400 > (int64_t)window.medianDeviation(median) * 95 * FILTER_HAMPEL_K)
+                {
+                    value = median;
+                    outliers++;
+                }
+            }
+            if (FLAGS & FILTER_MEDIAN)
+            {
+                value = median;
+            }
+        }
+
+        if ((FLAGS & FILTER_RATE) && primed)
+        {
+            unsigned long elapsed = now - millisLast;
+            // Hält das Produkt unter 2^31
+            elapsed = elapsed < 65535 ? elapsed : 65535;
+            int32_t step = (int32_t)(RATE * elapsed / 1000);
+            if (value > last + step)
+            {
+                value = last + step;
+                limited++;
+            }
+            else if (value < last - step)
+            {
+                value = last - step;
+                limited++;
+            }
+        }
+
+        last = value;
+        millisLast = now;
+        primed = true;
+        return value;
+    }
+
+    // Filtert einen Messwert direkt in 'Measurment'
+    template <typename T, int32_t SCALE>
+    void apply(FixedValue<T, SCALE> &value, unsigned long now)
+    {
+        value.setHundredths(apply(value.hundredths(), now));
+    }
+
+    void reset()
+    {
+        window.clear();
+        primed = false;
+    }
+};
+
+#endif
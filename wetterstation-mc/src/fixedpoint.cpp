@@ -0,0 +1,134 @@
+#include <Arduino.h>
+
+#ifndef __FIXEDPOINT_H_INC__
+#define __FIXEDPOINT_H_INC__
+
+/**
+ *
+ * Hilfsfunktionen für Festkommazahlen.
+ * Ein Wert wird als ganze Zahl mit einer festen Anzahl an Nachkommastellen
+ * gespeichert, z.B. 2153 mit 2 Nachkommastellen für 21.53.
+ * Die Formatierung kommt ohne Fließkomma (%f) und ohne Heap aus.
+ *
+ **/
+class FixedPoint
+{
+public:
+    /**
+     *
+     * Anzahl der Dezimalstellen einer positiven Zahl (mindestens 1).
+     *
+     **/
+    static uint8_t digits(uint32_t value)
+    {
+        uint8_t n = 1;
+        while (value >= 10)
+        {
+            value /= 10;
+            n++;
+        }
+        return n;
+    }
+
+    /**
+     *
+     * Anzahl der Zeichen welche 'format' für den Wert ohne Auffüllen schreibt.
+     *
+     **/
+    static uint8_t length(int32_t value, uint8_t decimals)
+    {
+        uint32_t magnitude = value < 0 ? -(uint32_t)value : value;
+        uint8_t n = digits(magnitude);
+
+        // Führende Null vor dem Komma, z.B. "0.05"
+        if (n <= decimals)
+        {
+            n = decimals + 1;
+        }
+        if (decimals > 0)
+        {
+            n++;
+        }
+        if (value < 0)
+        {
+            n++;
+        }
+        return n;
+    }
+
+    /**
+     *
+     * Schreibt den Wert mit 'decimals' Nachkommastellen in 'buffer',
+     * rechtsbündig mit Leerzeichen auf 'width' Zeichen aufgefüllt (wie "%9.2f").
+     * Der Puffer muss mindestens max(width, length) + 1 Zeichen groß sein.
+     * Rückgabewert ist die Anzahl der geschriebenen Zeichen ohne Nullterminator.
+     *
+     **/
+    static uint8_t format(char *buffer, int32_t value, uint8_t decimals, uint8_t width = 0)
+    {
+        uint8_t len = length(value, decimals);
+        uint8_t total = len < width ? width : len;
+        uint32_t magnitude = value < 0 ? -(uint32_t)value : value;
+
+        // Von hinten nach vorne schreiben, so wird kein Zwischenpuffer benötigt
+        char *p = buffer + total;
+        *p = '\0';
+        for (uint8_t i = 0; i < decimals; i++)
+        {
+            *--p = '0' + magnitude % 10;
+            magnitude /= 10;
+        }
+        if (decimals > 0)
+        {
+            *--p = '.';
+        }
+        do
+        {
+            *--p = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while (magnitude > 0);
+        if (value < 0)
+        {
+            *--p = '-';
+        }
+        while (p > buffer)
+        {
+            *--p = ' ';
+        }
+        return total;
+    }
+
+    /**
+     *
+     * Schreibt eine positive Ganzzahl ohne Nachkommastellen in 'buffer',
+     * der gesamte Bereich von uint32_t ist erlaubt. Der Puffer muss
+     * 'digits(value)' + 1 Zeichen groß sein.
+     *
+     **/
+    static uint8_t formatUnsigned(char *buffer, uint32_t value)
+    {
+        uint8_t len = digits(value);
+        char *p = buffer + len;
+        *p = '\0';
+        do
+        {
+            *--p = '0' + value % 10;
+            value /= 10;
+        } while (value > 0);
+        return len;
+    }
+
+    /**
+     *
+     * Wandelt einen Fließkommawert in eine Festkommazahl mit dem Faktor 'scale'
+     * um (z.B. 100 für zwei Nachkommastellen), kaufmännisch gerundet.
+     *
+     **/
+    static int32_t fromFloat(float value, int32_t scale)
+    {
+        float scaled = value * scale;
+        return (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+    }
+};
+
+#endif
@@ -0,0 +1,358 @@
+#include <Arduino.h>
+#include "config.h"
+#include "ringbuffer.cpp"
+
+#ifndef __GATEWAY_H_INC__
+#define __GATEWAY_H_INC__
+
+/*
+    Binäres Format der Messungen einer Station an das Gateway (ein UDP Paket):
+
+      Offset  Größe  Inhalt
+      0       2      'W' 'S'
+      2       1      Version (GATEWAY_FRAME_VERSION)
+      3       1      Anzahl der Messungen 'n'
+      4       12     senseBox ID (die 24 Hex Zeichen als Bytes)
+      16      4      Unix Zeit der Messungen, 0 wenn unbekannt (little endian)
+      20      n*16   je Messung: Sensor ID (12 Bytes) und Wert in Hundertstel
+                     (int32, little endian)
+      20+n*16 2      Prüfsumme (Fletcher-16) über alle vorherigen Bytes
+*/
+
+#define GATEWAY_FRAME_VERSION 1
+#define GATEWAY_ID_SIZE 12
+#define GATEWAY_FRAME_HEADER 20
+#define GATEWAY_FRAME_READING 16
+#define GATEWAY_FRAME_MAX_READINGS 16
+#define GATEWAY_FRAME_SIZE (GATEWAY_FRAME_HEADER + GATEWAY_FRAME_MAX_READINGS * GATEWAY_FRAME_READING + 2)
+
+#if defined(GATEWAY_MODE) && defined(GATEWAY_IPADDR)
+#error "A station is either the gateway (GATEWAY_MODE) or sends to it (GATEWAY_IPADDR)"
+#endif
+
+static_assert(GATEWAY_MAX_BOXES <= 127, "GATEWAY_MAX_BOXES must fit the int8_t box index");
+
+/**
+ *
+ * Hilfsfunktionen für das Format der Frames.
+ *
+ **/
+class GatewayFormat
+{
+public:
+    /**
+     *
+     * Wandelt eine openSenseMap ID (24 Hex Zeichen) in 12 Bytes um,
+     * false wenn die ID ungültig ist.
+     *
+     **/
+    static bool parseId(const char *hex, uint8_t *id)
+    {
+        for (uint8_t i = 0; i < GATEWAY_ID_SIZE * 2; i++)
+        {
+            char c = hex[i];
+            uint8_t nibble;
+            if (c >= '0' && c <= '9')
+            {
+                nibble = c - '0';
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                nibble = c - 'a' + 10;
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                nibble = c - 'A' + 10;
+            }
+            else
+            {
+                return false;
+            }
+            id[i / 2] = i % 2 == 0 ? nibble << 4 : id[i / 2] | nibble;
+        }
+        return hex[GATEWAY_ID_SIZE * 2] == '\0';
+    }
+
+    static uint16_t checksum(const uint8_t *data, uint16_t length)
+    {
+        uint16_t a = 0, b = 0;
+        for (uint16_t i = 0; i < length; i++)
+        {
+            a = (a + data[i]) % 255;
+            b = (b + a) % 255;
+        }
+        return (b << 8) | a;
+    }
+
+    static void write32(uint8_t *p, uint32_t value)
+    {
+        p[0] = value;
+        p[1] = value >> 8;
+        p[2] = value >> 16;
+        p[3] = value >> 24;
+    }
+
+    static uint32_t read32(const uint8_t *p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+};
+
+/**
+ *
+ * Schreibt einen Frame direkt in 'buffer' (mindestens 'GATEWAY_FRAME_SIZE'
+ * Bytes), wird von den Stationen vor dem Senden an das Gateway benutzt.
+ *
+ **/
+class GatewayFrameWriter
+{
+private:
+    uint8_t *buffer = NULL;
+    uint8_t count = 0;
+    bool valid = false;
+
+public:
+    void begin(uint8_t *buffer, const char *boxId, uint32_t epoch)
+    {
+        this->buffer = buffer;
+        count = 0;
+        buffer[0] = 'W';
+        buffer[1] = 'S';
+        buffer[2] = GATEWAY_FRAME_VERSION;
+        valid = GatewayFormat::parseId(boxId, buffer + 4);
+        GatewayFormat::write32(buffer + 16, epoch);
+    }
+
+    /**
+     *
+     * Fügt eine Messung hinzu, false wenn der Frame voll ist.
+     *
+     **/
+    bool add(const char *sensorId, int32_t hundredths)
+    {
+        if (count >= GATEWAY_FRAME_MAX_READINGS)
+        {
+            return false;
+        }
+        uint8_t *p = buffer + GATEWAY_FRAME_HEADER + count * GATEWAY_FRAME_READING;
+        valid = GatewayFormat::parseId(sensorId, p) && valid;
+        GatewayFormat::write32(p + GATEWAY_ID_SIZE, hundredths);
+        count++;
+        return true;
+    }
+
+    /**
+     *
+     * Schließt den Frame ab, Rückgabewert ist seine Länge in Bytes,
+     * 0 wenn eine der IDs ungültig war.
+     *
+     **/
+    uint16_t finish()
+    {
+        buffer[3] = count;
+        uint16_t length = GATEWAY_FRAME_HEADER + count * GATEWAY_FRAME_READING;
+        uint16_t sum = GatewayFormat::checksum(buffer, length);
+        buffer[length] = sum;
+        buffer[length + 1] = sum >> 8;
+        return valid ? length + 2 : 0;
+    }
+};
+
+/**
+ *
+ * Eine Messung einer Station in der Warteschlange des Gateways.
+ *
+ **/
+typedef struct gatewayReading
+{
+    uint8_t sensorId[GATEWAY_ID_SIZE];
+    int32_t value;
+    uint32_t epoch;
+} gatewayReading;
+
+/**
+ *
+ * Warteschlange einer Station, 'millisOldest' ist der Empfang der ältesten
+ * wartenden Messung.
+ *
+ **/
+typedef struct gatewayBox
+{
+    uint8_t id[GATEWAY_ID_SIZE];
+    bool active;
+    unsigned long millisOldest;
+    RingBuffer<gatewayReading, GATEWAY_BOX_QUEUE> readings;
+} gatewayBox;
+
+/**
+ *
+ * Nimmt die Frames der Stationen an und sammelt die Messungen je senseBox.
+ * Eine Station wird gesendet sobald 'GATEWAY_BATCH_READINGS' Messungen
+ * warten oder die älteste 'GATEWAY_BATCH_DELAY' ms alt ist. So fasst ein
+ * Postrequest mehrere Messzyklen einer Station zusammen, das Senden selbst
+ * übernimmt 'Network' über die bestehende Sitzung.
+ *
+ **/
+class Gateway
+{
+private:
+    gatewayBox boxes[GATEWAY_MAX_BOXES];
+
+    // Nächste Station für 'nextBatch', reihum damit keine Station verdrängt wird
+    uint8_t nextBox = 0;
+
+    int8_t findBox(const uint8_t *id, bool create)
+    {
+        int8_t free = -1;
+        for (uint8_t i = 0; i < GATEWAY_MAX_BOXES; i++)
+        {
+            if (!boxes[i].active)
+            {
+                if (free < 0)
+                {
+                    free = i;
+                }
+                continue;
+            }
+            if (memcmp(boxes[i].id, id, GATEWAY_ID_SIZE) == 0)
+            {
+                return i;
+            }
+        }
+
+        if (!create || free < 0)
+        {
+            return -1;
+        }
+        memcpy(boxes[free].id, id, GATEWAY_ID_SIZE);
+        boxes[free].active = true;
+        boxes[free].readings.pop(boxes[free].readings.size());
+        return free;
+    }
+
+public:
+    // Statistiken
+    unsigned long framesReceived = 0;
+    unsigned long framesRejected = 0;
+    unsigned long readingsQueued = 0;
+    // Messungen ohne freien Platz für ihre Station
+    unsigned long readingsRejected = 0;
+
+    Gateway()
+    {
+        for (uint8_t i = 0; i < GATEWAY_MAX_BOXES; i++)
+        {
+            boxes[i].active = false;
+        }
+    }
+
+    /**
+     *
+     * Prüft einen empfangenen Frame und legt seine Messungen in der
+     * Warteschlange der Station ab. Ohne Zeit im Frame gilt 'epochNow'.
+     *
+     **/
+    bool receive(const uint8_t *frame, uint16_t length, uint32_t epochNow)
+    {
+        if (length < GATEWAY_FRAME_HEADER + 2 || frame[0] != 'W' || frame[1] != 'S' ||
+            frame[2] != GATEWAY_FRAME_VERSION || frame[3] > GATEWAY_FRAME_MAX_READINGS ||
+            length != GATEWAY_FRAME_HEADER + frame[3] * GATEWAY_FRAME_READING + 2 ||
+            GatewayFormat::checksum(frame, length - 2) != (frame[length - 2] | (frame[length - 1] << 8)))
+        {
+            framesRejected++;
+            return false;
+        }
+        framesReceived++;
+
+        int8_t index = findBox(frame + 4, true);
+        if (index < 0)
+        {
+            readingsRejected += frame[3];
+            return false;
+        }
+
+        gatewayBox &box = boxes[index];
+        if (box.readings.isEmpty())
+        {
+            box.millisOldest = millis();
+        }
+
+        uint32_t epoch = GatewayFormat::read32(frame + 16);
+        for (uint8_t i = 0; i < frame[3]; i++)
+        {
+            const uint8_t *p = frame + GATEWAY_FRAME_HEADER + i * GATEWAY_FRAME_READING;
+            gatewayReading reading;
+            memcpy(reading.sensorId, p, GATEWAY_ID_SIZE);
+            reading.value = (int32_t)GatewayFormat::read32(p + GATEWAY_ID_SIZE);
+            reading.epoch = epoch != 0 ? epoch : epochNow;
+            box.readings.push(reading);
+            readingsQueued++;
+        }
+        return true;
+    }
+
+    /**
+     *
+     * Liefert die nächste Station deren Messungen gesendet werden sollen,
+     * -1 wenn keine fällig ist. Mit 'force' ist jede Station mit Messungen fällig.
+     *
+     **/
+    int8_t nextBatch(bool force = false)
+    {
+        for (uint8_t n = 0; n < GATEWAY_MAX_BOXES; n++)
+        {
+            uint8_t i = (nextBox + n) % GATEWAY_MAX_BOXES;
+            gatewayBox &box = boxes[i];
+            if (!box.active || box.readings.isEmpty())
+            {
+                continue;
+            }
+            if (force || box.readings.size() >= GATEWAY_BATCH_READINGS ||
+                millis() - box.millisOldest >= GATEWAY_BATCH_DELAY)
+            {
+                nextBox = (i + 1) % GATEWAY_MAX_BOXES;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    gatewayBox &getBox(uint8_t index)
+    {
+        return boxes[index];
+    }
+
+    /**
+     *
+     * Entfernt die ersten 'count' Messungen einer Station nachdem der
+     * Server sie bestätigt hat.
+     *
+     **/
+    void confirm(uint8_t index, uint16_t count)
+    {
+        gatewayBox &box = boxes[index];
+        box.readings.pop(count);
+        if (box.readings.isEmpty())
+        {
+            // Platz für andere Stationen, die Station wird beim nächsten Frame neu angelegt
+            box.active = false;
+        }
+        else
+        {
+            box.millisOldest = millis();
+        }
+    }
+
+    // Überschriebene Messungen aller Stationen (Warteschlange voll)
+    unsigned long readingsDropped()
+    {
+        unsigned long dropped = 0;
+        for (uint8_t i = 0; i < GATEWAY_MAX_BOXES; i++)
+        {
+            dropped += boxes[i].readings.dropped;
+        }
+        return dropped;
+    }
+};
+
+#endif
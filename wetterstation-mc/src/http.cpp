@@ -0,0 +1,454 @@
+#include <Arduino.h>
+#include "config.h"
+
+#ifndef __HTTP_H_INC__
+#define __HTTP_H_INC__
+
+/**
+ *
+ * Zustände beim Lesen einer HTTP Antwort.
+ *
+ **/
+enum HttpParserState
+{
+    HTTP_STATUS_LINE,
+    HTTP_HEADER,
+    HTTP_BODY,
+    // Body mit 'Transfer-Encoding: chunked'
+    HTTP_CHUNK_SIZE,
+    HTTP_CHUNK_DATA,
+    HTTP_CHUNK_END,
+    HTTP_TRAILER,
+    HTTP_DONE
+};
+
+/**
+ *
+ * Liest eine HTTP/1.1 Antwort Zeichen für Zeichen ohne Heap und ohne
+ * auf weitere Daten zu warten. Es werden nur der Status Code sowie die
+ * Header 'Content-Length', 'Transfer-Encoding' und 'Connection' ausgewertet,
+ * so kann der Body exakt gelesen werden und die Verbindung für den nächsten
+ * Webrequest offen bleiben (keep-alive). Antworten 1xx, 204 und 304 haben
+ * keinen Body, auf 1xx folgt die eigentliche Antwort.
+ *
+ **/
+class HttpResponseParser
+{
+private:
+    HttpParserState state = HTTP_DONE;
+
+    // Puffer für die aktuelle Zeile, zu lange Zeilen werden abgeschnitten
+    char line[HTTP_LINE_SIZE];
+    uint8_t lineLength = 0;
+
+    uint16_t statusCode = 0;
+    int32_t contentLength = -1;
+    uint32_t bodyRead = 0;
+    bool connectionClose = false;
+    bool chunked = false;
+    bool bodyless = false;
+
+    // Restliche Bytes des aktuellen Chunks bzw. Größe beim Lesen der Zeile
+    uint32_t chunkRemaining = 0;
+    bool chunkExtension = false;
+
+    /**
+     *
+     * Vergleicht den Anfang der Zeile ohne Beachtung der Groß-/Kleinschreibung.
+     *
+     **/
+    bool lineStartsWith(const char *prefix)
+    {
+        uint8_t i = 0;
+        for (; prefix[i] != '\0'; i++)
+        {
+            if (i >= lineLength || tolower(line[i]) != tolower(prefix[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     *
+     * Liefert den Wert eines Headers, Leerzeichen nach dem ':' werden übersprungen.
+     *
+     **/
+    const char *headerValue(uint8_t nameLength)
+    {
+        const char *value = line + nameLength;
+        while (*value == ' ')
+        {
+            value++;
+        }
+        return value;
+    }
+
+    void parseStatusLine()
+    {
+        // "HTTP/1.1 201 Created"
+        const char *p = strchr(line, ' ');
+        statusCode = p != NULL ? atoi(p + 1) : 0;
+        state = HTTP_HEADER;
+    }
+
+    void endHeaders()
+    {
+        // Zwischenantwort, z.B. "100 Continue", die Antwort folgt
+        if (statusCode >= 100 && statusCode < 200 && statusCode != 101)
+        {
+            begin();
+            return;
+        }
+
+        bodyless = (statusCode >= 100 && statusCode < 200) || statusCode == 204 || statusCode == 304;
+        if (bodyless)
+        {
+            state = HTTP_DONE;
+        }
+        else if (chunked)
+        {
+            // Die Länge der Chunks gilt, nicht 'Content-Length'
+            contentLength = -1;
+            chunkRemaining = 0;
+            chunkExtension = false;
+            state = HTTP_CHUNK_SIZE;
+        }
+        else
+        {
+            state = contentLength == 0 ? HTTP_DONE : HTTP_BODY;
+        }
+    }
+
+    void parseHeader()
+    {
+        // Leere Zeile beendet die Header
+        if (lineLength == 0)
+        {
+            endHeaders();
+            return;
+        }
+
+        if (lineStartsWith("content-length:"))
+        {
+            contentLength = atol(headerValue(15));
+        }
+        else if (lineStartsWith("connection:"))
+        {
+            const char *value = headerValue(11);
+            connectionClose = strncasecmp(value, "close", 5) == 0;
+        }
+        else if (lineStartsWith("transfer-encoding:"))
+        {
+            // 'chunked' ist immer die letzte Kodierung
+            chunked = lineLength >= 25 && strncasecmp(line + lineLength - 7, "chunked", 7) == 0;
+        }
+    }
+
+    /**
+     *
+     * Liest ein Zeichen eines Bodys mit 'Transfer-Encoding: chunked':
+     * Größe in Hex (Erweiterungen nach ';' werden ignoriert), CRLF, Daten,
+     * CRLF. Ein Chunk der Größe 0 beendet den Body, danach folgen
+     * optionale Trailer und eine leere Zeile. Liefert true für Daten.
+     *
+     **/
+    bool feedChunked(char c)
+    {
+        switch (state)
+        {
+        case HTTP_CHUNK_DATA:
+            bodyRead++;
+            if (--chunkRemaining == 0)
+            {
+                state = HTTP_CHUNK_END;
+            }
+            return true;
+        case HTTP_CHUNK_END:
+            if (c == '\n')
+            {
+                state = HTTP_CHUNK_SIZE;
+            }
+            return false;
+        case HTTP_CHUNK_SIZE:
+            if (c == '\n')
+            {
+                state = chunkRemaining > 0 ? HTTP_CHUNK_DATA : HTTP_TRAILER;
+                chunkExtension = false;
+                lineLength = 0;
+            }
+            else if (c == ';')
+            {
+                chunkExtension = true;
+            }
+            else if (!chunkExtension && isxdigit(c) && chunkRemaining < 0x10000000UL)
+            {
+                chunkRemaining = chunkRemaining * 16 + (isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+            }
+            return false;
+        default:
+            // Trailer bis zur leeren Zeile
+            if (c == '\n')
+            {
+                state = lineLength == 0 ? HTTP_DONE : HTTP_TRAILER;
+                lineLength = 0;
+            }
+            else if (c != '\r')
+            {
+                lineLength = 1;
+            }
+            return false;
+        }
+    }
+
+public:
+    /**
+     *
+     * Bereitet das Lesen einer neuen Antwort vor.
+     *
+     **/
+    void begin()
+    {
+        state = HTTP_STATUS_LINE;
+        lineLength = 0;
+        statusCode = 0;
+        contentLength = -1;
+        bodyRead = 0;
+        connectionClose = false;
+        chunked = false;
+        bodyless = false;
+    }
+
+    /**
+     *
+     * Verarbeitet ein empfangenes Zeichen. Rückgabewert ist true wenn
+     * das Zeichen zum Body gehört, so kann der Aufrufer den Body selbst
+     * auswerten.
+     *
+     **/
+    bool feed(char c)
+    {
+        if (state == HTTP_BODY)
+        {
+            bodyRead++;
+            if (contentLength >= 0 && bodyRead >= (uint32_t)contentLength)
+            {
+                state = HTTP_DONE;
+            }
+            return true;
+        }
+
+        if (state == HTTP_DONE)
+        {
+            return false;
+        }
+
+        if (state >= HTTP_CHUNK_SIZE)
+        {
+            return feedChunked(c);
+        }
+
+        if (c == '\r')
+        {
+            return false;
+        }
+
+        if (c != '\n')
+        {
+            if (lineLength < HTTP_LINE_SIZE - 1)
+            {
+                line[lineLength++] = c;
+            }
+            return false;
+        }
+
+        line[lineLength] = '\0';
+        if (state == HTTP_STATUS_LINE)
+        {
+            parseStatusLine();
+        }
+        else
+        {
+            parseHeader();
+        }
+        lineLength = 0;
+        return false;
+    }
+
+    /**
+     *
+     * Muss aufgerufen werden wenn der Server die Verbindung schließt.
+     * Antworten ohne 'Content-Length' enden erst an dieser Stelle.
+     *
+     **/
+    void finish()
+    {
+        if (state == HTTP_BODY && contentLength < 0)
+        {
+            state = HTTP_DONE;
+        }
+    }
+
+    HttpParserState getState() { return state; }
+    bool isDone() { return state == HTTP_DONE; }
+    uint16_t getStatusCode() { return statusCode; }
+    int32_t getContentLength() { return contentLength; }
+
+    /**
+     *
+     * Liefert true wenn die Verbindung nach der Antwort weiter genutzt
+     * werden kann. Dafür muss das Ende des Bodys bekannt sein (Länge,
+     * Chunks oder kein Body) und der Server darf nicht 'Connection: close'
+     * gesendet haben.
+     *
+     **/
+    bool isKeepAlive()
+    {
+        return !connectionClose && (contentLength >= 0 || chunked || bodyless);
+    }
+};
+
+/**
+ *
+ * Liest die Zahlen eines Bodys Zeichen für Zeichen ohne Heap, z.B. die
+ * Antwort des Windrads "3.2,270,9.5,15.1" oder JSON wie
+ * {"speed":3.2,"direction":270}. Jede Zahl außerhalb von Zeichenketten ist
+ * ein Feld, gezählt wird in der Reihenfolge des Bodys. Die Werte werden in
+ * Hundertstel gespeichert, weitere Nachkommastellen werden abgeschnitten.
+ * Es werden höchstens 'HTTP_BODY_FIELDS' Felder gelesen.
+ *
+ **/
+class HttpBodyFields
+{
+private:
+    int32_t values[HTTP_BODY_FIELDS];
+    uint8_t count = 0;
+
+    // Zustand der aktuell gelesenen Zahl
+    int32_t current = 0;
+    uint8_t decimals = 0;
+    bool inNumber = false;
+    bool negative = false;
+    bool fraction = false;
+
+    // Ein '-' direkt vor der ersten Ziffer
+    bool minus = false;
+
+    // Zustand innerhalb einer JSON Zeichenkette
+    bool inString = false;
+    bool escaped = false;
+
+    void endNumber()
+    {
+        if (!inNumber)
+        {
+            return;
+        }
+        inNumber = false;
+
+        // Auf Hundertstel auffüllen
+        for (; decimals < 2; decimals++)
+        {
+            current *= 10;
+        }
+        if (count < HTTP_BODY_FIELDS)
+        {
+            values[count++] = negative ? -current : current;
+        }
+    }
+
+public:
+    /**
+     *
+     * Bereitet das Lesen eines neuen Bodys vor.
+     *
+     **/
+    void begin()
+    {
+        count = 0;
+        inNumber = false;
+        minus = false;
+        inString = false;
+        escaped = false;
+    }
+
+    /**
+     *
+     * Verarbeitet ein Zeichen des Bodys.
+     *
+     **/
+    void feed(char c)
+    {
+        if (inString)
+        {
+            if (escaped)
+            {
+                escaped = false;
+            }
+            else if (c == '\\')
+            {
+                escaped = true;
+            }
+            else if (c == '"')
+            {
+                inString = false;
+            }
+            return;
+        }
+
+        if (c >= '0' && c <= '9')
+        {
+            if (!inNumber)
+            {
+                inNumber = true;
+                negative = minus;
+                fraction = false;
+                current = 0;
+                decimals = 0;
+            }
+            // Weitere Nachkommastellen und zu große Werte werden ignoriert
+            if ((!fraction || decimals < 2) && current < 100000000L)
+            {
+                current = current * 10 + (c - '0');
+                if (fraction)
+                {
+                    decimals++;
+                }
+            }
+            minus = false;
+            return;
+        }
+
+        if (c == '.' && inNumber && !fraction)
+        {
+            fraction = true;
+            return;
+        }
+
+        endNumber();
+        minus = c == '-';
+        if (c == '"')
+        {
+            inString = true;
+        }
+    }
+
+    /**
+     *
+     * Muss am Ende des Bodys aufgerufen werden, schließt die letzte Zahl ab.
+     *
+     **/
+    void finish()
+    {
+        endNumber();
+    }
+
+    uint8_t size() const { return count; }
+    bool has(uint8_t field) const { return field < count; }
+
+    // Wert eines Feldes in Hundertstel
+    int32_t get(uint8_t field) const { return values[field]; }
+};
+
+#endif
@@ -4,16 +4,20 @@
 #include <SPI.h>
 #include <Wire.h>
 
-#include <Adafruit_BMP280.h>
-#include <Adafruit_HDC1000.h>
-#include <Makerblog_TSL45315.h>
-#include "SdsDustSensor.h"
-#include <VEML6070.h>
 #include <WiFi101.h>
 
 #include "measurement.h"
+#include "sensors.cpp"
 #include "display.cpp"
 #include "network.cpp"
+#include "pmsensor.cpp"
+#include "measurementlog.cpp"
+#include "scheduler.cpp"
+#include "profiler.cpp"
+#include "eventqueue.cpp"
+#include "power.cpp"
+#include "boot.cpp"
+#include "uploadpolicy.cpp"
 
 #include "utils.cpp"
 
@@ -26,40 +30,81 @@
 WSDisplay *display;
 #endif
 
-#ifdef BMP280_CONNECTED
-Adafruit_BMP280 bmp;
-#define P0 1013.25
-#endif
+// Ereignisse der Interrupts (Taster), werden in der Hauptschleife abgearbeitet
+EventQueue<inputEvent, INPUT_EVENT_QUEUE_SIZE> inputEvents;
 
-#ifdef HDC1080_CONNECTED
-Adafruit_HDC1000 hdc = Adafruit_HDC1000();
-#endif
+// Zeitpunkt des letzten angenommenen Tastendrucks, nur in der Hauptschleife benutzt
+unsigned long millisLastButton = 0;
 
-#ifdef TSL45315_CONNECTED
-Makerblog_TSL45315 tsl = Makerblog_TSL45315(TSL45315_TIME_M4);
-#endif
+// Kooperativer Scheduler, führt die Aufgaben der Sensoren,
+// des Netzwerks und des Displays zu ihren Zeiten aus.
+Scheduler scheduler;
+
+// Schritte des Starts, die Zeiten werden nach setup() ausgegeben
+BootSequencer boot;
+
+// Klasse zum übertragen der Messungen an openSenseMap
+Network network(SERVER_ADDRESS);
+
+// Alle in config.h aktivierten Sensoren (siehe sensors.cpp)
+Sensors sensors;
 
-#ifdef VEML6070_CONNECTED
-VEML6070 veml;
+// ID der Sensor Aufgabe im Scheduler, sie plant sich selbst neu
+int8_t sensorTask = -1;
+
+// ID der Netzwerk Abfrage, im Stromsparbetrieb ohne offenen Request seltener
+int8_t networkTask = -1;
+
+#ifdef ADAPTIVE_UPLOAD
+// Entscheidet in 'networkPostTask' ob gesendet wird
+UploadPolicy uploadPolicy;
+#define UPLOAD_TASK_INTERVAL UPLOAD_CHECK_INTERVAL
+#else
+#define UPLOAD_TASK_INTERVAL OSM_REFRESH_INTERVAL
 #endif
 
+// Anzahl der Aufgaben welche setup() registriert, mit den gleichen
+// Bedingungen: Sensoren, Netzwerk Abfrage und Post sowie optional Windrad,
+// PM Sensor, Profiling und Display (Aktualisierung und Standby).
+const uint8_t SETUP_TASKS = 3
+#ifdef WINDRAD_CONNECTED
+                            + 1
+#endif
 #ifdef PM_CONNECTED
-SdsDustSensor sds(Serial1); // passing HardwareSerial& as parameter
+                            + 1
 #endif
+#ifdef ENABLE_PROFILING
+                            + 1
+#endif
+#ifdef SSD1306_CONNECTED
+                            + 2
+#endif
+    ;
+static_assert(SETUP_TASKS <= SCHEDULER_MAX_TASKS, "setup() registers more tasks than SCHEDULER_MAX_TASKS");
 
-// TODO: Auslagern
-const int BUTTON_PIN = 0;
-volatile unsigned long switchTime = 0, bounceTime = 15;
-
-unsigned long lastMillis1;
-
-// Klasse zum übertragen der Messungen an openSenseMap
-Network network(SERVER_ADDRESS);
+// Mittelwert, Minimum, Maximum und Standardabweichung aller Messungen
+// seit dem letzten Postrequest
+MeasurementAggregator aggregator;
 
 // Klasse welche alle Messungen sammelt und über Zeiger
 // mit anderen Klassen geteilt wird. (Display, Network)
 Measurment data;
 
+#ifdef PM_CONNECTED
+PmSensor pmSensor(PM_UART, &data);
+#endif
+
+#ifdef SD_CONNECTED
+// Dauerhaftes Log aller Messzyklen auf der SD Karte,
+// auf dem Host in einer normalen Datei
+#ifdef ARDUINO
+SdLogStorage logStorage;
+#else
+FileLogStorage logStorage;
+#endif
+MeasurementLog measurementLog;
+#endif
+
 /**
  * 
  * Überprüfe die I2C Schnittstelle nach verfügbaren Sensoren
@@ -128,249 +173,493 @@ void checkI2CSensors()
 void prepostSensorData()
 {
   DEBUG(F("[Prepostdata] has started"));
-// BMP280
-#ifdef BMP280_CONNECTED
-#ifdef TEMPERATURE_ID
-  network.addMeasurement(TEMPERATURE_ID, data.Temperature);
-#endif
-#ifdef PRESSURE_ID
-  network.addMeasurement(PRESSURE_ID, data.Pressure);
-#endif
-#ifdef ALTITUDE_ID
-  network.addMeasurement(ALTITUDE_ID, data.Altitude);
-#endif
-#endif
+  // Messungen seit der letzten Abfrage übernehmen (z.B. Feinstaub)
+  aggregator.collect(data);
+  sensors.upload(network, data, aggregator);
 
-// HDC1080
-#ifdef HDC1080_CONNECTED
-#ifdef TEMPERATURE_ID
-  network.addMeasurement(TEMPERATUR_ID, data.Temperature);
+  // Längste Schleife in Hundertstel ms und Auslastung in Hundertstel %
+#if PROFILE_LOOP_CHANNELS
+  network.addMeasurement(PROFILE_LOOP_ID, profiler().getLoops().max / 10);
 #endif
-#ifdef HUMIDITY_ID
-  network.addMeasurement(HUMIDITY_ID, data.Humidity);
-#endif
-#endif
-
-// TSL45315
-#ifdef TSL45315_CONNECTED
-  network.addMeasurement(ILLUMINANCE_ID, data.Lux);
-#endif
-
-// VEML6070
-#ifdef VEML6070_CONNECTED
-  network.addMeasurement(UV_RADIATION_ID, data.UV);
-#endif
-
-//SDS011
-#ifdef PM_CONNECTED
-  network.addMeasurement(PM_PM25_ID, data.pm25);
-  network.addMeasurement(PM_PM10_ID, data.pm10);
+#if PROFILE_BUSY_CHANNELS
+  network.addMeasurement(PROFILE_BUSY_ID, profiler().busyShare());
 #endif
 
-// WINDRAD
-#ifdef WINDRAD_CONNECTED
-  network.addMeasurement(WINDRAD_DIRECTION_ID, data.Winddirection);
-  network.addMeasurement(WINDRAD_SPEED_ID, data.Windspeed);
+#ifdef ENABLE_DEBUG
+  for (uint8_t i = 0; i < FIELD_COUNT; i++)
+  {
+    const RunningStats &stats = aggregator.get((MeasurementField)i);
+    if (stats.count() > 0)
+    {
+      DEBUG2(F("[Prepostdata] Field "));
+      DEBUG2(i);
+      DEBUG2(F(": n="));
+      DEBUG2(stats.count());
+      DEBUG2(F(" mean="));
+      DEBUG2(stats.mean());
+      DEBUG2(F(" min="));
+      DEBUG2(stats.min());
+      DEBUG2(F(" max="));
+      DEBUG2(stats.max());
+      DEBUG2(F(" sd="));
+      DEBUG(stats.stddev());
+    }
+  }
 #endif
 
+  aggregator.reset();
   DEBUG(F("[Prepostdata] was completed..."));
 }
 
 /**
  * 
- * Aktuallisert die Sensordaten
- * wird in der loop() Methode aufgerufen.
+ * Aktuallisert die Sensordaten, jeder Sensor wird in seinem eigenen
+ * Intervall gelesen. Messungen werden nur gestartet bzw. abgeholt, während
+ * einer Wandlung laufen die anderen Aufgaben. Die Aufgabe wird auf den
+ * nächsten von 'Sensors::poll' gemeldeten Zeitpunkt neu geplant.
  * 
  **/
 void updateSensorData()
 {
-// BMP280
-#ifdef BMP280_CONNECTED
-  data.Temperature = bmp.readTemperature();
-  data.Pressure = bmp.readPressure() / 100;
-  data.Altitute = bmp.readAltitude(1013.25);
-#endif
+  PROFILE_SCOPE(PROFILE_SENSORS);
+  unsigned long wait = sensors.poll(data, millis());
+  aggregator.collect(data);
+  scheduler.reschedule(sensorTask, wait);
+}
 
-// HDC1080
-#ifdef HDC1080_CONNECTED
-  data.Temperature = hdc.readTemperature();
-  delay(200);
-  data.Humidity = hdc.readHumidity();
+/**
+ * 
+ * Nach einem Request die Antwort wieder im Intervall 'NETWORK_POLL_INTERVAL'
+ * abfragen, ohne Stromsparbetrieb geschieht das ohnehin.
+ * 
+ **/
+void pollNetworkSoon()
+{
+#ifdef LOW_POWER_MODE
+  scheduler.reschedule(networkTask, NETWORK_POLL_INTERVAL);
 #endif
+}
+
+#ifdef WINDRAD_CONNECTED
+/**
+ * 
+ * Fragt das Windrad im Intervall 'SENSOR_REFRESH_INTERVAL' ab. Die Antwort
+ * wird von 'networkPollTask' gelesen und mit 'applyWindradValues' übernommen.
+ * 
+ **/
+void windradTask()
+{
+  PROFILE_SCOPE(PROFILE_WINDRAD);
+  IPAddress addrx(PM_IPADDR);
+  network.getValuesFromUrl(&addrx, 80);
+  pollNetworkSoon();
+}
 
-// TSL45315
-#ifdef TSL45315_CONNECTED
-  data.Lux = tsl.readLux();
+/**
+ * 
+ * Übernimmt die Werte der letzten Antwort des Windrads, nicht enthaltene
+ * Felder behalten ihren bisherigen Wert.
+ * 
+ **/
+void applyWindradValues()
+{
+  const HttpBodyFields &values = network.getUrlValues();
+  if (values.has(WINDRAD_SPEED_FIELD))
+  {
+    data.Windspeed.setHundredths(values.get(WINDRAD_SPEED_FIELD));
+    data.setValid(FIELD_WINDSPEED);
+  }
+  if (values.has(WINDRAD_DIRECTION_FIELD))
+  {
+    data.Winddirection.setHundredths(values.get(WINDRAD_DIRECTION_FIELD));
+    data.setValid(FIELD_WINDDIRECTION);
+  }
+#ifdef PM_CONNECTED
+  if (values.has(WINDRAD_PM25_FIELD) && values.has(WINDRAD_PM10_FIELD))
+  {
+    data.pm25.setHundredths(values.get(WINDRAD_PM25_FIELD));
+    data.pm10.setHundredths(values.get(WINDRAD_PM10_FIELD));
+    data.setValid(FIELD_PM25);
+    data.setValid(FIELD_PM10);
+  }
+#endif
+}
 #endif
 
-// VEML6070
-#ifdef VEML6070_CONNECTED
-  data.UV = veml.getUV();
+/**
+ * 
+ * Schritte des Starts für den 'BootSequencer'. Jeder Schritt beginnt beim
+ * ersten Aufruf ('elapsed' ist 0) und gibt true zurück sobald er bereit ist,
+ * gewartet wird nur auf die Signale der Hardware, nicht mit delay().
+ * 
+ **/
+#ifdef ENABLE_DEBUG
+bool bootSerial(unsigned long elapsed)
+{
+  if (elapsed == 0)
+  {
+    Serial.begin(9600);
+  }
+  // Wartet auf den seriellen Monitor (USB)
+  return Serial || elapsed >= BOOT_SERIAL_TIMEOUT;
+}
 #endif
 
-//SDS011
-#ifdef PM_CONNECTED
-  sds.wakeup();
-  PmResult pm = sds.queryPm();
-  if (pm.isOk()) {
-    Serial.print("PM2.5 = ");
-    Serial.print(pm.pm25);
-    Serial.print(", PM10 = ");
-    Serial.println(pm.pm10);
-
-    // if you want to just print the measured values, you can use toString() method as well
-    Serial.println(pm.toString());
-  } else {
-    Serial.print("Could not read values from sensor, reason: ");
-    Serial.println(pm.statusToString());
+bool bootRadioPower(unsigned long elapsed)
+{
+  if (elapsed == 0)
+  {
+    senseBoxIO.SPIselectXB1();
+    senseBoxIO.powerXB1(false);
+    return false;
   }
+  if (elapsed < BOOT_POWER_CYCLE_TIME)
+  {
+    return false;
+  }
+  senseBoxIO.powerXB1(true);
+  return true;
+}
 
-  WorkingStateResult state = sds.sleep();
-  if (state.isWorking()) {
-    Serial.println("Problem with sleeping the sensor.");
-  } else {
-    Serial.println("Sensor is sleeping");
-    delay(60000); // wait 1 minute
+bool bootI2CPower(unsigned long elapsed)
+{
+  if (elapsed == 0)
+  {
+    senseBoxIO.powerI2C(false);
+    return false;
   }
-#endif
+  if (elapsed < BOOT_POWER_CYCLE_TIME)
+  {
+    return false;
+  }
+  senseBoxIO.powerI2C(true);
+  if (elapsed < BOOT_POWER_CYCLE_TIME + BOOT_I2C_POWER_UP)
+  {
+    return false;
+  }
+  Wire.begin();
+  return true;
+}
 
-#ifdef WINDRAD_CONNECTED
-  IPAddress addrx(PM_IPADDR);
-  network.getValuesFromUrl(&addrx, 80);
-  data.Winddirection = network.windradDirection;
-  data.Windspeed = network.windradSpeed;
-#ifdef PM_CONNECTED
-  data.pm25 = network.pm25;
-  data.pm10 = network.pm10;
-#endif
-#endif
+/**
+ * 
+ * Startet nur die Verbindung mit dem Netzwerk, diese läuft danach in der
+ * Netzwerk Abfrage weiter. Bis dahin bleiben die Messungen im Ringpuffer.
+ * 
+ **/
+bool bootNetwork(unsigned long elapsed)
+{
+  network.initialize(NET_SSID, NET_PASS);
+  return true;
+}
+
+#ifdef SSD1306_CONNECTED
+bool bootDisplay(unsigned long elapsed)
+{
+  // Das Display antwortet auf seine Adresse sobald es bereit ist
+  Wire.beginTransmission(SCREEN_ADDRESS);
+  if (Wire.endTransmission() != 0 && elapsed < BOOT_I2C_TIMEOUT)
+  {
+    return false;
+  }
+  display = new WSDisplay(&data);
+  return true;
 }
+#endif
 
 /**
  * 
  * Initialisiere Sensoren
  * Wenn ein Sensor verfügbar ist und in der Konfiguration
  * aktiviert ist wird er hier für die Messungen vorbereitet.
- * 
- * Diese Methode wird einmalig in der setup() Methode aufgerufen.
+ * Bereit ist der Schritt mit der ersten Messung für Display und ersten
+ * Postrequest, die Wandlungen der Sensoren überlappen dabei.
  * 
  **/
-void initSensors()
+bool bootSensors(unsigned long elapsed)
 {
-  DEBUG(F("Initializing sensors..."));
-
-#ifdef HDC1080_CONNECTED
-  hdc.begin();
-#endif
-#ifdef BMP280_CONNECTED
-  bmp.begin(0x76);
-#endif
-#ifdef VEML6070_CONNECTED
-  veml.begin();
-  delay(500);
-#endif
-#ifdef TSL45315_CONNECTED
-  tsl.begin();
+  if (elapsed == 0)
+  {
+    DEBUG(F("Initializing sensors..."));
+#ifdef ENABLE_DEBUG
+    checkI2CSensors();
 #endif
+    sensors.begin(millis());
 #ifdef PM_CONNECTED
-  //PM_UART.begin(9600);
-  sds.begin();
-  Serial.println(sds.queryFirmwareVersion().toString()); // prints firmware version
-  Serial.println(sds.setQueryReportingMode().toString());
+    PM_UART.begin(9600);
+    pmSensor.begin();
 #endif
+  }
 
+  sensors.poll(data, millis());
+  if (!sensors.complete())
+  {
+    return false;
+  }
+  aggregator.collect(data);
   DEBUG(F("Initializing sensors done!"));
-  delay(3000);
+  return true;
 }
 
+#ifdef SD_CONNECTED
+// Öffne das Messdaten Log, die Schreibposition wird nach einem Reset wiederhergestellt
+// (binäre Suche, nur wenige Blöcke werden gelesen)
+bool bootLog(unsigned long elapsed)
+{
+  senseBoxIO.powerXB2(true);
+#ifdef ARDUINO
+  if (logStorage.begin(SD_CS_PIN, LOG_FILE_NAME))
+#else
+  if (logStorage.begin(LOG_FILE_NAME))
+#endif
+  {
+    measurementLog.begin(logStorage, LOG_CAPACITY_BLOCKS);
+  }
+  return true;
+}
+#endif
+
 /**
  * 
- * Interrupt Methode, diese Methode hört auf den Pin 0 (Switch) und unterbricht die
- * Hauptprogramm Routine für die Abfrage des Tasters.
- * Es wird auf die nächste Seite des Displays gewechselt. 
+ * Interrupt Methode, diese Methode hört auf den Pin 'BUTTON_PIN' (Switch).
+ * Es wird nur ein Ereignis mit Zeitstempel abgelegt, der Seitenwechsel
+ * (I2C Übertragung) erfolgt in 'handleInputEvents' außerhalb des Interrupts.
  * 
  **/
 void switchPress()
 {
-  if ((millis() - switchTime) > bounceTime)
+  inputEvent event;
+  event.type = EVENT_BUTTON;
+  event.time = millis();
+  inputEvents.push(event);
+}
+
+/**
+ * 
+ * Arbeitet die Ereignisse der Interrupts ab. Der Taster wird über den
+ * Zeitstempel entprellt, weitere Flanken innerhalb 'BUTTON_DEBOUNCE_TIME'
+ * werden verworfen. Wird in jedem Durchlauf der loop() Methode aufgerufen.
+ * 
+ **/
+void handleInputEvents()
+{
+  inputEvent event;
+  while (inputEvents.pop(event))
   {
+    if (event.type == EVENT_BUTTON && (event.time - millisLastButton) > BUTTON_DEBOUNCE_TIME)
+    {
+      millisLastButton = event.time;
 #ifdef SSD1306_CONNECTED
-    display->nextPage();
-    switchTime = millis();
+      display->nextPage();
 #endif
+    }
   }
 }
 
 /**
  * 
- * Hauptroutine, zu jeweiligen Zeiten wird eine Aktion der verschiedenen
- * Programmteile ausgeführt.
+ * Aufgaben für den Scheduler, diese verbinden die Methoden der
+ * Feinstaub, Netzwerk und Display Klasse mit dem Scheduler.
  * 
  **/
-void loop()
+#ifdef PM_CONNECTED
+void pmTask()
+{
+  PROFILE_SCOPE(PROFILE_PM);
+  pmSensor.handle();
+}
+#endif
+
+void networkPollTask()
 {
-  // Routine für die Aktualisierung der Sensor Daten beginnt.
-  // TODO: Auslagerung der SensorDaten Methode in eine eigene Klasse.
-  if ((millis() - lastMillis1) >= 10e3)
+  PROFILE_SCOPE(PROFILE_NETWORK_POLL);
+  network.handleClient();
+#ifdef WINDRAD_CONNECTED
+  if (network.takeUrlValues())
   {
-    updateSensorData();
-    //TODO: Display (Fehler, Warnungen) behandeln.
-    lastMillis1 = millis();
+    applyWindradValues();
   }
-
-  // Netzwerk Klasse übernimmt aufgaben,
-  // zuvor wird die 'prepostSensorData' Methode aufgerufen.
-  network.networkHandle(prepostSensorData);
-
-  // Display Klasse übernimmt ihre Aufgaben.
-  // Anzeigen von verschiedenen Seiten.
-  display->handleDisplay();
+#endif
+#ifdef LOW_POWER_MODE
+  if (network.isIdle())
+  {
+    scheduler.reschedule(networkTask, POWER_IDLE_POLL_INTERVAL);
+  }
+#endif
 }
 
-void setup()
+/**
+ * 
+ * Sendet die Messungen, mit ADAPTIVE_UPLOAD nur wenn 'uploadPolicy' es
+ * wegen einer Änderung oder dem abgelaufenen Intervall verlangt.
+ * 
+ **/
+void networkPostTask()
 {
-#ifdef ENABLE_DEBUG
-  Serial.begin(9600);
+  {
+    PROFILE_SCOPE(PROFILE_NETWORK_POST);
+#ifdef ADAPTIVE_UPLOAD
+    uploadPolicy.link(network.getLink().averageRssi(), network.lastPostLatency);
+    if (uploadPolicy.check(data, millis()) == UPLOAD_WAIT)
+    {
+      return;
+    }
 #endif
-  delay(5000);
-
-  DEBUG2(F("xbee1 spi enable..."));
-  senseBoxIO.SPIselectXB1();
-  DEBUG(F("done"));
-  senseBoxIO.powerXB1(false);
-  delay(200);
-  DEBUG2(F("xbee1 power on..."));
-  senseBoxIO.powerXB1(true);
-  DEBUG(F("done"));
-  senseBoxIO.powerI2C(false);
-  delay(200);
-  senseBoxIO.powerI2C(true);
-  delay(2000);
+    // Zuvor wird die 'prepostSensorData' Methode aufgerufen.
+    network.networkHandle(prepostSensorData);
+    pollNetworkSoon();
+  }
 
-#ifdef ENABLE_DEBUG
-  Wire.begin();
-  checkI2CSensors();
+#ifdef SD_CONNECTED
+  // Die gesammelten Messungen zusätzlich im Log ablegen
+  PROFILE_SCOPE(PROFILE_LOG);
+  // Einträge ohne Uhrzeit warten bis zur ersten Synchronisation
+  uint32_t epoch = network.toEpoch(millis());
+  if (epoch != 0)
+  {
+    measurementLog.release(epoch, millis());
+  }
+  storedMeasurements *entry = network.latestMeasurements();
+  if (entry != NULL)
+  {
+    logRecord record;
+    memset(&record, 0, sizeof(record));
+    record.timestamp = network.toEpoch(entry->millisCollected);
+    record.count = entry->count;
+    record.valid = entry->valid;
+    memcpy(record.values, entry->values, sizeof(record.values));
+    if (record.timestamp != 0)
+    {
+      measurementLog.append(record);
+    }
+    else
+    {
+      measurementLog.hold(record, entry->millisCollected);
+    }
+  }
 #endif
+}
 
-// Initialisiere Display
 #ifdef SSD1306_CONNECTED
-  display = new WSDisplay(&data);
+void displayRefreshTask()
+{
+  PROFILE_SCOPE(PROFILE_DISPLAY);
+  display->refreshDisplay();
+}
+
+void displayStandbyTask()
+{
+  PROFILE_SCOPE(PROFILE_DISPLAY);
+  display->handleStandby();
+}
 #endif
 
-  // Initialisiere Netzwerk
-  network.initialize(NET_SSID, NET_PASS);
+#ifdef ENABLE_PROFILING
+void profileReportTask()
+{
+  profiler().report(Serial);
+  profiler().reset();
+  network.getLink().report(Serial);
+#ifdef ADAPTIVE_UPLOAD
+  uploadPolicy.report(Serial);
+#endif
+}
+#endif
+
+/**
+ * 
+ * Hauptroutine, der Scheduler führt zu den jeweiligen Zeiten
+ * eine Aktion der verschiedenen Programmteile aus.
+ * 
+ **/
+void loop()
+{
+  power().wake();
+  {
+    PROFILE_LOOP();
+    handleInputEvents();
+    scheduler.run();
+  }
 
-  // Setzte auf Pin 0 (Switch Button) ein interrupt
-  pinMode(0, INPUT);
-  attachInterrupt(0, switchPress, LOW);
+  // Bis zur nächsten Aufgabe, dem Taster oder dem WiFi Modul schlafen
+#ifdef LOW_POWER_MODE
+  power().sleep(scheduler.timeUntilNext());
+#endif
+}
 
-  initSensors();
-  updateSensorData();
+#if defined(LOW_POWER_MODE) && defined(ARDUINO)
+// Alarm des RTC, weckt aus dem Standby
+extern "C" void RTC_Handler(void)
+{
+  power().rtcInterrupt();
+}
+#endif
 
-  lastMillis1 = millis();
+void setup()
+{
+  PROFILE_SCOPE(PROFILE_SETUP);
+  // Setzte auf den Switch Button ein interrupt, ausgelöst wird beim Drücken.
+  // (Bei LOW würde der Interrupt solange der Taster gedrückt ist wiederholt.)
+  pinMode(BUTTON_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), switchPress, FALLING);
+
+  // WiFi Modul und I2C Sensoren werden gleichzeitig neu gestartet, das
+  // Verbinden mit dem Netzwerk läuft nach dem Start weiter.
+#ifdef ENABLE_DEBUG
+  boot.add("serial", bootSerial);
+#endif
+  int8_t radio = boot.add("radio", bootRadioPower);
+  int8_t i2c = boot.add("i2c", bootI2CPower);
+  boot.add("network", bootNetwork, BOOT_AFTER(radio));
+#ifdef SSD1306_CONNECTED
+  boot.add("display", bootDisplay, BOOT_AFTER(i2c));
+#endif
+  boot.add("sensors", bootSensors, BOOT_AFTER(i2c));
+#ifdef SD_CONNECTED
+  boot.add("log", bootLog, BOOT_AFTER(radio));
+#endif
+  boot.run();
+#ifdef ENABLE_DEBUG
+  boot.report(Serial);
+#endif
 
-// Aktualisiere Display Zeiten um aktiv zu bleiben
+// Aktualisiere Display Zeiten um aktiv zu bleiben. Vor den Aufgaben, die
+// Übertragung zum Display würde sonst als Verspätung der ersten Aufgaben zählen.
 #ifdef SSD1306_CONNECTED
   display->adjustmentMillis();
 #endif
+
+  // Registriere die Aufgaben beim Scheduler.
+  // TODO: Display (Fehler, Warnungen) nach der Sensor Aktualisierung behandeln.
+  sensorTask = scheduler.addPeriodic(updateSensorData, Sensors::period, Sensors::period);
+#ifdef WINDRAD_CONNECTED
+  scheduler.addPeriodic(windradTask, SENSOR_REFRESH_INTERVAL, SENSOR_REFRESH_INTERVAL);
+#endif
+#ifdef PM_CONNECTED
+  scheduler.addPeriodic(pmTask, PM_POLL_INTERVAL);
+#endif
+  networkTask = scheduler.addPeriodic(networkPollTask, NETWORK_POLL_INTERVAL);
+  scheduler.addPeriodic(networkPostTask, UPLOAD_TASK_INTERVAL, UPLOAD_TASK_INTERVAL);
+#ifdef ENABLE_PROFILING
+  scheduler.addPeriodic(profileReportTask, PROFILE_REPORT_INTERVAL, PROFILE_REPORT_INTERVAL);
+#endif
+#ifdef SSD1306_CONNECTED
+  scheduler.addPeriodic(displayRefreshTask, SCREEN_REFRESH_INTERVAL, SCREEN_REFRESH_INTERVAL);
+  scheduler.addPeriodic(displayStandbyTask, SCREEN_STANDBY_CHECK_INTERVAL);
+#endif
+  // Eine fehlende Aufgabe würde sonst unbemerkt nie ausgeführt
+  if (scheduler.getTaskCount() != SETUP_TASKS)
+  {
+    DEBUG(F("[Setup] Task count differs from SETUP_TASKS, check SCHEDULER_MAX_TASKS"));
+    while (true)
+      ;
+  }
+
+  // Die Initialisierung soll nicht in die Statistiken des Schedulers
+  // und das Energiemodell eingehen.
+  scheduler.resetStatistics();
+  power().begin(BUTTON_PIN);
+#ifdef ADAPTIVE_UPLOAD
+  uploadPolicy.begin(uploadedFields<Sensors>(), millis());
+#endif
 }
\ No newline at end of file
@@ -1,19 +1,218 @@
 #ifndef __MEASUREMENT_H_INC__
 #define __MEASUREMENT_H_INC__
 
+#include <stdint.h>
+
+/**
+ *
+ * Messwert als Festkommazahl, 'SCALE' ist der Faktor zur Einheit
+ * (z.B. 100 für 0.01 °C). Der Typ 'T' bestimmt den Speicherbedarf.
+ * Für Anzeige und Übertragung wird der Wert in Hundertstel der Einheit
+ * benötigt, die Umrechnung wird zur Compile-Zeit festgelegt.
+ *
+ **/
+template <typename T, int32_t SCALE>
+class FixedValue
+{
+    static_assert(SCALE > 0 && (100 % SCALE == 0 || SCALE % 100 == 0),
+                  "SCALE must divide 100 or be a multiple of 100");
+
+public:
+    T raw = 0;
+
+    static const int32_t scale = SCALE;
+
+    // Wertebereich von 'T', für vorzeichenlose Typen ist das Minimum 0
+    static constexpr T maxRaw = (T)-1 < 0 ? (T)((1ULL << (8 * sizeof(T) - 1)) - 1) : (T)~(T)0;
+    static constexpr T minRaw = (T)-1 < 0 ? (T)(-maxRaw - 1) : (T)0;
+
+    /**
+     *
+     * Übernimmt einen Wert eines Sensortreibers, kaufmännisch gerundet.
+     * Werte außerhalb des Bereichs von 'T' werden begrenzt, z.B. eine negative
+     * Beleuchtungsstärke auf 0. Bei NaN (Sensor nicht lesbar) bleibt der
+     * letzte Wert erhalten.
+     *
+     **/
+    FixedValue &operator=(float value)
+    {
+        float scaled = value * SCALE;
+        if (scaled != scaled)
+        {
+            return *this;
+        }
+
+        if (scaled >= (float)maxRaw)
+        {
+            raw = maxRaw;
+        }
+        else if (scaled <= (float)minRaw)
+        {
+            raw = minRaw;
+        }
+        else
+        {
+            raw = (T)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+        }
+        return *this;
+    }
+
+    void setRaw(int32_t value)
+    {
+        raw = (T)value;
+    }
+
+    // Übernimmt einen Wert in Hundertstel der Einheit, Umkehrung von 'hundredths'
+    void setHundredths(int32_t value)
+    {
+        raw = SCALE >= 100 ? (T)(value * (SCALE / 100)) : (T)(value / (100 / SCALE));
+    }
+
+    /**
+     *
+     * Wert in Hundertstel der Einheit, z.B. 2153 für 21.53 °C.
+     *
+     **/
+    int32_t hundredths() const
+    {
+        return SCALE >= 100 ? (int32_t)raw / (SCALE / 100) : (int32_t)raw * (100 / SCALE);
+    }
+
+    float toFloat() const
+    {
+        return (float)raw / SCALE;
+    }
+};
+
+/**
+ *
+ * Bits der Gültigkeitsmaske in 'Measurment::valid'.
+ *
+ **/
+enum MeasurementField
+{
+    FIELD_TEMPERATURE,
+    FIELD_PRESSURE,
+    FIELD_ALTITUDE,
+    FIELD_HUMIDITY,
+    FIELD_LUX,
+    FIELD_UV,
+    FIELD_WINDSPEED,
+    FIELD_WINDDIRECTION,
+    FIELD_PM25,
+    FIELD_PM10,
+    FIELD_HDC1080_TEMPERATURE,
+    // Abgeleitete Werte (derived.cpp)
+    FIELD_SEA_LEVEL_PRESSURE,
+    FIELD_DEW_POINT,
+    FIELD_PRESSURE_TENDENCY,
+    FIELD_AQI,
+    FIELD_COUNT
+};
+
+/**
+ *
+ * Alle Messwerte der Wetterstation als Festkommazahlen. Felder werden erst
+ * durch 'setValid' gültig, so kann zwischen "noch nicht gemessen" und 0
+ * unterschieden werden. 'setValid' markiert das Feld außerdem als neu
+ * gemessen, bis 'takeUpdated' den Wert abholt. Die Felder sind nach Größe
+ * sortiert, damit kein Füllbyte entsteht.
+ *
+ **/
 class Measurment
 {
 public:
-    double Temperature;
-    double Pressure;
-    double Altitute;
-    double Humidity;
-    double Lux;
-    double UV;
-    double Windspeed;
-    int Winddirection;
-    double pm25;
-    double pm10;
+    FixedValue<int32_t, 100> Pressure;           // hPa, entspricht Pa
+    FixedValue<int32_t, 100> Altitute;           // m, entspricht cm
+    FixedValue<uint32_t, 1> Lux;                 // lx
+    FixedValue<int32_t, 100> SeaLevelPressure;   // hPa, auf Meereshöhe reduziert
+    FixedValue<int16_t, 100> Temperature;        // °C
+    FixedValue<int16_t, 100> Hdc1080Temperature; // °C, Sensor des HDC1080
+    FixedValue<uint16_t, 100> Humidity;          // %
+    FixedValue<uint16_t, 1> UV;                  // µW/cm²
+    FixedValue<uint16_t, 100> Windspeed;         // m/s
+    FixedValue<int16_t, 1> Winddirection;        // °
+    FixedValue<uint16_t, 10> pm25;               // µg/m³
+    FixedValue<uint16_t, 10> pm10;               // µg/m³
+    FixedValue<int16_t, 100> DewPoint;           // °C
+    FixedValue<int16_t, 100> PressureTendency;   // hPa in 3 Stunden
+    FixedValue<uint16_t, 1> Aqi;                 // Index 0 bis 500
+    uint16_t valid = 0;
+    uint16_t updated = 0;
+
+    void setValid(MeasurementField field)
+    {
+        valid |= 1 << field;
+        updated |= 1 << field;
+    }
+
+    void setInvalid(MeasurementField field)
+    {
+        valid &= ~(1 << field);
+    }
+
+    bool isValid(MeasurementField field) const
+    {
+        return valid & (1 << field);
+    }
+
+    // Liefert true wenn das Feld seit dem letzten Aufruf neu gemessen wurde
+    bool takeUpdated(MeasurementField field)
+    {
+        bool result = updated & (1 << field);
+        updated &= ~(1 << field);
+        return result;
+    }
+
+    /**
+     *
+     * Wert eines Feldes in Hundertstel der Einheit. Wird 'field' zur
+     * Compile-Zeit übergeben (Sensor Registry), entfällt der switch.
+     *
+     **/
+    int32_t hundredths(MeasurementField field) const
+    {
+        switch (field)
+        {
+        case FIELD_TEMPERATURE:
+            return Temperature.hundredths();
+        case FIELD_PRESSURE:
+            return Pressure.hundredths();
+        case FIELD_ALTITUDE:
+            return Altitute.hundredths();
+        case FIELD_HUMIDITY:
+            return Humidity.hundredths();
+        case FIELD_LUX:
+            return Lux.hundredths();
+        case FIELD_UV:
+            return UV.hundredths();
+        case FIELD_WINDSPEED:
+            return Windspeed.hundredths();
+        case FIELD_WINDDIRECTION:
+            return Winddirection.hundredths();
+        case FIELD_PM25:
+            return pm25.hundredths();
+        case FIELD_PM10:
+            return pm10.hundredths();
+        case FIELD_HDC1080_TEMPERATURE:
+            return Hdc1080Temperature.hundredths();
+        case FIELD_SEA_LEVEL_PRESSURE:
+            return SeaLevelPressure.hundredths();
+        case FIELD_DEW_POINT:
+            return DewPoint.hundredths();
+        case FIELD_PRESSURE_TENDENCY:
+            return PressureTendency.hundredths();
+        case FIELD_AQI:
+            return Aqi.hundredths();
+        default:
+            break;
+        }
+        return 0;
+    }
 };
 
-#endif
\ No newline at end of file
+// 42 Bytes Felder, aufgerundet auf die Ausrichtung von 'int32_t'
+static_assert(sizeof(Measurment) == 44, "Measurment should stay packed");
+static_assert(FIELD_COUNT <= 16, "valid and updated hold one bit per field");
+
+#endif
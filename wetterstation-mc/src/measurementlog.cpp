@@ -0,0 +1,418 @@
+#include <Arduino.h>
+#include "config.h"
+#include "utils.cpp"
+#include "sensors.cpp"
+#include "storage.cpp"
+#include "ringbuffer.cpp"
+
+#ifndef __MEASUREMENTLOG_H_INC__
+#define __MEASUREMENTLOG_H_INC__
+
+// Kennung eines gültigen Blocks ("WSLG")
+#define LOG_MAGIC 0x474C5357
+
+/**
+ *
+ * Ein Eintrag im Messdaten Log, entspricht einem Messzyklus.
+ * 'timestamp' ist die Unix Zeit (0 wenn unbekannt), 'values' die
+ * Messwerte in Hundertstel in der Reihenfolge von 'Network::measurements',
+ * 'valid' die Gültigkeitsmaske wie in 'storedMeasurements'.
+ *
+ **/
+typedef struct logRecord
+{
+    uint32_t timestamp;
+    int32_t values[NUM_SENSORS];
+    uint16_t valid;
+    uint8_t count;
+} logRecord;
+
+/**
+ *
+ * Ein Eintrag wie er im Block steht. Die CRC32 Prüfsumme deckt die
+ * Sequenznummer des Blocks und den Eintrag ab, Einträge einer früheren
+ * Runde durch den Ringpuffer gelten daher nicht mehr als gültig.
+ *
+ **/
+typedef struct logSlot
+{
+    logRecord record;
+    uint32_t crc;
+} logSlot;
+
+/**
+ *
+ * Kopf eines Blocks. 'sequence' wird mit jedem neuen Block hochgezählt,
+ * 'recordSize' erkennt Logs mit einer anderen Anzahl an Sensoren.
+ * Der Kopf wird nur einmal, zusammen mit dem ersten Eintrag, geschrieben.
+ *
+ **/
+typedef struct logBlockHeader
+{
+    uint32_t magic;
+    uint32_t sequence;
+    uint16_t recordSize;
+    uint16_t reserved;
+    uint32_t crc;
+} logBlockHeader;
+
+// Aufbau eines Blocks: Kopf | Eintrag + CRC32 | ... | ungenutzt
+#define LOG_RECORDS_PER_BLOCK ((LOG_BLOCK_SIZE - sizeof(logBlockHeader)) / sizeof(logSlot))
+
+static_assert(LOG_RECORDS_PER_BLOCK > 0, "LOG_BLOCK_SIZE is too small for one logRecord");
+
+/**
+ *
+ * Eintrag welcher noch auf die Uhrzeit wartet, siehe 'MeasurementLog::hold'.
+ *
+ **/
+typedef struct pendingLogRecord
+{
+    uint32_t millisCollected;
+    logRecord record;
+} pendingLogRecord;
+
+/**
+ *
+ * Messdaten Log, welches Einträge nur anhängt (append-only).
+ * Das Log besteht aus Blöcken fester Größe ('LOG_BLOCK_SIZE') mit einer
+ * Sequenznummer, Block 's' liegt immer an Position 's % blocks'. Jeder Eintrag
+ * hat eine eigene CRC32 Prüfsumme und wird einzeln an seine Position im Block
+ * geschrieben, bereits geschriebene Einträge werden nicht mehr angefasst. Bei
+ * einem Reset während des Schreibens geht daher höchstens dieser Eintrag
+ * verloren, vorausgesetzt die SD Karte schreibt einen Sektor am Stück.
+ *
+ * Ist der Speicher voll, wird der älteste Block überschrieben (Ringpuffer).
+ * Nach einem Neustart findet 'begin' die Schreibposition über eine binäre
+ * Suche nach dem neuesten Block, dafür werden höchstens log2(blocks) + 3
+ * Blockköpfe gelesen statt des ganzen Speichers.
+ *
+ **/
+class MeasurementLog
+{
+private:
+    LogStorage *storage = NULL;
+
+    // Anzahl der Blöcke im Speicher
+    uint32_t blocks = 0;
+
+    // Der aktuelle Block im RAM, in diesen wird geschrieben
+    uint8_t block[LOG_BLOCK_SIZE];
+
+    // Sequenznummer und Anzahl der Einträge des aktuellen Blocks,
+    // sowie die Sequenznummer des ältesten noch vorhandenen Blocks
+    uint32_t sequence = 0;
+    uint16_t count = 0;
+    uint32_t oldestSequence = 0;
+
+    // Einträge welche vor der ersten Synchronisation der Uhrzeit entstanden sind
+    RingBuffer<pendingLogRecord, LOG_PENDING_RECORDS> pending;
+
+    /**
+     *
+     * CRC32 (IEEE 802.3) ohne Tabelle, spart 1 KB Flash.
+     * Mit 'crc' kann eine Prüfsumme über mehrere Bereiche fortgesetzt werden.
+     *
+     **/
+    static uint32_t crc32(const uint8_t *data, uint16_t length, uint32_t crc = 0)
+    {
+        crc = ~crc;
+        for (uint16_t i = 0; i < length; i++)
+        {
+            crc ^= data[i];
+            for (uint8_t j = 0; j < 8; j++)
+            {
+                crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+            }
+        }
+        return ~crc;
+    }
+
+    static uint32_t slotCrc(uint32_t sequence, const logRecord &record)
+    {
+        uint32_t crc = crc32((const uint8_t *)&sequence, sizeof(sequence));
+        return crc32((const uint8_t *)&record, sizeof(logRecord), crc);
+    }
+
+    logBlockHeader *header(uint8_t *buffer)
+    {
+        return (logBlockHeader *)buffer;
+    }
+
+    logSlot *slots(uint8_t *buffer)
+    {
+        return (logSlot *)(buffer + sizeof(logBlockHeader));
+    }
+
+    uint32_t offset(uint32_t sequence)
+    {
+        return (sequence % blocks) * LOG_BLOCK_SIZE;
+    }
+
+    /**
+     *
+     * Prüft Kennung, Format und Prüfsumme eines Blockkopfs.
+     *
+     **/
+    bool validHeader(logBlockHeader &h)
+    {
+        return h.magic == LOG_MAGIC && h.recordSize == sizeof(logRecord) &&
+               h.crc == crc32((const uint8_t *)&h, sizeof(logBlockHeader) - sizeof(uint32_t));
+    }
+
+    /**
+     *
+     * Liefert über 's' die Sequenznummer des Blocks an Position 'index',
+     * false wenn dort kein gültiger Block liegt. Liest nur den Kopf.
+     *
+     **/
+    bool blockSequence(uint32_t index, uint32_t &s)
+    {
+        logBlockHeader h;
+        if (!storage->read(index * LOG_BLOCK_SIZE, (uint8_t *)&h, sizeof(h)) || !validHeader(h) ||
+            h.sequence % blocks != index)
+        {
+            return false;
+        }
+        s = h.sequence;
+        return true;
+    }
+
+    /**
+     *
+     * Liest den Block mit der Sequenznummer 's' nach 'buffer', false wenn
+     * der Block nicht (mehr) vorhanden ist.
+     *
+     **/
+    bool readBlock(uint32_t s, uint8_t *buffer)
+    {
+        return storage->read(offset(s), buffer, LOG_BLOCK_SIZE) && validHeader(*header(buffer)) &&
+               header(buffer)->sequence == s;
+    }
+
+    bool validSlot(uint8_t *buffer, uint16_t position)
+    {
+        logSlot &slot = slots(buffer)[position];
+        return slot.crc == slotCrc(header(buffer)->sequence, slot.record);
+    }
+
+    void startBlock(uint32_t sequence)
+    {
+        memset(block, 0, LOG_BLOCK_SIZE);
+        this->sequence = sequence;
+        count = 0;
+
+        logBlockHeader *h = header(block);
+        h->magic = LOG_MAGIC;
+        h->sequence = sequence;
+        h->recordSize = sizeof(logRecord);
+        h->crc = crc32(block, sizeof(logBlockHeader) - sizeof(uint32_t));
+
+        // Der neue Block überschreibt den ältesten, sobald der Speicher voll ist
+        if (sequence >= blocks && sequence - blocks + 1 > oldestSequence)
+        {
+            oldestSequence = sequence - blocks + 1;
+        }
+    }
+
+public:
+    // Statistik der geschriebenen Einträge und Schreibfehler
+    unsigned long appended = 0;
+    unsigned long writeErrors = 0;
+
+    /**
+     *
+     * Öffnet das Log im Speicher 'storage' mit 'blocks' Blöcken und stellt
+     * die Schreibposition wieder her. Rückgabewert ist die Anzahl der
+     * wiederhergestellten Einträge.
+     *
+     **/
+    uint32_t begin(LogStorage &storage, uint32_t blocks)
+    {
+        this->storage = &storage;
+        this->blocks = blocks;
+        oldestSequence = 0;
+
+        // Die Blöcke der aktuellen Runde liegen ab Position 0 mit lückenlos
+        // steigender Sequenznummer, dahinter folgen die der vorherigen Runde
+        // oder ungenutzte Blöcke. Gesucht ist der letzte Block der aktuellen Runde.
+        uint32_t first, newest;
+        if (blockSequence(0, first))
+        {
+            uint32_t low = 0;
+            uint32_t high = blocks;
+            while (high - low > 1)
+            {
+                uint32_t middle = low + (high - low) / 2;
+                uint32_t s;
+                if (blockSequence(middle, s) && s == first + middle)
+                {
+                    low = middle;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+            newest = first + low;
+        }
+        else if (!blockSequence(blocks - 1, newest))
+        {
+            // Leeres Log, oder der erste Block wurde beim Anlegen unterbrochen
+            startBlock(0);
+            return 0;
+        }
+
+        // Der älteste Block folgt auf den neuesten, außer er wurde gerade
+        // durch einen unterbrochenen Schreibvorgang ungültig
+        if (newest >= blocks)
+        {
+            uint32_t s;
+            oldestSequence = newest - blocks + 1;
+            if (!blockSequence(oldestSequence % blocks, s) || s != oldestSequence)
+            {
+                oldestSequence++;
+            }
+        }
+
+        // Einen nicht vollen Block weiter füllen, sonst mit dem nächsten beginnen.
+        // Nach einem Reset wird ein unvollständiger Eintrag überschrieben.
+        startBlock(newest);
+        readBlock(newest, block);
+        while (count < LOG_RECORDS_PER_BLOCK && validSlot(block, count))
+        {
+            count++;
+        }
+        if (count == LOG_RECORDS_PER_BLOCK)
+        {
+            startBlock(newest + 1);
+        }
+
+        DEBUG2(F("[Log] Recovered, records: "));
+        DEBUG(size());
+        return size();
+    }
+
+    /**
+     *
+     * Hängt einen Eintrag an das Log an. Geschrieben wird nur der neue
+     * Eintrag, beim ersten Eintrag eines Blocks zusammen mit dem Kopf.
+     * Schlägt das Schreiben fehl, wird die Position beim nächsten Mal
+     * erneut beschrieben.
+     *
+     **/
+    bool append(const logRecord &record)
+    {
+        if (storage == NULL)
+        {
+            return false;
+        }
+
+        if (count == LOG_RECORDS_PER_BLOCK)
+        {
+            startBlock(sequence + 1);
+        }
+
+        logSlot &slot = slots(block)[count];
+        slot.record = record;
+        slot.crc = slotCrc(sequence, record);
+
+        // Der letzte Eintrag schreibt den Rest des Blocks mit, so wächst die
+        // Datei um ganze Blöcke und der nächste Block beginnt an ihrem Ende
+        uint32_t start = count == 0 ? 0 : (uint8_t *)&slot - block;
+        uint32_t end = count == LOG_RECORDS_PER_BLOCK - 1 ? LOG_BLOCK_SIZE : (uint8_t *)&slot - block + sizeof(logSlot);
+        if (!storage->write(offset(sequence) + start, block + start, end - start))
+        {
+            writeErrors++;
+            return false;
+        }
+
+        count++;
+        appended++;
+        return true;
+    }
+
+    /**
+     *
+     * Hält einen Eintrag ohne Uhrzeit im RAM zurück, bis 'release' mit der
+     * Uhrzeit aufgerufen wird. So erhalten auch die Messungen vor der ersten
+     * Synchronisation einen Zeitstempel. Ist der Puffer voll, wird der
+     * älteste Eintrag ohne Zeitstempel geschrieben statt verworfen.
+     *
+     **/
+    void hold(const logRecord &record, uint32_t millisCollected)
+    {
+        if (pending.isFull())
+        {
+            append(pending.at(0).record);
+            pending.pop();
+        }
+
+        pendingLogRecord entry;
+        entry.millisCollected = millisCollected;
+        entry.record = record;
+        pending.push(entry);
+    }
+
+    /**
+     *
+     * Schreibt die zurückgehaltenen Einträge, 'epoch' ist die Unix Zeit
+     * zum Zeitpunkt 'now' (millis()).
+     *
+     **/
+    void release(uint32_t epoch, uint32_t now)
+    {
+        while (!pending.isEmpty())
+        {
+            pendingLogRecord &entry = pending.at(0);
+            entry.record.timestamp = epoch - (now - entry.millisCollected) / 1000;
+            if (!append(entry.record))
+            {
+                return;
+            }
+            pending.pop();
+        }
+    }
+
+    /**
+     *
+     * Anzahl der Einträge im Log, ohne die zurückgehaltenen.
+     *
+     **/
+    uint32_t size()
+    {
+        return (sequence - oldestSequence) * LOG_RECORDS_PER_BLOCK + count;
+    }
+
+    /**
+     *
+     * Liest den 'index'-ten Eintrag, 0 ist der älteste.
+     * Ältere Blöcke werden über einen Puffer auf dem Stack gelesen.
+     *
+     **/
+    bool read(uint32_t index, logRecord &record)
+    {
+        if (storage == NULL || index >= size())
+        {
+            return false;
+        }
+
+        uint32_t s = oldestSequence + index / LOG_RECORDS_PER_BLOCK;
+        uint16_t position = index % LOG_RECORDS_PER_BLOCK;
+        if (s == sequence)
+        {
+            record = slots(block)[position].record;
+            return true;
+        }
+
+        uint8_t buffer[LOG_BLOCK_SIZE];
+        if (!readBlock(s, buffer) || !validSlot(buffer, position))
+        {
+            return false;
+        }
+        record = slots(buffer)[position].record;
+        return true;
+    }
+};
+
+#endif
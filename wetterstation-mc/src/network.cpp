@@ -2,6 +2,23 @@
 #include <WiFi101.h>
 #include "config.h"
 #include "utils.cpp"
+#include "sensors.cpp"
+#include "upload.cpp"
+#include "encoding.cpp"
+#include "http.cpp"
+#include "ringbuffer.cpp"
+#include "measurement.h"
+#include "power.cpp"
+#include "wifilink.cpp"
+
+#ifdef LOW_POWER_RADIO_OFF
+#include <senseBoxIO.h>
+#endif
+
+#if defined(GATEWAY_MODE) || defined(GATEWAY_IPADDR)
+#include <WiFiUdp.h>
+#include "gateway.cpp"
+#endif
 
 #ifndef __NETWORK_H_INC__
 #define __NETWORK_H_INC__
@@ -10,31 +27,66 @@
  * 
  * Struktur für das Sammeln der Sensor Daten.
  * 'sensorId' ist dabei die von der openSenseMap
- * zugeteilte ID des jeweiligen sensors.
+ * zugeteilte ID des jeweiligen sensors, 'value' der
+ * Messwert in Hundertstel (Festkomma mit zwei Nachkommastellen).
+ * Ungültige Messungen ('valid' ist falsch) belegen ihren Platz,
+ * werden aber nicht gesendet.
  * 
  **/
 typedef struct osmMeasurement
 {
     const char *sensorId;
-    float value;
+    int32_t value;
+    bool valid;
 } osmMeasurement;
 
+/**
+ * 
+ * Ein Satz Messungen welcher im Ringpuffer auf das Senden wartet.
+ * 'values' hat die gleiche Reihenfolge wie 'Network::measurements',
+ * 'millisCollected' ist der Zeitpunkt der Messung und wird erst beim
+ * Senden in einen Zeitstempel umgerechnet. Bit 'i' in 'valid' ist
+ * gesetzt wenn 'values[i]' gültig ist.
+ * 
+ **/
+typedef struct storedMeasurements
+{
+    uint32_t millisCollected;
+    int32_t values[NUM_SENSORS];
+    uint16_t valid;
+    uint8_t count;
+} storedMeasurements;
+
 class Network
 {
 private:
     // Ein Array welches Sensor Daten sammelt.
     // Da die Sensor Daten bei jedem Messzyklus gleich bleiben wird
     // das Array lediglich überschrieben und die variable 'num_measurements' hochgezählt
-    // oder auf Null zurückgesetzt.
+    // oder auf Null zurückgesetzt. Die 'sensorId' einer Position ändert sich
+    // daher nicht und wird auch für die Einträge in 'backlog' genutzt.
     osmMeasurement measurements[NUM_SENSORS];
 
+    // Ringpuffer für alle noch nicht gesendeten Messungen. Jeder Messzyklus
+    // wird hier abgelegt und von 'postMeasuremnts' mit Zeitstempel gesendet,
+    // so gehen bei einem Ausfall der Verbindung keine Messungen verloren.
+    RingBuffer<storedMeasurements, OFFLINE_BUFFER_SIZE> backlog;
+
+    // Anzahl der Einträge aus 'backlog' im aktuell gesendeten Request, diese
+    // werden erst nach Bestätigung durch den Server entfernt.
+    uint16_t inFlight = 0;
+
+    // Unix Zeit des WiFi Moduls und der dazugehörige millis() Wert.
+    uint32_t epochSync = 0;
+    unsigned long millisSync = 0;
+
     // Der Index der aktuellen Messung, dient als Position in der Array 'measurements'
     // und als Summe der bisherig enthaltenen Messungen.
     uint8_t num_measurements = 0;
 
-    // Der Puffer für das Webrequest. Bei zunehmender Sensor Anzahl sollte dieser Wert
-    // angepasst werden.
-    char buffer[750];
+    // Sendefenster für das Webrequest, die Messungen werden direkt
+    // in das Fenster formatiert und in großen Blöcken gesendet.
+    UploadWriter tx;
 
     // Netwerk SSID und Schlüssel welche per Konstruktor übergeben werden.
     const char *ssid;
@@ -43,342 +95,898 @@ private:
     // Server Adresse, wird über den Konstruktor übergeben.
     const char *serverAddress;
 
-    // WiFi101 client, sorgt für die Verbindung mit dem Wifi Modul.
+    // WiFi101 client, hält die TLS Sitzung zur openSenseMap (keep-alive).
     WiFiClient client; //WiFiSSLClient client;
 
-    // Aktueller Status des Wifi Modules.
-    int status = WL_IDLE_STATUS;
+    // Separater Client für die Abfrage des Windrads, so bleibt die
+    // Sitzung zur openSenseMap davon unberührt. Die Antwort wird wie die
+    // der openSenseMap nur aus den bereits empfangenen Bytes gelesen.
+    WiFiClient urlClient;
+    HttpResponseParser urlResponse;
+    HttpBodyFields urlFields;
+    bool awaitingUrlResponse = false;
+    bool urlValuesUpdated = false;
+    unsigned long millisUrlRequest = 0;
+
+    // Abfrage welche auf die Verbindung wartet
+    IPAddress urlAddress;
+    uint16 urlPort = 0;
+    bool urlPending = false;
+
+    // Verbindung mit dem WLAN, wird mit jeder Abfrage in 'handleClient' geprüft.
+    WifiLink link;
+
+    // Liest die Antwort der openSenseMap auf den letzten Postrequest,
+    // erst wenn diese vollständig gelesen ist kann die Sitzung erneut genutzt werden.
+    HttpResponseParser response;
+    bool awaitingResponse = false;
+    unsigned long millisRequest = 0;
+
+#ifdef GATEWAY_MODE
+    // Frames der anderen Stationen und ihre Warteschlangen, 'inFlightBox' ist
+    // die Station des aktuellen Requests (-1 für die eigenen Messungen).
+    Gateway gateway;
+    WiFiUDP udp;
+    uint8_t frame[GATEWAY_FRAME_SIZE];
+    int8_t inFlightBox = -1;
+#endif
+#ifdef GATEWAY_IPADDR
+    // Die eigenen Messungen gehen als Frame an das Gateway
+    WiFiUDP udp;
+    uint8_t frame[GATEWAY_FRAME_SIZE];
+#endif
+
+#ifdef LOW_POWER_RADIO_OFF
+    // Das WiFi Modul ist zwischen den Postrequests ausgeschaltet
+    bool radioOff = false;
+#endif
+
+    // Wartezeit bis zum nächsten Verbindungsversuch, wird nach jedem
+    // Fehlschlag verdoppelt (bis 'OSM_BACKOFF_MAX') und bei Erfolg zurückgesetzt.
+    unsigned long backoff = 0;
+    unsigned long millisNextConnect = 0;
 
-    // Netzwerk Webrequest Zeiten
-    unsigned long millisNetworkPost;
+    /**
+     * 
+     * Liest die Uhrzeit des WiFi Moduls (NTP), einmal pro Stunde.
+     * 
+     **/
+    void syncTime()
+    {
+        if (epochSync != 0 && millis() - millisSync < OSM_TIME_SYNC_INTERVAL)
+        {
+            return;
+        }
 
-    // Letzter Task der ausgeführt wurde, so kann unterschieden werden
-    // welche post oder get Methode als letztes ausgeführt wurde.
-    // 0: Keine
-    // 1: getValuesFromUrl()
-    // 2: postMeasurements()
-    uint8 lastTask = 0;
+        uint32_t epoch = WiFi.getTime();
+        if (epoch != 0)
+        {
+            epochSync = epoch;
+            millisSync = millis();
+        }
+    }
 
     /**
      * 
-     * Mit dieser Methode werden die Messungen aus 'measurements'
-     * in den Puffer für den Webrequest geschrieben.
+     * Legt die aktuellen Messungen aus 'measurements' im Ringpuffer ab.
+     * Ist der Puffer voll wird der älteste Eintrag überschrieben.
      * 
      **/
-    void writeMeasurementsToClient()
+    void storeMeasurements(unsigned long millisCollected)
     {
+        storedMeasurements entry;
+        entry.millisCollected = millisCollected;
+        entry.count = num_measurements;
+        entry.valid = 0;
         for (uint8_t i = 0; i < num_measurements; i++)
         {
-            sprintf_P(buffer, PSTR("%s,%9.2f\n"), measurements[i].sensorId,
-                      measurements[i].value);
+            entry.values[i] = measurements[i].value;
+            if (measurements[i].valid)
+            {
+                entry.valid |= 1 << i;
+            }
+        }
+        // Bei vollem Puffer verdrängt der neue Eintrag den ältesten, dieser
+        // gehört zum laufenden Request und wird mit der Antwort nicht mehr entfernt.
+        bool ownBatch = true;
+#ifdef GATEWAY_MODE
+        ownBatch = inFlightBox < 0;
+#endif
+        if (backlog.isFull() && inFlight > 0 && ownBatch)
+        {
+            inFlight--;
+        }
+        backlog.push(entry);
+        num_measurements = 0;
+    }
 
-            client.print(buffer);
-            DEBUG2(buffer);
+    /**
+     * 
+     * Die ersten 'count' Einträge aus 'backlog' als Messzyklen eines
+     * Requests für 'PayloadEncoder' (siehe encoding.cpp).
+     * 
+     **/
+    class BacklogBatch
+    {
+    private:
+        Network &network;
+        uint16_t count;
+
+    public:
+        BacklogBatch(Network &network, uint16_t count) : network(network), count(count) {}
+
+        uint16_t size() { return count; }
+        uint8_t channels(uint16_t i) { return network.backlog.at(i).count; }
+        bool valid(uint16_t i, uint8_t j) { return network.backlog.at(i).valid & (1 << j); }
+        int32_t value(uint16_t i, uint8_t j) { return network.backlog.at(i).values[j]; }
+        uint32_t epoch(uint16_t i) { return network.toEpoch(network.backlog.at(i).millisCollected); }
+        const char *sensorId(uint8_t j) { return network.measurements[j].sensorId; }
+    };
+
+    /**
+     * 
+     * Stellt sicher das eine TLS Sitzung zur openSenseMap besteht.
+     * Eine offene Sitzung wird wiederverwendet, so entfällt der TLS Handshake.
+     * Schlägt der Verbindungsaufbau oder ein Post fehl wird der nächste
+     * Versuch mit exponentiell steigender Wartezeit verzögert, statt das
+     * System neu zu starten. Zurückgesetzt wird sie erst mit "201 Created".
+     * 
+     **/
+    bool openSession()
+    {
+        // Gilt auch für eine offene Sitzung, z.B. nach einer Antwort mit 5xx
+        if (backoff > 0 && (long)(millis() - millisNextConnect) < 0)
+        {
+            DEBUG(F("[Network] Waiting for reconnect backoff..."));
+            return false;
         }
 
-        // Setzte Messwerte Index auf 0 zurück
-        num_measurements = 0;
+        if (client.connected())
+        {
+            handshakesAvoided++;
+            return true;
+        }
+
+        client.stop();
+        DEBUG(F("[Network] Opening TLS session..."));
+        if (client.connectSSL(this->serverAddress, 443))
+        {
+            handshakes++;
+            power().radioHandshake();
+            return true;
+        }
+
+        DEBUG(F("[Network] Connection failed, backing off"));
+        increaseBackoff();
+        return false;
     }
 
-    String getValue(String data, char separator, int index)
+    void increaseBackoff()
     {
-        int found = 0;
-        int strIndex[] = {0, -1};
-        int maxIndex = data.length() - 1;
+        backoff = backoff == 0 ? OSM_BACKOFF_MIN : backoff * 2;
+        if (backoff > OSM_BACKOFF_MAX)
+        {
+            backoff = OSM_BACKOFF_MAX;
+        }
+        millisNextConnect = millis() + backoff;
+    }
+
+    /**
+     * 
+     * Schließt die Sitzung, z.B. wenn die Antwort ausbleibt
+     * oder der Server die Verbindung nicht offen halten will.
+     * 
+     **/
+    void closeSession()
+    {
+        client.stop();
+        awaitingResponse = false;
+        inFlight = 0;
+#ifdef GATEWAY_MODE
+        inFlightBox = -1;
+#endif
+    }
+
+    /**
+     * 
+     * Schreibt den Rest des Headers nach "POST /boxes/<senseBox ID>".
+     * 
+     **/
+    void writeHeader(const char *contentType, uint32_t contentLength)
+    {
+        tx.print("/data HTTP/1.1\r\nHost: ");
+        tx.print(this->serverAddress);
+        tx.print("\r\nContent-Type: ");
+        tx.print(contentType);
+        tx.print("\r\nConnection: keep-alive\r\nContent-Length: ");
+        tx.print(contentLength);
+        tx.print("\r\n\r\n");
+    }
+
+    /**
+     * 
+     * Übergibt den Rest des Sendefensters an den Client und wartet danach
+     * auf die Antwort, 'count' Einträge werden erst mit dieser entfernt.
+     * 
+     **/
+    void sendRequest(uint16_t count)
+    {
+        power().radioTransfer(tx.requestLength());
+        tx.flush();
+
+        if (tx.writeError)
+        {
+            DEBUG(F("[Network] Write failed, closing session"));
+            closeSession();
+            increaseBackoff();
+            return;
+        }
+
+        DEBUG(F("done!"));
+        response.begin();
+        awaitingResponse = true;
+        inFlight = count;
+        millisRequest = millis();
+    }
 
-        for (int i = 0; i <= maxIndex && found <= index; i++)
+#ifdef GATEWAY_MODE
+    /**
+     * 
+     * Nimmt alle wartenden Frames der anderen Stationen an.
+     * 
+     **/
+    void receiveFrames()
+    {
+        int size;
+        while ((size = udp.parsePacket()) > 0)
         {
-            if (data.charAt(i) == separator || i == maxIndex)
+            int length = udp.read(frame, sizeof(frame));
+            if (length < 0 || size > (int)sizeof(frame))
             {
-                found++;
-                strIndex[0] = strIndex[1] + 1;
-                strIndex[1] = (i == maxIndex) ? i + 1 : i;
+                // Zu lang für einen gültigen Frame, wird als ungültig gezählt
+                length = 0;
+            }
+            if (!gateway.receive(frame, length, toEpoch(millis())))
+            {
+                DEBUG(F("[Network] Gateway frame rejected"));
             }
         }
-        return found > index ? data.substring(strIndex[0], strIndex[1]) : "";
     }
 
-public:
-    int windradSpeed = 0;
-    int windradDirection = 0;
-    double pm25 = 0.0;
-    double pm10 = 0.0;
-
     /**
      * 
-     * Fügt eine Messung hinzu, benötigt wird die SensorID welche
-     * von der openSenseMap zugewiesen wurde und der Wert welcher von
-     * einem Sensor zurückgegeben wurde.
+     * Schreibt die ersten 'count' Messungen einer Station als CSV, 'out'
+     * ist 'tx' oder ein 'UploadCounter' für die Länge.
      * 
      **/
-    void addMeasurement(const char *sensorId, float value)
+    template <typename Out>
+    void writeGatewayBatch(Out &out, gatewayBox &box, uint16_t count)
     {
-        measurements[num_measurements].sensorId = sensorId;
-        measurements[num_measurements].value = value;
-        num_measurements++;
+        for (uint16_t i = 0; i < count; i++)
+        {
+            gatewayReading &reading = box.readings.at(i);
+            out.printHex(reading.sensorId, GATEWAY_ID_SIZE);
+            out.print(',');
+            CsvEncoder::printValue(out, reading.value);
+            if (reading.epoch != 0)
+            {
+                out.print(',');
+                out.printTimestamp(reading.epoch);
+            }
+            out.print('\n');
+        }
     }
 
     /**
      * 
-     * Setze alle Messungen zurück, aber Achtung! die 'measurements' Array
-     * ist davon nicht betroffen, es wird lediglich der index bzw die Position
-     * zurückgesetzt.
+     * Sendet die wartenden Messungen einer Station des Gateways als ein
+     * Postrequest über die bestehende Sitzung, gleiches Format wie
+     * 'CsvEncoder'.
      * 
      **/
-    void clearMeasurmentIndex()
+    void postGatewayBatch(int8_t index)
     {
-        num_measurements = 0;
+        if (!openSession())
+        {
+            return;
+        }
+
+        gatewayBox &box = gateway.getBox(index);
+        uint16_t count = box.readings.size();
+
+        UploadCounter counter;
+        writeGatewayBatch(counter, box, count);
+
+        tx.begin(client);
+        tx.print("POST /boxes/");
+        tx.printHex(box.id, GATEWAY_ID_SIZE);
+        writeHeader("text/csv", counter.length);
+        writeGatewayBatch(tx, box, count);
+
+        sendRequest(count);
+        if (awaitingResponse)
+        {
+            inFlightBox = index;
+        }
     }
+#endif
 
+#ifdef GATEWAY_IPADDR
     /**
      * 
-     * WiFi Verbindung wird mit Netzwerk hergestellt.
+     * Sendet die Einträge aus 'backlog' als Frames an das Gateway. UDP wird
+     * nicht bestätigt, ein Eintrag wird entfernt sobald sein Frame gesendet ist.
      * 
      **/
-    void connect()
+    void sendToGateway()
     {
-        WiFi.begin(ssid, key);
+        syncTime();
+
+        IPAddress gatewayAddress(GATEWAY_IPADDR);
+        GatewayFrameWriter writer;
+        while (!backlog.isEmpty())
+        {
+            storedMeasurements &entry = backlog.at(0);
+            writer.begin(frame, SENSEBOX_ID, toEpoch(entry.millisCollected));
+            for (uint8_t j = 0; j < entry.count; j++)
+            {
+                if (entry.valid & (1 << j))
+                {
+                    writer.add(measurements[j].sensorId, entry.values[j]);
+                }
+            }
+
+            uint16_t length = writer.finish();
+            if (length == 0)
+            {
+                DEBUG(F("[Network] Invalid ID, entry not sent to gateway"));
+            }
+            else if (!udp.beginPacket(gatewayAddress, GATEWAY_PORT) ||
+                     udp.write(frame, length) != length || !udp.endPacket())
+            {
+                DEBUG(F("[Network] Sending to gateway failed"));
+                increaseBackoff();
+                return;
+            }
+            else
+            {
+                posts++;
+            }
+            backlog.pop(1);
+        }
+        backoff = 0;
     }
+#endif
 
+#ifdef LOW_POWER_RADIO_OFF
     /**
      * 
-     * WiFi Verbindung wird getrennt.
+     * Schaltet das WiFi Modul (XB1) aus, die Sitzung geht dabei verloren.
      * 
      **/
-    void disconnect()
+    void radioSleep()
     {
-        WiFi.disconnect();
+        DEBUG(F("[Network] Radio off"));
+        closeSession();
+        urlClient.stop();
+        link.end();
+        senseBoxIO.powerXB1(false);
+        radioOff = true;
     }
 
     /**
      * 
-     * WiFi Verbindung wird geschlossen und im Anschluss neu aufgebaut.
-     * zwischen dem trennen und dem Aufbau liegen 200ms.
+     * Schaltet das WiFi Modul wieder ein und startet die Verbindung, gesendet
+     * wird von 'handleClient' sobald sie steht. Scheitert sie, wird das Modul
+     * bis zum nächsten Post wieder ausgeschaltet.
      * 
      **/
-    void reconnect()
+    void radioWake()
     {
-        disconnect();
-        delay(200);
-        connect();
+        DEBUG(F("[Network] Radio on"));
+        senseBoxIO.powerXB1(true);
+        radioOff = false;
+        link.begin(ssid, key);
     }
+#endif
 
-    void getValuesFromUrl(IPAddress *address, uint16 port)
+    /**
+     * 
+     * Wertet die vollständige Antwort der openSenseMap aus.
+     * 
+     **/
+    void finishResponse()
     {
-        bool connected = false;
+        awaitingResponse = false;
+        lastStatusCode = response.getStatusCode();
+        lastPostLatency = millis() - millisRequest;
+        if (lastPostLatency > maxPostLatency)
+        {
+            maxPostLatency = lastPostLatency;
+        }
 
-        DEBUG(F("[Network] (GET) Connecting..."));
-        connected = client.connect(*address, port);
-        if (connected == true)
+        // openSenseMap antwortet mit "201 Created", erst dann werden die
+        // gesendeten Einträge aus dem Ringpuffer entfernt. Daten welche der
+        // Server als fehlerhaft ablehnt (400, 413, 422) werden verworfen,
+        // sonst würde der Ringpuffer bei jedem Versuch erneut daran
+        // scheitern. Alle anderen Antworten, z.B. 408 oder 429, werden
+        // nach der Wartezeit wiederholt.
+        bool rejected = lastStatusCode == 400 || lastStatusCode == 413 || lastStatusCode == 422;
+        bool confirmed = lastStatusCode == 201 || rejected;
+        if (lastStatusCode == 201)
+        {
+            posts++;
+            backoff = 0;
+        }
+        else
+        {
+            failedPosts++;
+            rejectedPosts += rejected ? 1 : 0;
+            DEBUG2(F("[Network] Unexpected status code "));
+            DEBUG(lastStatusCode);
+        }
+        // Nicht bestätigte Einträge werden erst nach der Wartezeit erneut
+        // gesendet, sonst folgt der nächste Versuch mit dem nächsten Poll
+        if (!confirmed)
         {
-            lastTask = 1;
+            increaseBackoff();
+        }
+
+#ifdef GATEWAY_MODE
+        if (inFlightBox >= 0)
+        {
+            if (confirmed)
+            {
+                gatewayReadingsPosted += inFlight;
+                gateway.confirm(inFlightBox, inFlight);
+            }
+            inFlightBox = -1;
+        }
+        else
+#endif
+            if (confirmed)
+        {
+            backlog.pop(inFlight);
+        }
+        inFlight = 0;
 
+        if (!response.isKeepAlive())
+        {
+            DEBUG(F("[Network] Server closed session"));
+            client.stop();
+        }
+    }
+
+    void sendUrlRequest()
+    {
+        urlPending = false;
+        DEBUG(F("[Network] (GET) Connecting..."));
+        urlClient.stop();
+        if (urlClient.connect(urlAddress, urlPort))
+        {
             DEBUG(F("[Network] Connection success, start request..."));
-            client.println(F("GET / HTTP/1.1"));
-            //client.println(F("Host: 192.168.43.122"));
-            client.println(F("Connection: close"));
-            client.println();
+            urlClient.println(F("GET / HTTP/1.1"));
+            //urlClient.println(F("Host: 192.168.43.122"));
+            urlClient.println(F("Connection: close"));
+            urlClient.println();
+
+            power().radioTransfer(0);
+            urlResponse.begin();
+            urlFields.begin();
+            awaitingUrlResponse = true;
+            millisUrlRequest = millis();
         }
         else
         {
             DEBUG("Failed to connect...");
+            failedUrlRequests++;
         }
     }
 
     /**
      * 
-     * Webrequest wird gestartet, alle Messungen aus 'measurements'
-     * werden in den Puffer geladen und als Post Request gesendet.
+     * Liest die Antwort auf 'getValuesFromUrl', Status Zeile und Header
+     * über 'urlResponse', die Zahlen des Bodys über 'urlFields'.
      * 
      **/
-    void postMeasuremnts()
+    void handleUrlResponse()
     {
-        bool connected = false;
+        while (urlClient.available() > 0 && !urlResponse.isDone())
+        {
+            char c = urlClient.read();
+            if (urlResponse.feed(c))
+            {
+                urlFields.feed(c);
+            }
+        }
 
-        Serial.println(F("connecting..."));
-        connected = client.connectSSL(this->serverAddress, 443);
-        if (connected == true)
+        bool closed = !urlResponse.isDone() && !urlClient.connected();
+        if (closed)
         {
-            lastTask = 2;
+            urlResponse.finish();
+        }
 
-            DEBUG(F("Connection successful, transferring..."));
-            // Erzeuge Header des HTTP Webrequests
-            sprintf_P(buffer,
-                      PSTR("POST /boxes/%s/data HTTP/1.1\nHost: %s\nContent-Type: "
-                           "text/csv\nConnection: close\nContent-Length: %i\n\n"),
-                      SENSEBOX_ID, this->serverAddress, num_measurements * 35);
-            DEBUG(buffer);
+        if (urlResponse.isDone())
+        {
+            awaitingUrlResponse = false;
+            urlClient.stop();
+            urlFields.finish();
+            if (urlResponse.getStatusCode() == 200)
+            {
+                urlValuesUpdated = true;
+            }
+            else
+            {
+                DEBUG2(F("[Network] (GET) Unexpected status code "));
+                DEBUG(urlResponse.getStatusCode());
+                failedUrlRequests++;
+            }
+        }
+        else if (closed || millis() - millisUrlRequest >= HTTP_RESPONSE_TIMEOUT)
+        {
+            DEBUG(F("[Network] (GET) Incomplete response"));
+            awaitingUrlResponse = false;
+            urlClient.stop();
+            failedUrlRequests++;
+        }
+    }
 
-            // Sende den Header des HTTP Webrequests
-            client.print(buffer);
+public:
+    // Statistiken der Sitzung zur openSenseMap
+    unsigned long handshakes = 0;
+    unsigned long handshakesAvoided = 0;
+    unsigned long posts = 0;
+    unsigned long failedPosts = 0;
+    // Davon abgelehnte Daten, welche verworfen wurden
+    unsigned long rejectedPosts = 0;
+    unsigned long lastPostLatency = 0;
+    unsigned long maxPostLatency = 0;
+    uint16_t lastStatusCode = 0;
+
+    // Fehlgeschlagene Abfragen mit 'getValuesFromUrl'
+    unsigned long failedUrlRequests = 0;
+
+#ifdef GATEWAY_MODE
+    // Von der openSenseMap bestätigte Messungen der anderen Stationen
+    unsigned long gatewayReadingsPosted = 0;
+
+    Gateway &getGateway()
+    {
+        return gateway;
+    }
+#endif
 
-            // Sende die Messergebnisse
-            this->writeMeasurementsToClient();
+    /**
+     * 
+     * Rechnet den Zeitpunkt einer Messung in Unix Zeit um,
+     * 0 wenn die Uhrzeit noch nicht bekannt ist.
+     * 
+     **/
+    uint32_t toEpoch(uint32_t millisCollected)
+    {
+        if (epochSync == 0)
+        {
+            return 0;
+        }
+        return epochSync + (long)(millisCollected - millisSync) / 1000;
+    }
 
-            // Sende am Ende eine Leere Zeile um den Webrequest abzuschließen
-            client.println();
+    // Noch nicht bestätigte Messzyklen im Ringpuffer und seit dem Start überschriebene
+    uint16_t backlogSize() { return backlog.size(); }
+    unsigned long backlogDropped() { return backlog.dropped; }
 
-            /*while (client.available())
-            {
-                char c = client.read();
-                DEBUG_WRITE(c);
-                // Wenn der Server die Verbindung abbricht, stoppe client.
-                if (!client.connected())
-                {
-                    DEBUG();
-                    DEBUG(F("disconnecting from server."));
-                    client.stop();
-                    break;
-                }
-            }*/
+    /**
+     * 
+     * Liefert den zuletzt von 'networkHandle' abgelegten Satz Messungen,
+     * NULL wenn noch keine Messungen vorliegen.
+     * 
+     **/
+    storedMeasurements *latestMeasurements()
+    {
+        if (backlog.isEmpty())
+        {
+            return NULL;
+        }
+        return &backlog.at(backlog.size() - 1);
+    }
 
-            DEBUG(F("done!"));
+    /**
+     * 
+     * Fügt eine Messung hinzu, benötigt wird die SensorID welche
+     * von der openSenseMap zugewiesen wurde und der Messwert in Hundertstel.
+     * Ist 'valid' falsch wird der Platz belegt, die Messung aber nicht gesendet.
+     * 
+     **/
+    void addMeasurement(const char *sensorId, int32_t hundredths, bool valid = true)
+    {
+        measurements[num_measurements].sensorId = sensorId;
+        measurements[num_measurements].value = hundredths;
+        measurements[num_measurements].valid = valid;
+        num_measurements++;
+    }
 
-            // Setze Index der Messungen auf Null.
-            num_measurements = 0;
+    template <typename T, int32_t SCALE>
+    void addMeasurement(const char *sensorId, const FixedValue<T, SCALE> &value, bool valid = true)
+    {
+        addMeasurement(sensorId, value.hundredths(), valid);
+    }
+
+    /**
+     * 
+     * Setze alle Messungen zurück, aber Achtung! die 'measurements' Array
+     * ist davon nicht betroffen, es wird lediglich der index bzw die Position
+     * zurückgesetzt.
+     * 
+     **/
+    void clearMeasurmentIndex()
+    {
+        num_measurements = 0;
+    }
+
+    /**
+     * 
+     * Fragt die Werte des Windrads ab, die Antwort liest 'handleClient'.
+     * Ohne Verbindung wird die Abfrage gesendet sobald diese steht.
+     * 
+     **/
+    void getValuesFromUrl(IPAddress *address, uint16 port)
+    {
+        if (urlPending)
+        {
+            // Die vorherige Abfrage kam nicht mehr zustande
+            failedUrlRequests++;
         }
+        urlAddress = *address;
+        urlPort = port;
+        urlPending = true;
 
-        if (connected == false) {
-            DEBUG(F("connection failed. Restarting System."));
-            delay(5000);
-            noInterrupts();
-            NVIC_SystemReset();
-            while (1)
-                ;
+#ifdef LOW_POWER_RADIO_OFF
+        if (radioOff)
+        {
+            radioWake();
+        }
+#endif
+        if (link.isUp())
+        {
+            sendUrlRequest();
         }
     }
 
     /**
      * 
-     * Diese Methode gehört in die Hauptroutine des Programms.
-     * Sie sorgt dafür das zur richtigen Zeit ein Postrequest ausgelöst
-     * wird. Sollte es zu Verbindungsproblemen kommen sorgt diese Methode
-     * ebenfalls für das Wiederverbinden mit dem Netzwerk.
+     * Liefert true wenn keine Antwort aussteht, im Stromsparbetrieb wird
+     * das Netzwerk dann nur im Intervall 'POWER_IDLE_POLL_INTERVAL' abgefragt.
      * 
      **/
-    void networkHandle(void (*pre)())
+    bool isIdle()
     {
-        // Bevor neue Tasks abarbeitet werden wird nach Daten
-        // werden Daten im Client puffer abarbeitet.
-        if (lastTask == 0)
+        return !awaitingResponse && !awaitingUrlResponse && !urlPending && !link.isJoining();
+    }
+
+    /**
+     * 
+     * Liefert true wenn seit dem letzten Aufruf eine Antwort auf
+     * 'getValuesFromUrl' vollständig gelesen wurde, die Werte stehen dann
+     * in 'getUrlValues'.
+     * 
+     **/
+    bool takeUrlValues()
+    {
+        bool result = urlValuesUpdated;
+        urlValuesUpdated = false;
+        return result;
+    }
+
+    const HttpBodyFields &getUrlValues()
+    {
+        return urlFields;
+    }
+
+    /**
+     * 
+     * Webrequest wird gestartet, die ältesten Einträge aus 'backlog'
+     * (höchstens 'PayloadEncoder::maxEntries()') werden in das Sendefenster
+     * geladen und als Post Request über die bestehende Sitzung gesendet.
+     * 
+     **/
+    void postMeasuremnts()
+    {
+        // Die Antwort auf den vorherigen Request muss zuerst gelesen werden,
+        // sonst ist die Sitzung nicht mehr synchron.
+        if (awaitingResponse || backlog.isEmpty())
         {
-            client.read();
+            return;
         }
 
-        // getValuesFromUrl()
-        if (lastTask == 1)
+#ifdef GATEWAY_IPADDR
+        // Die Station sendet nicht selbst, sondern über das Gateway
+        sendToGateway();
+        return;
+#endif
+
+        if (!openSession())
         {
-            boolean content = false;
+            return;
+        }
 
-            while (client.available())
-            {
-                if (content == true)
-                {
-                    String value = client.readString();
-                    DEBUG(value);
-                    this->windradDirection = getValue(value, ',', 1).toInt();
-                    this->windradSpeed = getValue(value, ',', 0).toInt();
-                    this->pm25 = getValue(value, ',', 0).toDouble();
-                    this->pm10 = getValue(value, ',', 0).toDouble();
-                    continue;
-                }
+        syncTime();
 
-                char c;
-                if ((c = client.read()) == '\r' && (c = client.read()) == '\n')
-                {
-                    if ((c = client.read()) == '\r' && (c = client.read()) == '\n')
-                    {
-                        content = true;
-                    }
-                }
+        uint16_t count = backlog.size();
+        if (count > PayloadEncoder::maxEntries())
+        {
+            count = PayloadEncoder::maxEntries();
+        }
+        BacklogBatch batch(*this, count);
 
-                delay(1);
-            }
+        DEBUG(F("Connection successful, transferring..."));
+        // Erzeuge Header des HTTP Webrequests, die Länge des Bodys
+        // wird vorab exakt berechnet.
+        UploadCounter counter;
+        PayloadEncoder::write(counter, batch);
+        DEBUG2(F("Content-Length: "));
+        DEBUG(counter.length);
+
+        tx.begin(client);
+        tx.print("POST /boxes/" SENSEBOX_ID);
+        writeHeader(PayloadEncoder::contentType(), counter.length);
+
+        // Sende die Messergebnisse
+        PayloadEncoder::write(tx, batch);
+
+        sendRequest(count);
+    }
+
+    /**
+     * 
+     * Verarbeitet die Antworten des Servers auf den letzten Webrequest.
+     * Diese Methode wird vom Scheduler im Intervall 'NETWORK_POLL_INTERVAL'
+     * aufgerufen.
+     * 
+     **/
+    void handleClient()
+    {
+        // Ohne Verbindung ist die Sitzung verloren, die Einträge bleiben im Ringpuffer
+        bool wasUp = link.isUp();
+        link.poll();
+        if (wasUp && !link.isUp())
+        {
+            closeSession();
         }
 
-        // postMeasurements()
-        if (lastTask == 2)
+        if (urlPending && link.isUp())
         {
-            client.read();
+            sendUrlRequest();
         }
 
-        // Wenn der Server die Verbindung abbricht, stoppe client.
-        /*if (!client.connected())
+        // getValuesFromUrl(), es werden nur die bereits empfangenen Bytes gelesen
+        if (awaitingUrlResponse)
         {
-            DEBUG();
-            DEBUG(F("disconnecting from server."));
-            client.stop();
-        }*/
+            handleUrlResponse();
+        }
 
-        // Behandle Verbindungs Aufgaben
-        if ((millis() - millisNetworkPost) >= 60e3)
+        // postMeasurements(), es werden nur die bereits empfangenen Bytes gelesen
+        if (awaitingResponse)
         {
-            DEBUG(F("[Network] Routine started..."));
-            if (status == WL_CONNECTED)
+            while (client.available() > 0 && !response.isDone())
             {
-                // Führe eine pre Operation aus (z.b für das Sammeln von Daten)
-                pre();
-
-                DEBUG(F("[Network] Post data started..."));
-                this->postMeasuremnts();
-                DEBUG(F("[Network] Post data complete"));
+                response.feed(client.read());
             }
-            else if (status == WL_IDLE_STATUS)
+
+            if (!response.isDone() && !client.connected())
             {
-                DEBUG(F("[Network] Status is WL_IDLE_STATUS, reconnect..."));
-                reconnect();
-                DEBUG(F("[Network] Reconnected..."));
+                response.finish();
             }
-            else if (status == WL_CONNECT_FAILED)
+
+            if (response.isDone())
             {
-                DEBUG(F("[Network] Connection failed..."));
-                disconnect();
-                status = WL_IDLE_STATUS;
+                finishResponse();
             }
-            else if (status == WL_DISCONNECTED)
+            else if (millis() - millisRequest >= HTTP_RESPONSE_TIMEOUT)
             {
-                DEBUG(F("[Network] Status is WL_DISCONNECTED, reconnect..."));
-                reconnect();
+                DEBUG(F("[Network] Response timed out, closing session"));
+                failedPosts++;
+                closeSession();
+                increaseBackoff();
             }
-            else
+        }
+        else if (client.available() > 0)
+        {
+            // Unerwartete Daten, die Sitzung ist nicht mehr synchron.
+            closeSession();
+        }
+
+        // Noch nicht gesendete Messungen nachholen, sobald die Wartezeit
+        // nach einem Fehlschlag abgelaufen ist.
+        if (link.isUp() && !awaitingResponse && !backlog.isEmpty() &&
+            (long)(millis() - millisNextConnect) >= 0)
+        {
+            postMeasuremnts();
+        }
+
+#ifdef GATEWAY_MODE
+        // Messungen der anderen Stationen, jeweils eine Station pro Request
+        // sobald die eigenen Messungen gesendet sind.
+        receiveFrames();
+        if (link.isUp() && !awaitingResponse && backlog.isEmpty() &&
+            (long)(millis() - millisNextConnect) >= 0)
+        {
+            int8_t index = gateway.nextBatch();
+            if (index >= 0)
             {
-                DEBUG(F("[Network] Status will be idle..."));
-                disconnect();
-                status = WL_IDLE_STATUS;
+                postGatewayBatch(index);
             }
-            DEBUG(F("[Network] routine complete..."));
+        }
+#endif
 
-            millisNetworkPost = millis();
+#ifdef LOW_POWER_RADIO_OFF
+        // Alles gesendet oder keine Verbindung, das WiFi Modul bis zum
+        // nächsten Post ausschalten
+        if (!radioOff && ((isIdle() && backlog.isEmpty()) || link.getState() == LINK_DOWN))
+        {
+            radioSleep();
         }
+#endif
     }
 
     /**
      * 
-     * Initialisiert das WiFi Module, diese Methode sollte vor dem
-     * ausführen der 'networkHandle' Methode einmalig ausgeführt werden.
+     * Diese Methode wird vom Scheduler im Intervall 'OSM_REFRESH_INTERVAL'
+     * aufgerufen und löst den Postrequest aus. Um das Wiederverbinden mit dem
+     * Netzwerk kümmert sich 'link' (siehe wifilink.cpp).
      * 
      **/
-    void initialize(const char *ssid, const char *key)
+    void networkHandle(void (*pre)())
     {
-        this->ssid = ssid;
-        this->key = key;
+        // Führe eine pre Operation aus (z.b für das Sammeln von Daten),
+        // die Messungen werden auch ohne Verbindung im Ringpuffer abgelegt.
+        num_measurements = 0;
+        pre();
+        storeMeasurements(millis());
 
-        status = WiFi.status();
-        if (status == WL_NO_SHIELD)
+#ifdef LOW_POWER_RADIO_OFF
+        // Gesendet wird von 'handleClient' sobald die Verbindung steht
+        if (radioOff)
         {
-            DEBUG(F("[Network] WiFi shield no present"));
+            radioWake();
+            return;
         }
+#endif
 
-        while (status != WL_CONNECTED)
+        // Ohne Verbindung bleiben die Messungen im Ringpuffer, das Wiederverbinden
+        // übernimmt 'link' in 'handleClient'
+        if (link.isUp())
         {
-            DEBUG(F("==[Network]=="));
-            DEBUG2(F("Attempting to connect to SSID: "));
-            DEBUG(ssid);
-            status = WiFi.begin(this->ssid, this->key);
-            DEBUG2(F("Waiting 10 secounds for connection..."));
-            delay(10000);
-            DEBUG(F("done"));
+            DEBUG(F("[Network] Post data started..."));
+            this->postMeasuremnts();
+            DEBUG(F("[Network] Post data complete"));
         }
+        else
+        {
+            DEBUG(F("[Network] No WiFi connection, measurements kept in the backlog"));
+        }
+    }
+
+    /**
+     * 
+     * Initialisiert das WiFi Module und startet die Verbindung ohne zu
+     * warten, diese Methode sollte vor dem ausführen der 'networkHandle'
+     * Methode einmalig ausgeführt werden.
+     * 
+     **/
+    void initialize(const char *ssid, const char *key)
+    {
+        this->ssid = ssid;
+        this->key = key;
+        link.begin(ssid, key);
+
+#if defined(GATEWAY_MODE)
+        udp.begin(GATEWAY_PORT);
+#endif
+    }
+
+    WifiLink &getLink()
+    {
+        return link;
     }
 
     /**
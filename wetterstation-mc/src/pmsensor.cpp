@@ -0,0 +1,295 @@
+#include <Arduino.h>
+#include "config.h"
+#include "utils.cpp"
+
+#include "measurement.h"
+#include "filter.cpp"
+
+#ifndef __PMSENSOR_H_INC__
+#define __PMSENSOR_H_INC__
+
+// Rahmen des SDS011 Protokolls (siehe Datenblatt "Laser Dust Sensor Control Protocol")
+#define SDS_HEAD 0xAA
+#define SDS_TAIL 0xAB
+#define SDS_CMD_ID 0xB4
+#define SDS_REPLY_DATA 0xC0
+#define SDS_REPLY_CMD 0xC5
+#define SDS_REPLY_LENGTH 10
+#define SDS_COMMAND_LENGTH 19
+
+/**
+ *
+ * Zustände des Feinstaubsensors während eines Messzyklus.
+ *
+ **/
+enum PmState
+{
+    PM_SLEEPING,
+    PM_WARMUP,
+    PM_SAMPLING
+};
+
+/**
+ *
+ * Nicht blockierende Ansteuerung des SDS011 Feinstaubsensors.
+ * Ein Messzyklus besteht aus: Aufwecken, 'PM_WARMUP_TIME' aufwärmen,
+ * 'PM_SAMPLES' Messungen abfragen und wieder schlafen legen.
+ * Der Median der Messungen wird am Ende des Zyklus in 'Measurment::pm25'
+ * und 'Measurment::pm10' geschrieben, eine fehlerhaft gelesene Messung
+ * verschiebt ihn im Gegensatz zum Mittelwert nicht.
+ *
+ * Die UART wird als 'Stream' übergeben, jeder Aufruf von 'handle' verarbeitet
+ * nur die bereits empfangenen Bytes und wartet nie auf den Sensor.
+ *
+ **/
+class PmSensor
+{
+private:
+    // Schnittstelle zum Sensor, z.B. Serial1
+    Stream *uart;
+
+    // Zeigt auf die Messwerte aus dem Hauptprogramm
+    Measurment *data;
+
+    PmState state = PM_SLEEPING;
+
+    // Beginn des aktuellen Zyklus und Zeitpunkt des letzten Zustandswechsels
+    unsigned long millisCycle = 0;
+    unsigned long millisState = 0;
+    unsigned long millisQuery = 0;
+    bool firstCycle = true;
+
+    // Empfangspuffer für eine Antwort des Sensors
+    uint8_t reply[SDS_REPLY_LENGTH];
+    uint8_t replyIndex = 0;
+
+    // Messungen des aktuellen Zyklus in 0.1 µg/m³
+    RunningMedian<PM_SAMPLES> samplesPm25;
+    RunningMedian<PM_SAMPLES> samplesPm10;
+    uint8_t samples = 0;
+    uint8_t queries = 0;
+
+    /**
+     *
+     * Sendet ein Kommando an alle angeschlossenen Sensoren (Geräte ID 0xFFFF).
+     * 'd1' bis 'd3' sind die ersten drei Datenbytes, der Rest ist 0.
+     *
+     **/
+    void sendCommand(uint8_t d1, uint8_t d2, uint8_t d3)
+    {
+        uint8_t frame[SDS_COMMAND_LENGTH] = {SDS_HEAD, SDS_CMD_ID, d1, d2, d3};
+        frame[15] = 0xFF;
+        frame[16] = 0xFF;
+
+        uint8_t checksum = 0;
+        for (uint8_t i = 2; i < 17; i++)
+        {
+            checksum += frame[i];
+        }
+        frame[17] = checksum;
+        frame[18] = SDS_TAIL;
+
+        uart->write(frame, SDS_COMMAND_LENGTH);
+    }
+
+    void sendWorking(bool working) { sendCommand(0x06, 0x01, working ? 0x01 : 0x00); }
+    void sendQueryMode() { sendCommand(0x02, 0x01, 0x01); }
+    void sendQuery() { sendCommand(0x04, 0x00, 0x00); }
+
+    /**
+     *
+     * Verarbeitet eine vollständige Antwort des Sensors.
+     * Nur Messwerte (0xC0) werden ausgewertet, Bestätigungen von
+     * Kommandos (0xC5) werden ignoriert.
+     *
+     **/
+    void handleReply()
+    {
+        uint8_t checksum = 0;
+        for (uint8_t i = 2; i < 8; i++)
+        {
+            checksum += reply[i];
+        }
+
+        if (reply[9] != SDS_TAIL || reply[8] != checksum)
+        {
+            invalidReplies++;
+            return;
+        }
+
+        if (reply[1] != SDS_REPLY_DATA || state != PM_SAMPLING)
+        {
+            return;
+        }
+
+        samplesPm25.add(reply[2] | (reply[3] << 8));
+        samplesPm10.add(reply[4] | (reply[5] << 8));
+        samples++;
+    }
+
+    /**
+     *
+     * Liest alle verfügbaren Bytes der UART und setzt daraus Antworten
+     * zusammen. Bytes vor dem Startbyte 0xAA werden verworfen.
+     *
+     **/
+    void readUart()
+    {
+        while (uart->available() > 0)
+        {
+            int c = uart->read();
+            if (c < 0)
+            {
+                break;
+            }
+
+            if (replyIndex == 0 && c != SDS_HEAD)
+            {
+                continue;
+            }
+
+            reply[replyIndex++] = c;
+            if (replyIndex == SDS_REPLY_LENGTH)
+            {
+                handleReply();
+                replyIndex = 0;
+            }
+        }
+    }
+
+    void setState(PmState state, unsigned long now)
+    {
+        this->state = state;
+        millisState = now;
+    }
+
+    /**
+     *
+     * Beendet den Messzyklus, schreibt die Mediane und
+     * legt den Sensor schlafen.
+     *
+     **/
+    void finishCycle(unsigned long now)
+    {
+        if (samples > 0)
+        {
+            // Der Sensor liefert bereits Zehntel µg/m³
+            data->pm25.setRaw(samplesPm25.median());
+            data->pm10.setRaw(samplesPm10.median());
+            data->setValid(FIELD_PM25);
+            data->setValid(FIELD_PM10);
+            completedCycles++;
+            DEBUG2(F("[PM] PM2.5 = "));
+            DEBUG2(data->pm25.toFloat());
+            DEBUG2(F(", PM10 = "));
+            DEBUG(data->pm10.toFloat());
+        }
+        else
+        {
+            failedCycles++;
+            DEBUG(F("[PM] No values received from sensor"));
+        }
+
+        sendWorking(false);
+        setState(PM_SLEEPING, now);
+    }
+
+public:
+    // Statistiken der Messzyklen und fehlerhafter Antworten
+    unsigned long completedCycles = 0;
+    unsigned long failedCycles = 0;
+    unsigned long invalidReplies = 0;
+
+    /**
+     *
+     * Stellt den Sensor auf Abfrage-Modus (Query reporting mode) und legt ihn
+     * schlafen. Diese Methode wird einmalig in der setup() Methode aufgerufen,
+     * die UART muss bereits gestartet sein.
+     *
+     **/
+    void begin()
+    {
+        sendQueryMode();
+        sendWorking(false);
+        setState(PM_SLEEPING, millis());
+        firstCycle = true;
+    }
+
+    PmState getState()
+    {
+        return state;
+    }
+
+    /**
+     *
+     * Diese Methode wird vom Scheduler im Intervall 'PM_POLL_INTERVAL'
+     * aufgerufen und führt den Messzyklus fort. Ein neuer Zyklus startet
+     * alle 'PM_REFRESH_INTERVAL' Millisekunden.
+     *
+     **/
+    void handle()
+    {
+        unsigned long now = millis();
+
+        readUart();
+
+        switch (state)
+        {
+        case PM_SLEEPING:
+            if (firstCycle || (now - millisCycle) >= PM_REFRESH_INTERVAL)
+            {
+                firstCycle = false;
+                millisCycle = now;
+                sendWorking(true);
+                setState(PM_WARMUP, now);
+            }
+            break;
+
+        case PM_WARMUP:
+            if ((now - millisState) >= PM_WARMUP_TIME)
+            {
+                samplesPm25.clear();
+                samplesPm10.clear();
+                samples = 0;
+                queries = 0;
+                setState(PM_SAMPLING, now);
+                millisQuery = now - (unsigned long)PM_SAMPLE_INTERVAL;
+            }
+            break;
+
+        case PM_SAMPLING:
+            if (samples >= PM_SAMPLES)
+            {
+                finishCycle(now);
+            }
+            else if ((now - millisQuery) >= PM_SAMPLE_INTERVAL)
+            {
+                // Jede Abfrage darf einmal wiederholt werden, danach wird
+                // der Zyklus auch mit weniger Messungen beendet.
+                if (queries >= 2 * PM_SAMPLES)
+                {
+                    finishCycle(now);
+                    break;
+                }
+                sendQuery();
+                queries++;
+                millisQuery = now;
+            }
+            break;
+        }
+    }
+
+    /**
+     *
+     * Erzeugt eine neue Klasseninstanz für den Feinstaubsensor an
+     * der Schnittstelle 'uart'.
+     *
+     **/
+    PmSensor(Stream &uart, Measurment *data)
+    {
+        this->uart = &uart;
+        this->data = data;
+    }
+};
+
+#endif
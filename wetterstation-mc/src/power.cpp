@@ -0,0 +1,405 @@
+#include <Arduino.h>
+#include "config.h"
+#include "fixedpoint.cpp"
+
+#ifndef __POWER_H_INC__
+#define __POWER_H_INC__
+
+#if defined(LOW_POWER_MODE) && defined(GATEWAY_MODE)
+#error "The gateway has to receive frames at any time, LOW_POWER_MODE is not supported"
+#endif
+
+#if defined(ARDUINO) && defined(LOW_POWER_MODE)
+// Zählt millis() um eine ms weiter (ArduinoCore-samd, delay.c)
+extern "C" void SysTick_DefaultHandler(void);
+#endif
+
+/**
+ *
+ * Baugruppen mit eigenem Stromverbrauch und ihre Zustände.
+ *
+ **/
+enum PowerDomain
+{
+    POWER_MCU,
+    POWER_RADIO,
+    POWER_DISPLAY,
+    POWER_DOMAIN_COUNT
+};
+
+enum PowerState
+{
+    // MCU: läuft, schläft bis zum nächsten SysTick (WFI), Standby bis RTC/Taster
+    MCU_ACTIVE = 0,
+    MCU_IDLE = 1,
+    MCU_STANDBY = 2,
+
+    // WINC1500: ausgeschaltet, verbunden mit Stromsparmodus, verbunden und
+    // dauerhaft empfangsbereit
+    RADIO_OFF = 0,
+    RADIO_POWER_SAVE = 1,
+    RADIO_LISTEN = 2,
+
+    // SSD1306
+    DISPLAY_OFF = 0,
+    DISPLAY_ON = 1
+};
+
+#define POWER_STATE_COUNT 3
+
+/**
+ *
+ * Verwaltet die Schlafzustände und führt ein Energiemodell: für jede
+ * Baugruppe wird die Zeit in jedem Zustand gezählt und mit dem Strom aus
+ * config.h (POWER_*_UA) bewertet. Kurze Vorgänge des WiFi Moduls (Verbinden,
+ * TLS Handshake, Requests) werden als feste Ladung mit ihrer typischen Dauer
+ * addiert, sie sind kürzer als die Auflösung der Zustände.
+ *
+ * Ohne 'LOW_POWER_MODE' wird nur gezählt, die MCU bleibt dann immer aktiv.
+ *
+ **/
+class PowerManager
+{
+private:
+    uint8_t states[POWER_DOMAIN_COUNT] = {MCU_ACTIVE, RADIO_OFF, DISPLAY_OFF};
+    unsigned long since[POWER_DOMAIN_COUNT] = {};
+    unsigned long stateTime[POWER_DOMAIN_COUNT][POWER_STATE_COUNT] = {};
+
+    // Ladung der kurzen Vorgänge in µA·ms
+    uint64_t eventCharge = 0;
+
+    unsigned long millisStart = 0;
+
+#if defined(ARDUINO) && defined(LOW_POWER_MODE)
+    // Rest der Umrechnung von RTC Takten (1024 Hz) in ms
+    uint16_t tickRemainder = 0;
+
+    static void rtcSync()
+    {
+        while (RTC->MODE0.STATUS.bit.SYNCBUSY)
+            ;
+    }
+
+    static uint32_t rtcCount()
+    {
+        RTC->MODE0.READREQ.reg = RTC_READREQ_RREQ;
+        rtcSync();
+        return RTC->MODE0.COUNT.reg;
+    }
+
+    /**
+     *
+     * Standby bis zum RTC Alarm nach 'ms' oder einem Interrupt (Taster,
+     * WiFi Modul). SysTick steht im Standby, millis() wird anschließend um
+     * die geschlafene Zeit weitergezählt.
+     *
+     **/
+    void standby(unsigned long ms)
+    {
+        uint32_t start = rtcCount();
+        uint32_t alarm = ms * 1024 / 1000;
+        RTC->MODE0.INTFLAG.reg = RTC_MODE0_INTFLAG_CMP0;
+        RTC->MODE0.COMP[0].reg = start + alarm;
+        rtcSync();
+
+        // Die Synchronisation dauert einige RTC Takte, ist der Alarm schon
+        // vorbei würde erst der Überlauf des Zählers wecken.
+        if (rtcCount() - start + 1 < alarm)
+        {
+            SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+            // Ein anstehender SysTick würde den Standby sofort beenden (Errata)
+            SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+            __DSB();
+            __WFI();
+            SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+            SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+        }
+
+        uint64_t scaled = (uint64_t)(rtcCount() - start) * 1000 + tickRemainder;
+        uint32_t elapsed = scaled / 1024;
+        tickRemainder = scaled % 1024;
+
+        noInterrupts();
+        for (uint32_t i = 0; i < elapsed; i++)
+        {
+            SysTick_DefaultHandler();
+        }
+        interrupts();
+    }
+
+    /**
+     *
+     * Schläft bis zum nächsten Interrupt, spätestens dem SysTick nach 1 ms.
+     *
+     **/
+    static void idle()
+    {
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+        PM->SLEEP.reg = PM_SLEEP_IDLE_CPU;
+        __DSB();
+        __WFI();
+    }
+#endif
+
+    static uint32_t current(uint8_t domain, uint8_t state)
+    {
+        static const uint32_t currents[POWER_DOMAIN_COUNT][POWER_STATE_COUNT] = {
+            {POWER_MCU_ACTIVE_UA, POWER_MCU_IDLE_UA, POWER_MCU_STANDBY_UA},
+            {0, POWER_RADIO_SAVE_UA, POWER_RADIO_LISTEN_UA},
+            {POWER_DISPLAY_OFF_UA, POWER_DISPLAY_ON_UA, 0}};
+        return currents[domain][state];
+    }
+
+    static void printMilliamps(Print &out, uint64_t microamps)
+    {
+        char text[16];
+        FixedPoint::format(text, (int32_t)microamps, 3);
+        out.print(text);
+        out.print(F(" mA"));
+    }
+
+public:
+    // Anzahl der Schlafphasen
+    unsigned long standbys = 0;
+    unsigned long idles = 0;
+
+    /**
+     *
+     * Startet das Energiemodell. Mit 'LOW_POWER_MODE' wird der RTC als
+     * Wecker eingerichtet (32 Bit Zähler mit 1024 Hz aus dem internen 32 kHz
+     * Oszillator) und der Interrupt an 'wakePin' weckt auch aus dem Standby.
+     * Muss nach 'attachInterrupt' aufgerufen werden.
+     *
+     **/
+    void begin(uint8_t wakePin)
+    {
+        // Das Energiemodell beginnt erst nach der Initialisierung
+        millisStart = millis();
+        for (uint8_t i = 0; i < POWER_DOMAIN_COUNT; i++)
+        {
+            since[i] = millisStart;
+        }
+        memset(stateTime, 0, sizeof(stateTime));
+        eventCharge = 0;
+
+#if defined(ARDUINO) && defined(LOW_POWER_MODE)
+        // GCLK2: OSCULP32K / 32 = 1024 Hz, läuft auch im Standby
+        GCLK->GENDIV.reg = GCLK_GENDIV_ID(2) | GCLK_GENDIV_DIV(4);
+        while (GCLK->STATUS.bit.SYNCBUSY)
+            ;
+        GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(2) | GCLK_GENCTRL_SRC_OSCULP32K | GCLK_GENCTRL_GENEN |
+                            GCLK_GENCTRL_DIVSEL | GCLK_GENCTRL_RUNSTDBY;
+        while (GCLK->STATUS.bit.SYNCBUSY)
+            ;
+        GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_RTC | GCLK_CLKCTRL_GEN_GCLK2 | GCLK_CLKCTRL_CLKEN;
+        while (GCLK->STATUS.bit.SYNCBUSY)
+            ;
+
+        PM->APBAMASK.reg |= PM_APBAMASK_RTC;
+        RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_SWRST;
+        while (RTC->MODE0.CTRL.reg & RTC_MODE0_CTRL_SWRST)
+            ;
+        RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_MODE_COUNT32 | RTC_MODE0_CTRL_PRESCALER_DIV1;
+        rtcSync();
+        RTC->MODE0.INTENSET.reg = RTC_MODE0_INTENSET_CMP0;
+        NVIC_EnableIRQ(RTC_IRQn);
+        RTC->MODE0.CTRL.reg |= RTC_MODE0_CTRL_ENABLE;
+        rtcSync();
+
+        // Externe Interrupts (Taster, WiFi Modul) ebenfalls über GCLK2
+        GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_EIC | GCLK_CLKCTRL_GEN_GCLK2 | GCLK_CLKCTRL_CLKEN;
+        while (GCLK->STATUS.bit.SYNCBUSY)
+            ;
+        EIC->WAKEUP.reg |= 1 << g_APinDescription[wakePin].ulExtInt;
+#else
+        // Ohne Standby muss kein Pin den Prozessor aufwecken
+        (void)wakePin;
+#endif
+    }
+
+    /**
+     *
+     * Muss aus 'RTC_Handler' aufgerufen werden.
+     *
+     **/
+    void rtcInterrupt()
+    {
+#if defined(ARDUINO) && defined(LOW_POWER_MODE)
+        RTC->MODE0.INTFLAG.reg = RTC_MODE0_INTFLAG_CMP0;
+#endif
+    }
+
+    /**
+     *
+     * Wechselt den Zustand einer Baugruppe, die Zeit im vorherigen
+     * Zustand wird gezählt.
+     *
+     **/
+    void set(PowerDomain domain, uint8_t state)
+    {
+        unsigned long now = millis();
+        stateTime[domain][states[domain]] += now - since[domain];
+        since[domain] = now;
+        states[domain] = state;
+    }
+
+    uint8_t get(PowerDomain domain) { return states[domain]; }
+
+    /**
+     *
+     * Addiert einen kurzen Vorgang mit 'microamps' über 'ms'.
+     *
+     **/
+    void charge(uint32_t microamps, unsigned long ms)
+    {
+        eventCharge += (uint64_t)microamps * ms;
+    }
+
+    // Typische Vorgänge des WiFi Moduls
+    void radioJoin(bool fast = false)
+    {
+        charge(POWER_RADIO_ACTIVE_UA, fast ? POWER_RADIO_FAST_JOIN_TIME : POWER_RADIO_JOIN_TIME);
+    }
+    void radioHandshake() { charge(POWER_RADIO_ACTIVE_UA, POWER_RADIO_HANDSHAKE_TIME); }
+    void radioTransfer(uint32_t bytes)
+    {
+        charge(POWER_RADIO_ACTIVE_UA, POWER_RADIO_REQUEST_TIME + bytes / POWER_RADIO_BYTES_PER_MS);
+    }
+
+    /**
+     *
+     * Schläft bis zur nächsten Aufgabe in 'ms', wird am Ende von loop()
+     * aufgerufen. Kurze Wartezeiten (unter 'POWER_STANDBY_MIN') schlafen nur
+     * bis zum nächsten SysTick. In der Simulation läuft die Uhr erst nach
+     * loop() weiter, daher wird erst mit 'wake' zurück auf aktiv gewechselt.
+     *
+     **/
+    void sleep(unsigned long ms)
+    {
+        if (ms == 0)
+        {
+            return;
+        }
+
+        if (ms < POWER_STANDBY_MIN)
+        {
+            idles++;
+            set(POWER_MCU, MCU_IDLE);
+#if defined(ARDUINO) && defined(LOW_POWER_MODE)
+            idle();
+#endif
+        }
+        else
+        {
+            standbys++;
+            set(POWER_MCU, MCU_STANDBY);
+#if defined(ARDUINO) && defined(LOW_POWER_MODE)
+            standby(ms);
+#endif
+        }
+    }
+
+    /**
+     *
+     * Zu Beginn von loop(), die MCU ist wieder aktiv.
+     *
+     **/
+    void wake()
+    {
+        if (states[POWER_MCU] != MCU_ACTIVE)
+        {
+            set(POWER_MCU, MCU_ACTIVE);
+        }
+    }
+
+    /**
+     *
+     * Ladung einer Baugruppe seit 'begin' in µA·ms.
+     *
+     **/
+    uint64_t domainCharge(uint8_t domain)
+    {
+        uint64_t sum = 0;
+        for (uint8_t state = 0; state < POWER_STATE_COUNT; state++)
+        {
+            unsigned long ms = stateTime[domain][state];
+            if (state == states[domain])
+            {
+                ms += millis() - since[domain];
+            }
+            sum += (uint64_t)current(domain, state) * ms;
+        }
+        return sum;
+    }
+
+    /**
+     *
+     * Durchschnittlicher Strom seit 'begin' in µA, inklusive 'POWER_BASE_UA'.
+     *
+     **/
+    uint32_t averageMicroamps()
+    {
+        unsigned long elapsed = millis() - millisStart;
+        if (elapsed == 0)
+        {
+            return 0;
+        }
+        uint64_t sum = eventCharge;
+        for (uint8_t i = 0; i < POWER_DOMAIN_COUNT; i++)
+        {
+            sum += domainCharge(i);
+        }
+        return sum / elapsed + POWER_BASE_UA;
+    }
+
+    /**
+     *
+     * Gibt das Energiemodell aus, z.B. auf 'Serial'.
+     *
+     **/
+    void report(Print &out)
+    {
+        static const char *const names[POWER_DOMAIN_COUNT] = {"mcu", "radio", "display"};
+        unsigned long elapsed = millis() - millisStart;
+        if (elapsed == 0)
+        {
+            return;
+        }
+
+        out.println(F("[Power] Average current:"));
+        for (uint8_t i = 0; i < POWER_DOMAIN_COUNT; i++)
+        {
+            out.print(F("  "));
+            out.print(names[i]);
+            out.print(F(": "));
+            printMilliamps(out, domainCharge(i) / elapsed);
+            out.println();
+        }
+        out.print(F("  radio events: "));
+        printMilliamps(out, eventCharge / elapsed);
+        out.println();
+        out.print(F("  base: "));
+        printMilliamps(out, POWER_BASE_UA);
+        out.println();
+
+        uint32_t average = averageMicroamps();
+        out.print(F("[Power] Total: "));
+        printMilliamps(out, average);
+        out.print(F(", "));
+        out.print((uint32_t)((uint64_t)POWER_BATTERY_MAH * 1000 / (average > 0 ? average : 1)));
+        out.println(F(" h on the battery"));
+    }
+};
+
+/**
+ *
+ * Einzige Instanz, auch über mehrere Übersetzungseinheiten.
+ *
+ **/
+inline PowerManager &power()
+{
+    static PowerManager instance;
+    return instance;
+}
+
+#endif
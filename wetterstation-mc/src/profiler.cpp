@@ -0,0 +1,246 @@
+#include <Arduino.h>
+#include "config.h"
+#include "fixedpoint.cpp"
+
+#ifndef __PROFILER_H_INC__
+#define __PROFILER_H_INC__
+
+/**
+ *
+ * Gemessene Programmteile, für jeden wird Anzahl, Minimum, Maximum und
+ * Summe der Laufzeit in µs gesammelt.
+ *
+ **/
+enum ProfileSection
+{
+    PROFILE_SETUP,
+    PROFILE_SENSORS,
+    PROFILE_PM,
+    PROFILE_WINDRAD,
+    PROFILE_NETWORK_POLL,
+    PROFILE_NETWORK_POST,
+    PROFILE_LOG,
+    PROFILE_DISPLAY,
+    PROFILE_SECTION_COUNT
+};
+
+// Anzahl der zusätzlichen Kanäle für die openSenseMap
+#if defined(ENABLE_PROFILING) && defined(PROFILE_LOOP_ID)
+#define PROFILE_LOOP_CHANNELS 1
+#else
+#define PROFILE_LOOP_CHANNELS 0
+#endif
+#if defined(ENABLE_PROFILING) && defined(PROFILE_BUSY_ID)
+#define PROFILE_BUSY_CHANNELS 1
+#else
+#define PROFILE_BUSY_CHANNELS 0
+#endif
+#define PROFILE_UPLOAD_CHANNELS (PROFILE_LOOP_CHANNELS + PROFILE_BUSY_CHANNELS)
+
+// Histogramm der Schleifendauer, Klasse 'i' enthält Dauern von 2^i bis 2^(i+1)-1 µs
+#define PROFILE_HISTOGRAM_SIZE 24
+
+typedef struct profileStats
+{
+    unsigned long count;
+    unsigned long min;
+    unsigned long max;
+    uint64_t sum;
+} profileStats;
+
+/**
+ *
+ * Sammelt die Laufzeiten der Programmteile und der Hauptschleife.
+ * Erfasst wird über die Makros 'PROFILE_SCOPE' und 'PROFILE_LOOP', ohne
+ * 'ENABLE_PROFILING' entfallen diese vollständig.
+ *
+ **/
+class Profiler
+{
+private:
+    profileStats sections[PROFILE_SECTION_COUNT];
+    profileStats loops;
+    unsigned long histogram[PROFILE_HISTOGRAM_SIZE];
+
+    // Beginn der aktuellen Auswertung, für den Anteil der Rechenzeit
+    unsigned long millisStart = 0;
+
+    static void add(profileStats &stats, unsigned long duration)
+    {
+        if (stats.count == 0 || duration < stats.min)
+        {
+            stats.min = duration;
+        }
+        if (duration > stats.max)
+        {
+            stats.max = duration;
+        }
+        stats.sum += duration;
+        stats.count++;
+    }
+
+    static void print(Print &out, const char *name, const profileStats &stats)
+    {
+        out.print(name);
+        out.print(F(": n="));
+        out.print(stats.count);
+        out.print(F(" min="));
+        out.print(stats.count > 0 ? stats.min : 0UL);
+        out.print(F(" max="));
+        out.print(stats.max);
+        out.print(F(" avg="));
+        out.print(stats.count > 0 ? (unsigned long)(stats.sum / stats.count) : 0UL);
+        out.println(F(" us"));
+    }
+
+public:
+    static const char *name(ProfileSection section)
+    {
+        static const char *const names[PROFILE_SECTION_COUNT] = {
+            "setup", "sensors", "pm", "windrad", "network poll", "network post", "log", "display"};
+        return names[section];
+    }
+
+    Profiler()
+    {
+        reset();
+    }
+
+    void record(ProfileSection section, unsigned long duration)
+    {
+        add(sections[section], duration);
+    }
+
+    void recordLoop(unsigned long duration)
+    {
+        add(loops, duration);
+
+        uint8_t bucket = 0;
+        while (duration > 1 && bucket < PROFILE_HISTOGRAM_SIZE - 1)
+        {
+            duration >>= 1;
+            bucket++;
+        }
+        histogram[bucket]++;
+    }
+
+    const profileStats &get(ProfileSection section) const
+    {
+        return sections[section];
+    }
+
+    const profileStats &getLoops() const
+    {
+        return loops;
+    }
+
+    /**
+     *
+     * Anteil der Zeit in der Hauptschleife seit dem letzten 'reset',
+     * in Hundertstel Prozent.
+     *
+     **/
+    uint32_t busyShare() const
+    {
+        unsigned long elapsed = millis() - millisStart;
+        if (elapsed == 0)
+        {
+            return 0;
+        }
+        return loops.sum * 10 / elapsed;
+    }
+
+    /**
+     *
+     * Gibt alle Statistiken und das Histogramm aus, z.B. auf 'Serial'.
+     *
+     **/
+    void report(Print &out)
+    {
+        out.println(F("[Profiler] Sections:"));
+        for (uint8_t i = 0; i < PROFILE_SECTION_COUNT; i++)
+        {
+            if (sections[i].count > 0)
+            {
+                print(out, name((ProfileSection)i), sections[i]);
+            }
+        }
+        print(out, "loop", loops);
+
+        out.println(F("[Profiler] Loop histogram:"));
+        for (uint8_t i = 0; i < PROFILE_HISTOGRAM_SIZE; i++)
+        {
+            if (histogram[i] > 0)
+            {
+                out.print(F("< "));
+                out.print(2UL << i);
+                out.print(F(" us: "));
+                out.println(histogram[i]);
+            }
+        }
+
+        char busy[12];
+        FixedPoint::format(busy, busyShare(), 2);
+        out.print(F("[Profiler] Busy: "));
+        out.print(busy);
+        out.println(F(" %"));
+    }
+
+    void reset()
+    {
+        memset(sections, 0, sizeof(sections));
+        memset(&loops, 0, sizeof(loops));
+        memset(histogram, 0, sizeof(histogram));
+        millisStart = millis();
+    }
+};
+
+/**
+ *
+ * Einzige Instanz des Profilers, auch über mehrere Übersetzungseinheiten.
+ *
+ **/
+inline Profiler &profiler()
+{
+    static Profiler instance;
+    return instance;
+}
+
+/**
+ *
+ * Misst die Laufzeit vom Anlegen bis zum Ende des Blocks.
+ *
+ **/
+class ProfileScope
+{
+private:
+    ProfileSection section;
+    bool loop;
+    unsigned long start;
+
+public:
+    ProfileScope(ProfileSection section, bool loop = false) : section(section), loop(loop), start(micros()) {}
+
+    ~ProfileScope()
+    {
+        unsigned long duration = micros() - start;
+        if (loop)
+        {
+            profiler().recordLoop(duration);
+        }
+        else
+        {
+            profiler().record(section, duration);
+        }
+    }
+};
+
+#ifdef ENABLE_PROFILING
+#define PROFILE_SCOPE(section) ProfileScope profileScope(section)
+#define PROFILE_LOOP() ProfileScope profileLoopScope(PROFILE_SECTION_COUNT, true)
+#else
+#define PROFILE_SCOPE(section)
+#define PROFILE_LOOP()
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+#include <Arduino.h>
+
+#ifndef __RINGBUFFER_H_INC__
+#define __RINGBUFFER_H_INC__
+
+/**
+ *
+ * Ringpuffer mit fester Größe 'N' für Einträge vom Typ 'T' (kein Heap).
+ * Ist der Puffer voll, wird beim Hinzufügen der älteste Eintrag überschrieben
+ * und 'dropped' hochgezählt.
+ *
+ **/
+template <typename T, uint16_t N>
+class RingBuffer
+{
+private:
+    T entries[N];
+
+    // Position des ältesten Eintrags und Anzahl der Einträge
+    uint16_t head = 0;
+    uint16_t count = 0;
+
+public:
+    // Anzahl der überschriebenen Einträge seit dem Start
+    unsigned long dropped = 0;
+
+    /**
+     *
+     * Fügt einen Eintrag am Ende hinzu.
+     *
+     **/
+    void push(const T &entry)
+    {
+        if (count == N)
+        {
+            head = (head + 1) % N;
+            count--;
+            dropped++;
+        }
+
+        entries[(head + count) % N] = entry;
+        count++;
+    }
+
+    /**
+     *
+     * Liefert den 'index'-ten Eintrag, 0 ist der älteste.
+     *
+     **/
+    T &at(uint16_t index)
+    {
+        return entries[(head + index) % N];
+    }
+
+    /**
+     *
+     * Entfernt die 'n' ältesten Einträge.
+     *
+     **/
+    void pop(uint16_t n = 1)
+    {
+        if (n > count)
+        {
+            n = count;
+        }
+        head = (head + n) % N;
+        count -= n;
+    }
+
+    uint16_t size() { return count; }
+    uint16_t capacity() { return N; }
+    bool isEmpty() { return count == 0; }
+    bool isFull() { return count == N; }
+};
+
+#endif
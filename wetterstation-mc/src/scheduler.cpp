@@ -0,0 +1,293 @@
+#include <Arduino.h>
+#include "config.h"
+#include "utils.cpp"
+
+#ifndef __SCHEDULER_H_INC__
+#define __SCHEDULER_H_INC__
+
+// Callback einer Aufgabe, entspricht dem Zeiger welcher z.B. auch
+// an 'Network::networkHandle' übergeben wird.
+typedef void (*taskCallback)();
+
+// Die bereits ausgeführten Aufgaben eines Durchlaufs werden als Bitmaske gemerkt.
+static_assert(SCHEDULER_MAX_TASKS <= 32, "SCHEDULER_MAX_TASKS must not exceed 32");
+
+/**
+ *
+ * Struktur einer geplanten Aufgabe.
+ * 'interval' ist bei einmaligen Aufgaben 0, 'deadline' ist der
+ * Zeitpunkt (in ms) an dem die Aufgabe spätestens ausgeführt werden soll.
+ *
+ **/
+typedef struct schedulerTask
+{
+    taskCallback callback;
+    unsigned long deadline;
+    unsigned long interval;
+    bool active;
+} schedulerTask;
+
+/**
+ *
+ * Kooperativer Scheduler mit fester Anzahl an Aufgaben (kein Heap).
+ * Aufgaben werden in der Reihenfolge ihrer Deadline abgearbeitet,
+ * blockierende Wartezeiten (delay) entfallen dadurch in der Hauptroutine.
+ *
+ * Die Zeitquelle wird über den Konstruktor übergeben, standardmäßig 'millis'.
+ * So kann der Scheduler auch mit einer simulierten Uhr betrieben werden.
+ *
+ **/
+class Scheduler
+{
+private:
+    // Alle registrierten Aufgaben, freie Plätze haben 'active' auf false.
+    schedulerTask tasks[SCHEDULER_MAX_TASKS];
+
+    // Zeitquelle in Millisekunden.
+    unsigned long (*clock)();
+
+    // Zeitpunkt des letzten 'run' Aufrufs, für die Messung der Schleifenlatenz.
+    unsigned long lastRun = 0;
+    bool hasRun = false;
+
+    // Statistiken: größte Verspätung einer Aufgabe gegenüber ihrer Deadline,
+    // längste Dauer eines 'run' Durchlaufs und größter Abstand zwischen zwei
+    // 'run' Aufrufen (schlechteste Reaktionszeit der Hauptroutine).
+    unsigned long maxJitter = 0;
+    unsigned long maxRunTime = 0;
+    unsigned long maxLoopLatency = 0;
+    unsigned long executions = 0;
+
+    /**
+     *
+     * Liefert true wenn 'time' zum Zeitpunkt 'now' erreicht oder überschritten ist.
+     * Der Vergleich ist sicher gegenüber dem Überlauf von millis().
+     *
+     **/
+    static bool isDue(unsigned long time, unsigned long now)
+    {
+        return (long)(now - time) >= 0;
+    }
+
+    int8_t add(taskCallback callback, unsigned long interval, unsigned long delay)
+    {
+        for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+        {
+            if (tasks[i].active == false)
+            {
+                tasks[i].callback = callback;
+                tasks[i].interval = interval;
+                tasks[i].deadline = clock() + delay;
+                tasks[i].active = true;
+                return i;
+            }
+        }
+
+        DEBUG(F("[Scheduler] No free task slot, increase SCHEDULER_MAX_TASKS"));
+        return -1;
+    }
+
+public:
+    /**
+     *
+     * Registriert eine periodische Aufgabe. Die erste Ausführung erfolgt
+     * nach 'delay' Millisekunden, danach alle 'interval' Millisekunden.
+     * Rückgabewert ist die ID der Aufgabe oder -1 wenn kein Platz mehr frei ist.
+     *
+     **/
+    int8_t addPeriodic(taskCallback callback, unsigned long interval, unsigned long delay = 0)
+    {
+        return add(callback, interval, delay);
+    }
+
+    /**
+     *
+     * Registriert eine einmalige Aufgabe, welche nach 'delay' Millisekunden
+     * ausgeführt und im Anschluss wieder freigegeben wird.
+     *
+     **/
+    int8_t addOnce(taskCallback callback, unsigned long delay)
+    {
+        return add(callback, 0, delay);
+    }
+
+    /**
+     *
+     * Verschiebt die nächste Ausführung einer Aufgabe auf 'delay'
+     * Millisekunden ab jetzt.
+     *
+     **/
+    void reschedule(int8_t id, unsigned long delay)
+    {
+        if (id >= 0 && id < SCHEDULER_MAX_TASKS && tasks[id].active)
+        {
+            tasks[id].deadline = clock() + delay;
+        }
+    }
+
+    /**
+     *
+     * Entfernt eine Aufgabe aus dem Scheduler.
+     *
+     **/
+    void cancel(int8_t id)
+    {
+        if (id >= 0 && id < SCHEDULER_MAX_TASKS)
+        {
+            tasks[id].active = false;
+        }
+    }
+
+    /**
+     *
+     * Liefert die Zeit in Millisekunden bis zur nächsten fälligen Aufgabe,
+     * 0 wenn bereits eine Aufgabe fällig ist.
+     *
+     **/
+    unsigned long timeUntilNext()
+    {
+        unsigned long now = clock();
+        unsigned long next = 0xFFFFFFFF;
+
+        for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+        {
+            if (tasks[i].active == false)
+            {
+                continue;
+            }
+            if (isDue(tasks[i].deadline, now))
+            {
+                return 0;
+            }
+            if (tasks[i].deadline - now < next)
+            {
+                next = tasks[i].deadline - now;
+            }
+        }
+        return next;
+    }
+
+    /**
+     *
+     * Diese Methode gehört in die Hauptroutine des Programms.
+     * Alle zum Aufrufzeitpunkt fälligen Aufgaben werden einmal ausgeführt,
+     * die mit der frühesten Deadline zuerst. Periodische Aufgaben werden
+     * ohne Drift auf ihre nächste Deadline gesetzt, verpasste Durchläufe
+     * werden übersprungen und nicht nachgeholt.
+     *
+     **/
+    void run()
+    {
+        unsigned long start = clock();
+
+        if (hasRun && start - lastRun > maxLoopLatency)
+        {
+            maxLoopLatency = start - lastRun;
+        }
+
+        // Merke welche Aufgaben in diesem Durchlauf schon ausgeführt wurden,
+        // damit eine Aufgabe mit kurzem Intervall die anderen nicht verdrängt.
+        uint32_t done = 0;
+
+        while (true)
+        {
+            int8_t next = -1;
+            for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+            {
+                if (tasks[i].active == false || (done & (1UL << i)) || !isDue(tasks[i].deadline, start))
+                {
+                    continue;
+                }
+                if (next < 0 || (long)(tasks[i].deadline - tasks[next].deadline) < 0)
+                {
+                    next = i;
+                }
+            }
+
+            if (next < 0)
+            {
+                break;
+            }
+
+            schedulerTask *task = &tasks[next];
+            unsigned long now = clock();
+            if (now - task->deadline > maxJitter)
+            {
+                maxJitter = now - task->deadline;
+            }
+
+            // Deadline vor dem Aufruf setzen, so kann die Aufgabe sich
+            // selbst neu planen oder entfernen.
+            if (task->interval == 0)
+            {
+                task->active = false;
+            }
+            else
+            {
+                task->deadline += task->interval;
+                if (isDue(task->deadline, now))
+                {
+                    task->deadline = now + task->interval;
+                }
+            }
+
+            done |= 1UL << next;
+            executions++;
+            task->callback();
+        }
+
+        lastRun = clock();
+        hasRun = true;
+        if (lastRun - start > maxRunTime)
+        {
+            maxRunTime = lastRun - start;
+        }
+    }
+
+    unsigned long getMaxJitter() { return maxJitter; }
+    unsigned long getMaxRunTime() { return maxRunTime; }
+    unsigned long getMaxLoopLatency() { return maxLoopLatency; }
+    unsigned long getExecutions() { return executions; }
+
+    // Anzahl der registrierten Aufgaben
+    uint8_t getTaskCount()
+    {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+        {
+            count += tasks[i].active ? 1 : 0;
+        }
+        return count;
+    }
+
+    /**
+     *
+     * Setzt alle Statistiken zurück, z.B. nach der Initialisierung
+     * damit 'setup' nicht in die Messung eingeht.
+     *
+     **/
+    void resetStatistics()
+    {
+        maxJitter = 0;
+        maxRunTime = 0;
+        maxLoopLatency = 0;
+        executions = 0;
+        hasRun = false;
+    }
+
+    /**
+     *
+     * Erzeugt einen neuen Scheduler mit der Zeitquelle 'clock'.
+     *
+     **/
+    Scheduler(unsigned long (*clock)() = millis)
+    {
+        this->clock = clock;
+        for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+        {
+            tasks[i].active = false;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,742 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include "config.h"
+#include "utils.cpp"
+
+#include <Adafruit_BMP280.h>
+#include <Adafruit_HDC1000.h>
+#include <Makerblog_TSL45315.h>
+#include <VEML6070.h>
+
+#include "measurement.h"
+#include "statistics.cpp"
+#include "filter.cpp"
+#include "derived.cpp"
+#include "profiler.cpp"
+
+#ifndef __SENSORS_H_INC__
+#define __SENSORS_H_INC__
+
+/*
+    Aktivierte Sensoren, abgeleitet aus den '*_CONNECTED' Schaltern in
+    config.h. Nur hier wird noch mit #ifdef gearbeitet.
+*/
+
+#ifdef BMP280_CONNECTED
+#define BMP280_ENABLED true
+#else
+#define BMP280_ENABLED false
+#endif
+
+#ifdef HDC1080_CONNECTED
+#define HDC1080_ENABLED true
+#else
+#define HDC1080_ENABLED false
+#endif
+
+#ifdef TSL45315_CONNECTED
+#define TSL45315_ENABLED true
+#else
+#define TSL45315_ENABLED false
+#endif
+
+#ifdef VEML6070_CONNECTED
+#define VEML6070_ENABLED true
+#else
+#define VEML6070_ENABLED false
+#endif
+
+#ifdef PM_CONNECTED
+#define PM_ENABLED true
+#else
+#define PM_ENABLED false
+#endif
+
+#ifdef WINDRAD_CONNECTED
+#define WINDRAD_ENABLED true
+#else
+#define WINDRAD_ENABLED false
+#endif
+
+/*
+    Nicht konfigurierte openSenseMap IDs, diese Kanäle werden
+    gemessen aber nicht gesendet.
+*/
+
+#ifndef TEMPERATURE_ID
+#define TEMPERATURE_ID NULL
+#endif
+#ifndef PRESSURE_ID
+#define PRESSURE_ID NULL
+#endif
+#ifndef ALTITUDE_ID
+#define ALTITUDE_ID NULL
+#endif
+#ifndef HDC1080_TEMPERATURE_ID
+#define HDC1080_TEMPERATURE_ID NULL
+#endif
+#ifndef HUMIDITY_ID
+#define HUMIDITY_ID NULL
+#endif
+#ifndef ILLUMINANCE_ID
+#define ILLUMINANCE_ID NULL
+#endif
+#ifndef UV_RADIATION_ID
+#define UV_RADIATION_ID NULL
+#endif
+#ifndef PM_PM25_ID
+#define PM_PM25_ID NULL
+#endif
+#ifndef PM_PM10_ID
+#define PM_PM10_ID NULL
+#endif
+#ifndef WINDRAD_SPEED_ID
+#define WINDRAD_SPEED_ID NULL
+#endif
+#ifndef WINDRAD_DIRECTION_ID
+#define WINDRAD_DIRECTION_ID NULL
+#endif
+#ifndef SEA_LEVEL_PRESSURE_ID
+#define SEA_LEVEL_PRESSURE_ID NULL
+#endif
+#ifndef DEW_POINT_ID
+#define DEW_POINT_ID NULL
+#endif
+#ifndef PRESSURE_TENDENCY_ID
+#define PRESSURE_TENDENCY_ID NULL
+#endif
+#ifndef AQI_ID
+#define AQI_ID NULL
+#endif
+
+// Länge einer von der openSenseMap vergebenen ID
+#define OSM_ID_LENGTH 24
+
+/**
+ *
+ * Ein Messkanal eines Sensors: das Feld in 'Measurment' und die
+ * openSenseMap ID unter der es gesendet wird (NULL = nicht senden).
+ *
+ **/
+typedef struct SensorChannel
+{
+    MeasurementField field;
+    const char *sensorId;
+} SensorChannel;
+
+/*
+    Sensortreiber
+
+    Jeder Treiber besitzt sein Bibliotheksobjekt und beschreibt sich über:
+      channelCount    Anzahl der Messkanäle
+      channel(i)      Feld und openSenseMap ID des Kanals 'i' (constexpr)
+      readTime        ungefähre Busdauer von 'trigger' und 'collect' in ms
+      conversionTime  Wartezeit zwischen 'trigger' und 'collect' in ms
+      startupTime     Wartezeit nach 'begin' bis zur ersten Messung in ms
+      period          Intervall zwischen zwei Messungen in ms (Abtastrate)
+      begin()         Initialisierung, einmalig in setup()
+      trigger()       startet eine Messung, leer wenn der Sensor selbständig misst
+      collect(data)   liest das Ergebnis, schreibt die Kanäle in 'data'
+
+    Zwischen 'trigger' und 'collect' wird nicht gewartet, in dieser Zeit
+    laufen die anderen Aufgaben (siehe 'SensorRegistry::poll'). Jeder
+    Treiber filtert seine Kanäle in 'collect' (filter.cpp), bevor sie in
+    'Measurment' und damit in Mittelwerte, Display und Upload eingehen.
+*/
+
+class Bmp280Driver
+{
+private:
+    Adafruit_BMP280 bmp;
+    SampleFilter<FILTER_WINDOW, FILTER_TEMPERATURE> temperatureFilter;
+    SampleFilter<FILTER_WINDOW, FILTER_PRESSURE> pressureFilter;
+
+public:
+    static const uint8_t channelCount = 3;
+    static const unsigned long readTime = 3;
+    // Misst im 'normal mode' selbständig, eine Messung dauert ca. 76 ms
+    static const unsigned long conversionTime = 0;
+    static const unsigned long startupTime = 80;
+    static const unsigned long period = BMP280_SAMPLE_INTERVAL;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return i == 0   ? SensorChannel{FIELD_TEMPERATURE, TEMPERATURE_ID}
+               : i == 1 ? SensorChannel{FIELD_PRESSURE, PRESSURE_ID}
+                        : SensorChannel{FIELD_ALTITUDE, ALTITUDE_ID};
+    }
+
+    void begin()
+    {
+        bmp.begin(0x76);
+    }
+
+    void trigger() {}
+
+    void collect(Measurment &data)
+    {
+        unsigned long now = millis();
+        data.Temperature = bmp.readTemperature();
+        data.Pressure = bmp.readPressure() / 100;
+        temperatureFilter.apply(data.Temperature, now);
+        pressureFilter.apply(data.Pressure, now);
+        // Wie 'readAltitude', aber aus dem gefilterten Luftdruck
+        data.Altitute = 44330 * (1 - powf(data.Pressure.toFloat() / ALTITUDE_P0, 0.1903f));
+        data.setValid(FIELD_TEMPERATURE);
+        data.setValid(FIELD_PRESSURE);
+        data.setValid(FIELD_ALTITUDE);
+    }
+};
+
+/**
+ *
+ * Die Bibliothek konfiguriert den HDC1080 für Temperatur und Feuchte in
+ * einer Messung (14 Bit). Statt 'readTemperature' und 'readHumidity', welche
+ * je 20 ms auf die Wandlung warten, wird die Messung direkt über den Bus
+ * gestartet und beide Werte später mit einem Lesezugriff abgeholt.
+ *
+ **/
+class Hdc1080Driver
+{
+private:
+    Adafruit_HDC1000 hdc;
+    SampleFilter<FILTER_WINDOW, FILTER_TEMPERATURE> temperatureFilter;
+    SampleFilter<FILTER_WINDOW, FILTER_HUMIDITY> humidityFilter;
+
+    static const uint8_t address = 0x40;
+
+public:
+    static const uint8_t channelCount = 2;
+    static const unsigned long readTime = 1;
+    // Wandlungszeit wie in der Bibliothek (Datenblatt: 6.35 ms + 6.5 ms)
+    static const unsigned long conversionTime = 20;
+    static const unsigned long startupTime = 15;
+    static const unsigned long period = HDC1080_SAMPLE_INTERVAL;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return i == 0 ? SensorChannel{FIELD_HDC1080_TEMPERATURE, HDC1080_TEMPERATURE_ID}
+                      : SensorChannel{FIELD_HUMIDITY, HUMIDITY_ID};
+    }
+
+    void begin()
+    {
+        hdc.begin();
+    }
+
+    // Zeiger auf das Temperatur Register startet die Messung
+    void trigger()
+    {
+        Wire.beginTransmission(address);
+        Wire.write((uint8_t)0x00);
+        Wire.endTransmission();
+    }
+
+    void collect(Measurment &data)
+    {
+        if (Wire.requestFrom(address, (uint8_t)4) != 4)
+        {
+            data.setInvalid(FIELD_HDC1080_TEMPERATURE);
+            data.setInvalid(FIELD_HUMIDITY);
+            return;
+        }
+
+        uint16_t temperature = Wire.read() << 8;
+        temperature |= Wire.read();
+        uint16_t humidity = Wire.read() << 8;
+        humidity |= Wire.read();
+
+        data.Hdc1080Temperature = temperature * 165.0f / 65536 - 40;
+        data.Humidity = humidity * 100.0f / 65536;
+        unsigned long now = millis();
+        temperatureFilter.apply(data.Hdc1080Temperature, now);
+        humidityFilter.apply(data.Humidity, now);
+        data.setValid(FIELD_HDC1080_TEMPERATURE);
+        data.setValid(FIELD_HUMIDITY);
+    }
+};
+
+class Tsl45315Driver
+{
+private:
+    Makerblog_TSL45315 tsl = Makerblog_TSL45315(TSL45315_TIME_M4);
+    SampleFilter<FILTER_WINDOW, FILTER_LUX> luxFilter;
+
+public:
+    static const uint8_t channelCount = 1;
+    static const unsigned long readTime = 1;
+    // Misst fortlaufend, Integrationszeit bei 'TSL45315_TIME_M4' 100 ms
+    static const unsigned long conversionTime = 0;
+    static const unsigned long startupTime = 100;
+    static const unsigned long period = TSL45315_SAMPLE_INTERVAL;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return SensorChannel{FIELD_LUX, ILLUMINANCE_ID};
+    }
+
+    void begin()
+    {
+        tsl.begin();
+    }
+
+    void trigger() {}
+
+    void collect(Measurment &data)
+    {
+        data.Lux = tsl.readLux();
+        luxFilter.apply(data.Lux, millis());
+        data.setValid(FIELD_LUX);
+    }
+};
+
+class Veml6070Driver
+{
+private:
+    VEML6070 veml;
+    SampleFilter<FILTER_WINDOW, FILTER_UV> uvFilter;
+
+public:
+    static const uint8_t channelCount = 1;
+    static const unsigned long readTime = 1;
+    // Misst fortlaufend, erste Messung nach der Integrationszeit
+    static const unsigned long conversionTime = 0;
+    static const unsigned long startupTime = 500;
+    static const unsigned long period = VEML6070_SAMPLE_INTERVAL;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return SensorChannel{FIELD_UV, UV_RADIATION_ID};
+    }
+
+    void begin()
+    {
+        veml.begin();
+    }
+
+    void trigger() {}
+
+    void collect(Measurment &data)
+    {
+        data.UV = veml.getUV();
+        uvFilter.apply(data.UV, millis());
+        data.setValid(FIELD_UV);
+    }
+};
+
+/**
+ *
+ * Der SDS011 wird von 'PmSensor' in eigenen Zyklen gemessen, der Treiber
+ * beschreibt nur die Kanäle für das Senden.
+ *
+ **/
+class PmDriver
+{
+public:
+    static const uint8_t channelCount = 2;
+    static const unsigned long readTime = 0;
+    static const unsigned long conversionTime = 0;
+    static const unsigned long startupTime = 0;
+    static const unsigned long period = PM_REFRESH_INTERVAL;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return i == 0 ? SensorChannel{FIELD_PM25, PM_PM25_ID}
+                      : SensorChannel{FIELD_PM10, PM_PM10_ID};
+    }
+
+    void begin() {}
+    void trigger() {}
+    void collect(Measurment &data) {}
+};
+
+/**
+ *
+ * Das Windrad wird über das Netzwerk abgefragt, die Werte schreibt das
+ * Hauptprogramm. Der Treiber beschreibt nur die Kanäle für das Senden.
+ *
+ **/
+class WindradDriver
+{
+public:
+    static const uint8_t channelCount = 2;
+    static const unsigned long readTime = 0;
+    static const unsigned long conversionTime = 0;
+    static const unsigned long startupTime = 0;
+    static const unsigned long period = SENSOR_REFRESH_INTERVAL;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return i == 0 ? SensorChannel{FIELD_WINDDIRECTION, WINDRAD_DIRECTION_ID}
+                      : SensorChannel{FIELD_WINDSPEED, WINDRAD_SPEED_ID};
+    }
+
+    void begin() {}
+    void trigger() {}
+    void collect(Measurment &data) {}
+};
+
+/**
+ *
+ * Abgeleitete Werte (derived.cpp) als eigene Kanäle. Steht als letzter
+ * Treiber in der Tabelle und rechnet so mit den gerade gelesenen Messungen.
+ *
+ **/
+class DerivedDriver
+{
+private:
+    DerivedMetrics metrics;
+
+public:
+    static const uint8_t channelCount = 4;
+    static const unsigned long readTime = 0;
+    static const unsigned long conversionTime = 0;
+    static const unsigned long startupTime = 0;
+    static const unsigned long period = SENSOR_REFRESH_INTERVAL;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return i == 0   ? SensorChannel{FIELD_SEA_LEVEL_PRESSURE, SEA_LEVEL_PRESSURE_ID}
+               : i == 1 ? SensorChannel{FIELD_DEW_POINT, DEW_POINT_ID}
+               : i == 2 ? SensorChannel{FIELD_PRESSURE_TENDENCY, PRESSURE_TENDENCY_ID}
+                        : SensorChannel{FIELD_AQI, AQI_ID};
+    }
+
+    void begin() {}
+    void trigger() {}
+
+    void collect(Measurment &data)
+    {
+        metrics.update(data, millis());
+    }
+};
+
+/**
+ *
+ * Bindet einen Treiber nur ein wenn 'ENABLED' wahr ist. Ein deaktivierter
+ * Treiber hat keine Kanäle, kein Bibliotheksobjekt und leere Methoden.
+ *
+ **/
+template <bool ENABLED, typename Driver>
+class Optional : public Driver
+{
+};
+
+template <typename Driver>
+class Optional<false, Driver>
+{
+public:
+    static const uint8_t channelCount = 0;
+    static const unsigned long readTime = 0;
+    static const unsigned long conversionTime = 0;
+    static const unsigned long startupTime = 0;
+    static const unsigned long period = 0xFFFFFFFF;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return SensorChannel{FIELD_TEMPERATURE, NULL};
+    }
+
+    void begin() {}
+    void trigger() {}
+    void collect(Measurment &data) {}
+};
+
+/**
+ *
+ * Sendet die Kanäle 'I' bis 'channelCount' eines Treibers an 'sink', als Wert
+ * dient der Mittelwert aus 'stats'. Die Schleife wird zur Compile-Zeit
+ * aufgelöst, Kanäle ohne ID entfallen ganz.
+ *
+ **/
+template <typename Driver, uint8_t I, bool END = (I >= Driver::channelCount)>
+struct ChannelUpload
+{
+    template <typename Sink>
+    static void upload(Sink &sink, const Measurment &data, const MeasurementAggregator &stats)
+    {
+        if (Driver::channel(I).sensorId != NULL)
+        {
+            sink.addMeasurement(Driver::channel(I).sensorId,
+                                stats.value(data, Driver::channel(I).field),
+                                data.isValid(Driver::channel(I).field));
+        }
+        ChannelUpload<Driver, I + 1>::upload(sink, data, stats);
+    }
+};
+
+template <typename Driver, uint8_t I>
+struct ChannelUpload<Driver, I, true>
+{
+    template <typename Sink>
+    static void upload(Sink &sink, const Measurment &data, const MeasurementAggregator &stats) {}
+};
+
+/**
+ *
+ * Tabelle aller Sensoren. Aus den Beschreibungen der Treiber werden zur
+ * Compile-Zeit die Anzahl der Kanäle, die gesendeten IDs und die Lese- bzw.
+ * Sendeschleifen erzeugt, es gibt keine virtuellen Aufrufe.
+ *
+ **/
+template <typename... Drivers>
+class SensorRegistry;
+
+template <>
+class SensorRegistry<>
+{
+public:
+    static const uint8_t channelCount = 0;
+    static const unsigned long readTime = 0;
+    static const unsigned long conversionTime = 0;
+    static const unsigned long period = 0xFFFFFFFF;
+
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return SensorChannel{FIELD_TEMPERATURE, NULL};
+    }
+
+    void begin(unsigned long now) {}
+    unsigned long poll(Measurment &data, unsigned long now) { return 0xFFFFFFFF; }
+    void readAll(Measurment &data) {}
+    bool complete() { return true; }
+
+    template <typename Sink>
+    void upload(Sink &sink, const Measurment &data, const MeasurementAggregator &stats) {}
+};
+
+template <typename Head, typename... Tail>
+class SensorRegistry<Head, Tail...>
+{
+private:
+    typedef SensorRegistry<Tail...> Rest;
+
+    static_assert(Head::conversionTime < Head::period, "A sensor conversion takes longer than its period");
+
+    Head head;
+    Rest rest;
+
+    // Zeitpunkt der nächsten Messung von 'head' und, während einer
+    // laufenden Wandlung, des Ergebnisses
+    unsigned long millisNext = 0;
+    unsigned long millisReady = 0;
+    bool pending = false;
+
+    // Mindestens eine Messung von 'head' seit 'begin'
+    bool collected = false;
+
+public:
+    static const uint8_t channelCount = Head::channelCount + Rest::channelCount;
+
+    // Summe der Busdauern, längste Wandlung und kürzestes Intervall aller Sensoren
+    static const unsigned long readTime = Head::readTime + Rest::readTime;
+    static const unsigned long conversionTime = Head::conversionTime > Rest::conversionTime ? Head::conversionTime : Rest::conversionTime;
+    static const unsigned long period = Head::period < Rest::period ? Head::period : Rest::period;
+
+    // Kanal 'i' über alle Treiber hinweg
+    static constexpr SensorChannel channel(uint8_t i)
+    {
+        return i < Head::channelCount ? Head::channel(i) : Rest::channel(i - Head::channelCount);
+    }
+
+    /**
+     *
+     * Initialisiert alle Sensoren, die erste Messung erfolgt nach
+     * ihrer 'startupTime' ab 'now'.
+     *
+     **/
+    void begin(unsigned long now)
+    {
+        head.begin();
+        millisNext = now + Head::startupTime;
+        pending = false;
+        collected = false;
+        rest.begin(now);
+    }
+
+    /**
+     *
+     * Messung ohne Warten: holt die Ergebnisse aller abgeschlossenen
+     * Wandlungen ab und startet bei jedem Sensor dessen 'period' abgelaufen
+     * ist eine neue Messung. Sensoren ohne 'conversionTime' werden direkt
+     * gelesen. Rückgabewert ist die Zeit in ms bis zum nächsten nötigen
+     * Aufruf, der Scheduler kann die Aufgabe genau dann erneut ausführen.
+     *
+     **/
+    unsigned long poll(Measurment &data, unsigned long now)
+    {
+        unsigned long wait = 0xFFFFFFFF;
+        if (Head::channelCount > 0)
+        {
+            if (pending && (long)(now - millisReady) >= 0)
+            {
+                head.collect(data);
+                pending = false;
+                collected = true;
+            }
+
+            if (!pending && (long)(now - millisNext) >= 0)
+            {
+                head.trigger();
+                millisNext = now + Head::period;
+                if (Head::conversionTime == 0)
+                {
+                    head.collect(data);
+                    collected = true;
+                }
+                else
+                {
+                    millisReady = now + Head::conversionTime;
+                    pending = true;
+                }
+            }
+
+            wait = pending ? millisReady - now : millisNext - now;
+        }
+
+        unsigned long restWait = rest.poll(data, now);
+        return restWait < wait ? restWait : wait;
+    }
+
+    /**
+     *
+     * Liest alle Sensoren nacheinander und wartet dabei auf Startzeit und
+     * Wandlung jedes Sensors. Nur noch für das Zeitmodell der Simulation
+     * (native), gemessen wird mit 'poll'.
+     *
+     **/
+    void readAll(Measurment &data)
+    {
+        if (Head::channelCount > 0)
+        {
+            long startup = (long)(millisNext - millis());
+            if (startup > 0)
+            {
+                delay(startup);
+            }
+            head.trigger();
+            delay(Head::conversionTime);
+            head.collect(data);
+            millisNext = millis() + Head::period;
+            pending = false;
+            collected = true;
+        }
+        rest.readAll(data);
+    }
+
+    /**
+     *
+     * true sobald jeder Sensor seit 'begin' einmal gemessen hat, so läuft
+     * auch die erste Messung in setup() über 'poll'.
+     *
+     **/
+    bool complete()
+    {
+        return (Head::channelCount == 0 || collected) && rest.complete();
+    }
+
+    /**
+     *
+     * Übergibt alle Kanäle mit ID an 'sink', z.B. 'Network::addMeasurement'.
+     *
+     **/
+    template <typename Sink>
+    void upload(Sink &sink, const Measurment &data, const MeasurementAggregator &stats)
+    {
+        ChannelUpload<Head, 0>::upload(sink, data, stats);
+        rest.upload(sink, data, stats);
+    }
+};
+
+/*
+    Prüfungen der Tabelle zur Compile-Zeit
+*/
+
+constexpr uint8_t sensorIdLength(const char *id)
+{
+    return *id == '\0' ? 0 : 1 + sensorIdLength(id + 1);
+}
+
+constexpr bool sensorIdEqual(const char *a, const char *b)
+{
+    return *a == *b && (*a == '\0' || sensorIdEqual(a + 1, b + 1));
+}
+
+// Anzahl der Kanäle ab 'i' welche eine ID haben
+template <typename Registry>
+constexpr uint8_t uploadedChannels(uint8_t i = 0)
+{
+    return i >= Registry::channelCount ? 0
+                                       : (Registry::channel(i).sensorId != NULL ? 1 : 0) + uploadedChannels<Registry>(i + 1);
+}
+
+// Bitmaske der Felder (wie 'Measurment::valid') der Kanäle ab 'i' welche eine ID haben
+template <typename Registry>
+constexpr uint16_t uploadedFields(uint8_t i = 0)
+{
+    return i >= Registry::channelCount
+               ? 0
+               : (Registry::channel(i).sensorId != NULL ? 1 << Registry::channel(i).field : 0) | uploadedFields<Registry>(i + 1);
+}
+
+// Alle IDs ab 'i' haben die Länge einer openSenseMap ID
+template <typename Registry>
+constexpr bool sensorIdsValid(uint8_t i = 0)
+{
+    return i >= Registry::channelCount ||
+           ((Registry::channel(i).sensorId == NULL || sensorIdLength(Registry::channel(i).sensorId) == OSM_ID_LENGTH) &&
+            sensorIdsValid<Registry>(i + 1));
+}
+
+// Die ID von Kanal 'i' kommt ab Kanal 'j' nicht erneut vor
+template <typename Registry>
+constexpr bool sensorIdUnique(uint8_t i, uint8_t j)
+{
+    return j >= Registry::channelCount ||
+           ((Registry::channel(i).sensorId == NULL || Registry::channel(j).sensorId == NULL ||
+             !sensorIdEqual(Registry::channel(i).sensorId, Registry::channel(j).sensorId)) &&
+            sensorIdUnique<Registry>(i, j + 1));
+}
+
+template <typename Registry>
+constexpr bool sensorIdsUnique(uint8_t i = 0)
+{
+    return i >= Registry::channelCount || (sensorIdUnique<Registry>(i, i + 1) && sensorIdsUnique<Registry>(i + 1));
+}
+
+/**
+ *
+ * Die Sensoren der Wetterstation, die Reihenfolge bestimmt die Reihenfolge
+ * beim Lesen (spätere Treiber überschreiben gemeinsame Felder) und Senden.
+ *
+ **/
+typedef SensorRegistry<
+    Optional<BMP280_ENABLED, Bmp280Driver>,
+    Optional<HDC1080_ENABLED, Hdc1080Driver>,
+    Optional<TSL45315_ENABLED, Tsl45315Driver>,
+    Optional<VEML6070_ENABLED, Veml6070Driver>,
+    Optional<PM_ENABLED, PmDriver>,
+    Optional<WINDRAD_ENABLED, WindradDriver>,
+    Optional<true, DerivedDriver>>
+    Sensors;
+
+// Anzahl der gesendeten Messungen pro Messzyklus, bestimmt die Größe
+// der Puffer in 'Network' und 'MeasurementLog'. Dazu kommen die
+// Kanäle des Profilers (siehe profiler.cpp).
+#define NUM_SENSORS (uploadedChannels<Sensors>() + PROFILE_UPLOAD_CHANNELS)
+
+static_assert(NUM_SENSORS > 0, "No sensor with an openSenseMap ID is enabled");
+static_assert(NUM_SENSORS <= 16, "Too many channels for the 16 bit validity mask");
+static_assert(sensorIdsValid<Sensors>(), "An openSenseMap ID in config.h does not have 24 characters");
+static_assert(sensorIdsUnique<Sensors>(), "An openSenseMap ID in config.h is used by more than one channel");
+#if PROFILE_LOOP_CHANNELS
+static_assert(sensorIdLength(PROFILE_LOOP_ID) == OSM_ID_LENGTH, "PROFILE_LOOP_ID does not have 24 characters");
+#endif
+#if PROFILE_BUSY_CHANNELS
+static_assert(sensorIdLength(PROFILE_BUSY_ID) == OSM_ID_LENGTH, "PROFILE_BUSY_ID does not have 24 characters");
+#endif
+static_assert(Sensors::readTime < Sensors::period, "Reading all sensors takes longer than the shortest period");
+static_assert(Sensors::conversionTime < Sensors::period, "A sensor conversion takes longer than the shortest period");
+static_assert(Sensors::period >= 100, "Sample intervals below 100 ms are not supported");
+
+#endif
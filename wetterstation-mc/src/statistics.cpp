@@ -0,0 +1,134 @@
+#include <Arduino.h>
+#include <math.h>
+#include "config.h"
+
+#include "measurement.h"
+
+#ifndef __STATISTICS_H_INC__
+#define __STATISTICS_H_INC__
+
+/**
+ *
+ * Laufende Statistik eines Messkanals nach Welford: Mittelwert, Minimum,
+ * Maximum und Standardabweichung ohne die einzelnen Messungen zu speichern.
+ * Die Werte werden wie in 'Measurment' als Hundertstel übergeben.
+ *
+ * Gerechnet wird mit der Abweichung von der ersten Messung, sonst reicht
+ * die Genauigkeit von float bei großen Werten (z.B. 1e7 für 100000 lx)
+ * nicht mehr für kleine Schwankungen.
+ *
+ **/
+class RunningStats
+{
+private:
+    uint32_t n = 0;
+    // Erste Messung, 'runningMean' ist der Mittelwert der Abweichungen davon
+    int32_t shift = 0;
+    float runningMean = 0;
+    // Summe der quadrierten Abweichungen vom Mittelwert
+    float m2 = 0;
+    int32_t minimum = 0;
+    int32_t maximum = 0;
+
+public:
+    void add(int32_t value)
+    {
+        if (n == 0)
+        {
+            shift = value;
+        }
+        n++;
+        float deviation = value - shift;
+        float delta = deviation - runningMean;
+        runningMean += delta / n;
+        m2 += delta * (deviation - runningMean);
+
+        if (n == 1 || value < minimum)
+        {
+            minimum = value;
+        }
+        if (n == 1 || value > maximum)
+        {
+            maximum = value;
+        }
+    }
+
+    void reset()
+    {
+        n = 0;
+        runningMean = 0;
+        m2 = 0;
+    }
+
+    uint32_t count() const { return n; }
+    int32_t min() const { return minimum; }
+    int32_t max() const { return maximum; }
+
+    // Mittelwert in Hundertstel, gerundet
+    int32_t mean() const
+    {
+        return shift + (int32_t)(runningMean < 0 ? runningMean - 0.5f : runningMean + 0.5f);
+    }
+
+    // Standardabweichung der Stichprobe in Hundertstel
+    int32_t stddev() const
+    {
+        if (n < 2)
+        {
+            return 0;
+        }
+        return (int32_t)(sqrtf(m2 / (n - 1)) + 0.5f);
+    }
+};
+
+/**
+ *
+ * Sammelt zwischen zwei Postrequests alle neuen Messungen jedes Feldes aus
+ * 'Measurment'. 'collect' wird nach jeder Sensor Abfrage aufgerufen und
+ * übernimmt nur die Felder welche seit dem letzten Aufruf neu gemessen wurden.
+ *
+ **/
+class MeasurementAggregator
+{
+private:
+    RunningStats fields[FIELD_COUNT];
+
+public:
+    void collect(Measurment &data)
+    {
+        for (uint8_t i = 0; i < FIELD_COUNT; i++)
+        {
+            MeasurementField field = (MeasurementField)i;
+            if (data.takeUpdated(field))
+            {
+                fields[i].add(data.hundredths(field));
+            }
+        }
+    }
+
+    const RunningStats &get(MeasurementField field) const
+    {
+        return fields[field];
+    }
+
+    /**
+     *
+     * Wert für den Postrequest: der Mittelwert seit dem letzten 'reset',
+     * ohne neue Messung der zuletzt gemessene Wert.
+     *
+     **/
+    int32_t value(const Measurment &data, MeasurementField field) const
+    {
+        return fields[field].count() > 0 ? fields[field].mean() : data.hundredths(field);
+    }
+
+    void reset()
+    {
+        for (uint8_t i = 0; i < FIELD_COUNT; i++)
+        {
+            fields[i].reset();
+        }
+    }
+};
+
+#endif
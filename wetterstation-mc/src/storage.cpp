@@ -0,0 +1,132 @@
+#include <Arduino.h>
+#include "config.h"
+#include "utils.cpp"
+
+#ifdef ARDUINO
+#include <SD.h>
+#else
+#include <stdio.h>
+#endif
+
+#ifndef __STORAGE_H_INC__
+#define __STORAGE_H_INC__
+
+/**
+ *
+ * Schnittstelle für einen Speicher mit wahlfreiem Zugriff, z.B. eine Datei
+ * auf der SD Karte. Das Messdaten Log ('MeasurementLog') schreibt nur über
+ * diese Schnittstelle, so kann der Speicher ausgetauscht werden.
+ *
+ **/
+class LogStorage
+{
+public:
+    virtual ~LogStorage() {}
+
+    // Liest 'length' Bytes ab 'offset', false wenn die Daten nicht existieren
+    virtual bool read(uint32_t offset, uint8_t *data, uint16_t length) = 0;
+
+    // Schreibt 'length' Bytes ab 'offset' dauerhaft in den Speicher
+    virtual bool write(uint32_t offset, const uint8_t *data, uint16_t length) = 0;
+};
+
+#ifdef ARDUINO
+/**
+ *
+ * Speicher in einer Datei auf der SD Karte (SD Bee).
+ * Die Datei bleibt geöffnet und wird nach jedem Schreiben synchronisiert.
+ *
+ **/
+class SdLogStorage : public LogStorage
+{
+private:
+    File file;
+
+public:
+    /**
+     *
+     * Initialisiert die SD Karte und öffnet bzw. erstellt die Datei 'name'.
+     *
+     **/
+    bool begin(uint8_t csPin, const char *name)
+    {
+        if (!SD.begin(csPin))
+        {
+            DEBUG(F("[Storage] SD card not found"));
+            return false;
+        }
+
+        // Nicht FILE_WRITE, da dieser Modus immer am Ende der Datei schreibt
+        file = SD.open(name, O_READ | O_WRITE | O_CREAT);
+        return file;
+    }
+
+    bool read(uint32_t offset, uint8_t *data, uint16_t length)
+    {
+        if (!file || offset + length > file.size() || !file.seek(offset))
+        {
+            return false;
+        }
+        return file.read(data, length) == length;
+    }
+
+    bool write(uint32_t offset, const uint8_t *data, uint16_t length)
+    {
+        if (!file || offset > file.size() || !file.seek(offset))
+        {
+            return false;
+        }
+        bool ok = file.write(data, length) == length;
+        file.flush();
+        return ok;
+    }
+};
+#else
+/**
+ *
+ * Speicher in einer normalen Datei, für den Betrieb auf dem Host.
+ *
+ **/
+class FileLogStorage : public LogStorage
+{
+private:
+    FILE *file = NULL;
+
+public:
+    bool begin(const char *name)
+    {
+        file = fopen(name, "r+b");
+        if (file == NULL)
+        {
+            file = fopen(name, "w+b");
+        }
+        return file != NULL;
+    }
+
+    bool read(uint32_t offset, uint8_t *data, uint16_t length)
+    {
+        return file != NULL && fseek(file, offset, SEEK_SET) == 0 &&
+               fread(data, 1, length, file) == length;
+    }
+
+    bool write(uint32_t offset, const uint8_t *data, uint16_t length)
+    {
+        if (file == NULL || fseek(file, offset, SEEK_SET) != 0 ||
+            fwrite(data, 1, length, file) != length)
+        {
+            return false;
+        }
+        return fflush(file) == 0;
+    }
+
+    ~FileLogStorage()
+    {
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+    }
+};
+#endif
+
+#endif
@@ -0,0 +1,221 @@
+#include <Arduino.h>
+#include <Client.h>
+#include "config.h"
+#include "utils.cpp"
+#include "fixedpoint.cpp"
+
+#ifndef __UPLOAD_H_INC__
+#define __UPLOAD_H_INC__
+
+// Länge eines Zeitstempels, z.B. "2021-04-15T12:30:00Z"
+#define UPLOAD_TIMESTAMP_LENGTH 20
+
+/**
+ *
+ * Gleiche Schnittstelle wie 'UploadWriter', zählt aber nur die Zeichen.
+ * Damit wird die exakte Länge eines Bodys für den 'Content-Length' Header
+ * mit dem gleichen Code berechnet der ihn später schreibt.
+ *
+ **/
+class UploadCounter
+{
+public:
+    uint32_t length = 0;
+
+    void print(char c) { length++; }
+    void print(const char *str) { length += strlen(str); }
+    void print(uint32_t value) { length += FixedPoint::digits(value); }
+    void printHex(const uint8_t *data, uint8_t length) { this->length += 2 * length; }
+
+    void printFixed(int32_t value, uint8_t decimals, uint8_t width = 0)
+    {
+        uint8_t len = FixedPoint::length(value, decimals);
+        length += len < width ? width : len;
+    }
+
+    void printTimestamp(uint32_t epoch) { length += UPLOAD_TIMESTAMP_LENGTH; }
+};
+
+/**
+ *
+ * Sammelt die Daten eines Webrequests in einem festen Sendefenster und
+ * übergibt diese erst an den Client wenn das Fenster voll ist oder 'flush'
+ * aufgerufen wird. So entstehen statt vieler kleiner TLS Pakete nur wenige
+ * Pakete in der Größe von 'UPLOAD_WINDOW_SIZE'.
+ *
+ * Zahlen werden direkt im Fenster formatiert, es gibt keine Zwischenpuffer.
+ *
+ **/
+class UploadWriter
+{
+private:
+    // Ziel der Daten, z.B. der WiFiClient der Netzwerk Klasse
+    Client *client = NULL;
+
+    // Sendefenster und aktueller Füllstand
+    char window[UPLOAD_WINDOW_SIZE];
+    uint16_t fill = 0;
+
+    // 'bytesWritten' zu Beginn des aktuellen Webrequests
+    unsigned long requestStart = 0;
+
+    /**
+     *
+     * Stellt sicher das mindestens 'size' Zeichen im Fenster frei sind.
+     *
+     **/
+    char *reserve(uint16_t size)
+    {
+        if (fill + size > UPLOAD_WINDOW_SIZE)
+        {
+            flush();
+        }
+        return window + fill;
+    }
+
+public:
+    // Statistik: übertragene Bytes und Schreibaufrufe am Client
+    unsigned long bytesWritten = 0;
+    unsigned long writeCalls = 0;
+
+    // Wird gesetzt wenn der Client nicht alle Daten annehmen konnte
+    bool writeError = false;
+
+    /**
+     *
+     * Beginnt einen neuen Webrequest an den Client 'client'.
+     *
+     **/
+    void begin(Client &client)
+    {
+        this->client = &client;
+        fill = 0;
+        writeError = false;
+        requestStart = bytesWritten;
+    }
+
+    // Bytes seit 'begin', inklusive des noch nicht übergebenen Fensters
+    uint32_t requestLength() { return bytesWritten - requestStart + fill; }
+
+    void print(char c)
+    {
+        *reserve(1) = c;
+        fill++;
+    }
+
+    void print(const char *str)
+    {
+        while (*str)
+        {
+            if (fill == UPLOAD_WINDOW_SIZE)
+            {
+                flush();
+            }
+            window[fill++] = *str++;
+        }
+    }
+
+    /**
+     *
+     * Schreibt eine positive Ganzzahl, z.B. für den 'Content-Length' Header.
+     *
+     **/
+    void print(uint32_t value)
+    {
+        uint8_t len = FixedPoint::digits(value);
+        // 'format' schreibt einen Nullterminator, daher ein Zeichen mehr
+        char *p = reserve(len + 1);
+        fill += FixedPoint::formatUnsigned(p, value);
+    }
+
+    /**
+     *
+     * Schreibt 'length' Bytes als Hex Zeichen, z.B. eine openSenseMap ID.
+     *
+     **/
+    void printHex(const uint8_t *data, uint8_t length)
+    {
+        static const char digits[] = "0123456789abcdef";
+        for (uint8_t i = 0; i < length; i++)
+        {
+            print(digits[data[i] >> 4]);
+            print(digits[data[i] & 0x0F]);
+        }
+    }
+
+    /**
+     *
+     * Schreibt eine Festkommazahl mit 'decimals' Nachkommastellen,
+     * auf 'width' Zeichen aufgefüllt.
+     *
+     **/
+    void printFixed(int32_t value, uint8_t decimals, uint8_t width = 0)
+    {
+        uint8_t len = FixedPoint::length(value, decimals);
+        char *p = reserve((len < width ? width : len) + 1);
+        fill += FixedPoint::format(p, value, decimals, width);
+    }
+
+    /**
+     *
+     * Schreibt eine Unix Zeit als RFC 3339 Zeitstempel in UTC,
+     * z.B. "2021-04-15T12:30:00Z". Die Länge ist immer 'UPLOAD_TIMESTAMP_LENGTH'.
+     *
+     **/
+    void printTimestamp(uint32_t epoch)
+    {
+        uint32_t days = epoch / 86400;
+        uint32_t seconds = epoch % 86400;
+
+        // Umrechnung der Tage seit 1970 in ein Datum (gregorianischer Kalender)
+        uint32_t z = days + 719468;
+        uint32_t era = z / 146097;
+        uint32_t doe = z - era * 146097;
+        uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        uint32_t mp = (5 * doy + 2) / 153;
+        uint32_t day = doy - (153 * mp + 2) / 5 + 1;
+        uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+        uint32_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+        uint32_t fields[] = {year, month, day, seconds / 3600, (seconds / 60) % 60, seconds % 60};
+        const char separators[] = "--T::Z";
+
+        char *p = reserve(UPLOAD_TIMESTAMP_LENGTH);
+        for (uint8_t i = 0; i < 6; i++)
+        {
+            uint8_t width = i == 0 ? 4 : 2;
+            for (uint8_t j = width; j > 0; j--)
+            {
+                p[j - 1] = '0' + fields[i] % 10;
+                fields[i] /= 10;
+            }
+            p[width] = separators[i];
+            p += width + 1;
+        }
+        fill += UPLOAD_TIMESTAMP_LENGTH;
+    }
+
+    /**
+     *
+     * Übergibt den Inhalt des Fensters an den Client.
+     *
+     **/
+    void flush()
+    {
+        if (fill == 0 || client == NULL)
+        {
+            return;
+        }
+
+        if (client->write((const uint8_t *)window, fill) != fill)
+        {
+            writeError = true;
+        }
+        bytesWritten += fill;
+        writeCalls++;
+        fill = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include <Arduino.h>
+#include "config.h"
+
+#include "measurement.h"
+
+#ifndef __UPLOADPOLICY_H_INC__
+#define __UPLOADPOLICY_H_INC__
+
+/**
+ *
+ * Ergebnis von 'UploadPolicy::check'.
+ *
+ **/
+enum UploadReason
+{
+    // Kein Postrequest
+    UPLOAD_WAIT,
+    // Ein Messwert hat sich um mehr als seinen Schwellwert geändert
+    UPLOAD_CHANGE,
+    // Das aktuelle Intervall ist abgelaufen
+    UPLOAD_INTERVAL
+};
+
+/**
+ *
+ * Entscheidet wann gesendet wird, statt fest im Intervall
+ * 'OSM_REFRESH_INTERVAL'. Ändert sich ein Messwert seit dem letzten Post um
+ * seinen Schwellwert (UPLOAD_DELTA_...), wird nach frühestens
+ * 'UPLOAD_INTERVAL_MIN' gesendet. Bleiben alle Werte darunter, verdoppelt
+ * sich das Intervall nach jedem Post bis 'UPLOAD_INTERVAL_MAX'.
+ * Bei schwachem Signal oder langsamen Antworten werden beide Intervalle
+ * verlängert, jede Übertragung kostet dann mehr Zeit und Energie.
+ *
+ **/
+class UploadPolicy
+{
+private:
+    // Beobachtete Felder, Bitmaske wie 'Measurment::valid'
+    uint16_t fields = 0;
+
+    // Werte beim letzten Post
+    Measurment posted;
+    unsigned long millisPost = 0;
+
+    unsigned long interval = OSM_REFRESH_INTERVAL;
+
+    // Verlängerung der Intervalle um den Faktor 2^penalty
+    uint8_t penalty = 0;
+
+    // Der Scheduler führt die Aufgabe ggf. etwas später aus, daher
+    // gilt ein Intervall einen halben Prüfschritt früher als abgelaufen
+    static bool elapsed(unsigned long since, unsigned long limit)
+    {
+        return since + (unsigned long)UPLOAD_CHECK_INTERVAL / 2 >= limit;
+    }
+
+public:
+    // Statistiken
+    unsigned long changePosts = 0;
+    unsigned long intervalPosts = 0;
+    unsigned long maxGap = 0;
+
+    /**
+     *
+     * Schwellwert eines Feldes in Hundertstel der Einheit, 0 = Änderungen
+     * des Feldes lösen keinen Post aus.
+     *
+     **/
+    static int32_t delta(MeasurementField field)
+    {
+        switch (field)
+        {
+        case FIELD_TEMPERATURE:
+        case FIELD_HDC1080_TEMPERATURE:
+            return UPLOAD_DELTA_TEMPERATURE;
+        case FIELD_PRESSURE:
+            return UPLOAD_DELTA_PRESSURE;
+        case FIELD_HUMIDITY:
+            return UPLOAD_DELTA_HUMIDITY;
+        case FIELD_LUX:
+            return UPLOAD_DELTA_LUX;
+        case FIELD_UV:
+            return UPLOAD_DELTA_UV;
+        case FIELD_WINDSPEED:
+            return UPLOAD_DELTA_WINDSPEED;
+        case FIELD_WINDDIRECTION:
+            return UPLOAD_DELTA_WINDDIRECTION;
+        case FIELD_PM25:
+            return UPLOAD_DELTA_PM;
+        case FIELD_PM10:
+            return UPLOAD_DELTA_PM;
+        default:
+            break;
+        }
+        return 0;
+    }
+
+    /**
+     *
+     * Erstes Feld aus 'fields' welches sich zwischen 'reference' und 'data'
+     * um mindestens seinen Schwellwert unterscheidet oder neu gültig wurde,
+     * -1 wenn keines. Die Windrichtung wird über 0° hinweg verglichen.
+     *
+     **/
+    static int8_t changed(const Measurment &data, const Measurment &reference, uint16_t fields)
+    {
+        for (uint8_t i = 0; i < FIELD_COUNT; i++)
+        {
+            MeasurementField field = (MeasurementField)i;
+            if (!(fields & (1 << i)) || !data.isValid(field) || delta(field) == 0)
+            {
+                continue;
+            }
+            if (!reference.isValid(field))
+            {
+                return i;
+            }
+            int32_t difference = data.hundredths(field) - reference.hundredths(field);
+            difference = difference < 0 ? -difference : difference;
+            if (field == FIELD_WINDDIRECTION && difference > 18000)
+            {
+                difference = 36000 - difference;
+            }
+            if (difference >= delta(field))
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     *
+     * Beginnt mit dem kürzesten Intervall, 'fields' sind die gesendeten Felder.
+     *
+     **/
+    void begin(uint16_t fields, unsigned long now)
+    {
+        this->fields = fields;
+        posted.valid = 0;
+        millisPost = now;
+        interval = OSM_REFRESH_INTERVAL;
+    }
+
+    /**
+     *
+     * Übernimmt die Qualität der Verbindung: gemittelte Signalstärke in dBm
+     * (0 = unbekannt) und Dauer des letzten Postrequests in ms.
+     *
+     **/
+    void link(int32_t rssi, unsigned long latency)
+    {
+        penalty = 0;
+        if (rssi != 0 && rssi < UPLOAD_RSSI_WEAK)
+        {
+            penalty++;
+        }
+        if (latency > UPLOAD_LATENCY_SLOW)
+        {
+            penalty++;
+        }
+    }
+
+    // Aktuelles Intervall ohne Änderungen und kürzester Abstand zweier Posts
+    unsigned long currentInterval()
+    {
+        unsigned long stretched = interval << penalty;
+        return stretched < UPLOAD_INTERVAL_MAX ? stretched : UPLOAD_INTERVAL_MAX;
+    }
+
+    unsigned long minimumGap() { return (unsigned long)UPLOAD_INTERVAL_MIN << penalty; }
+
+    /**
+     *
+     * Wird im Intervall 'UPLOAD_CHECK_INTERVAL' mit den aktuellen Messungen
+     * aufgerufen. Ist das Ergebnis nicht 'UPLOAD_WAIT' muss gesendet werden,
+     * die Werte gelten dann als übertragen.
+     *
+     **/
+    UploadReason check(const Measurment &data, unsigned long now)
+    {
+        unsigned long since = now - millisPost;
+        bool moved = changed(data, posted, fields) >= 0;
+
+        UploadReason reason = UPLOAD_WAIT;
+        if (moved && elapsed(since, minimumGap()))
+        {
+            reason = UPLOAD_CHANGE;
+            changePosts++;
+            interval = OSM_REFRESH_INTERVAL;
+        }
+        else if (elapsed(since, currentInterval()))
+        {
+            reason = UPLOAD_INTERVAL;
+            intervalPosts++;
+            if (interval < UPLOAD_INTERVAL_MAX)
+            {
+                interval *= 2;
+            }
+        }
+        else
+        {
+            return UPLOAD_WAIT;
+        }
+
+        maxGap = since > maxGap ? since : maxGap;
+        posted = data;
+        millisPost = now;
+        return reason;
+    }
+
+    /**
+     *
+     * Gibt die Anzahl der Posts nach Grund und den größten Abstand aus.
+     *
+     **/
+    void report(Print &out)
+    {
+        out.print(F("[Upload] Posts: "));
+        out.print(changePosts + intervalPosts);
+        out.print(F(" (change "));
+        out.print(changePosts);
+        out.print(F(", interval "));
+        out.print(intervalPosts);
+        out.println(F(")"));
+        out.print(F("  interval now "));
+        out.print(currentInterval() / 1000);
+        out.print(F(" s, max gap "));
+        out.print(maxGap / 1000);
+        out.print(F(" s, link penalty x"));
+        out.println(1 << penalty);
+    }
+};
+
+#endif
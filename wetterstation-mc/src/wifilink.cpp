@@ -0,0 +1,336 @@
+#include <Arduino.h>
+#include <WiFi101.h>
+#include "config.h"
+#include "utils.cpp"
+#include "power.cpp"
+#include "boot.cpp"
+
+#ifndef __WIFILINK_H_INC__
+#define __WIFILINK_H_INC__
+
+/**
+ *
+ * Zustände der WLAN Verbindung.
+ *
+ **/
+enum LinkState
+{
+    // WiFi Modul aus bzw. noch nicht gestartet
+    LINK_OFF,
+    // Keine Verbindung, nächster Versuch nach der Wartezeit
+    LINK_DOWN,
+    // Verbindungsversuch läuft
+    LINK_JOINING,
+    LINK_UP
+};
+
+/**
+ *
+ * Verwaltet die Verbindung mit dem WLAN ohne zu blockieren. 'poll' liest
+ * den Status des WiFi Moduls und wechselt die Zustände, ein Verbindungs-
+ * versuch wird nur gestartet und in den folgenden Aufrufen abgefragt.
+ * Nach einem Fehlschlag wird mit exponentiell steigender, zufällig
+ * gestreuter Wartezeit erneut verbunden, so versuchen es nach einem
+ * Ausfall des Access Points nicht alle Stationen gleichzeitig.
+ *
+ * Bestand die letzte Verbindung vor einem Reset mit diesem Netzwerk, wird
+ * zuerst das gespeicherte Profil des WiFi Moduls genutzt (siehe 'WifiCache').
+ *
+ **/
+class WifiLink
+{
+private:
+    const char *ssid = NULL;
+    const char *key = NULL;
+
+    LinkState state = LINK_OFF;
+    unsigned long millisState = 0;
+
+    // Der laufende Versuch nutzt das gespeicherte Profil
+    bool fastJoin = false;
+
+    // Die Verbindung ging verloren, die nächste gilt als Wiederverbindung
+    bool lost = false;
+
+    // Wartezeit vor dem nächsten Versuch, wird nach jedem Fehlschlag
+    // verdoppelt (bis 'WIFI_BACKOFF_MAX') und bei Erfolg zurückgesetzt.
+    unsigned long backoff = 0;
+    unsigned long millisRetry = 0;
+
+    unsigned long millisRssi = 0;
+
+    // Summe der abgeschlossenen Zeiten mit Verbindung
+    unsigned long uptimeClosed = 0;
+    unsigned long millisBegin = 0;
+    unsigned long joinTimeTotal = 0;
+
+    static bool failed(uint8_t status)
+    {
+        return status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL ||
+               status == WL_DISCONNECTED || status == WL_CONNECTION_LOST;
+    }
+
+    void setState(LinkState next)
+    {
+        unsigned long now = millis();
+        if (state == LINK_UP)
+        {
+            uptimeClosed += now - millisState;
+        }
+        state = next;
+        millisState = now;
+    }
+
+    void startJoin()
+    {
+        fastJoin = wifiCache().matches(ssid);
+        DEBUG2(F("[WiFi] Connecting to "));
+        DEBUG2(ssid);
+        DEBUG(fastJoin ? F(" (stored profile)") : F(""));
+
+        // Ohne Timeout kehrt 'begin' sofort zurück, siehe 'poll'
+        WiFi.setTimeout(0);
+        uint8_t status = fastJoin ? WiFi.begin() : WiFi.begin(ssid, key);
+        power().radioJoin(fastJoin);
+        joinAttempts++;
+        setState(LINK_JOINING);
+        if (failed(status))
+        {
+            joinFailed();
+        }
+    }
+
+    void joinFailed()
+    {
+        failedJoins++;
+        if (fastJoin)
+        {
+            // Das Profil passt nicht mehr, sofort mit Suche verbinden
+            DEBUG(F("[WiFi] Stored profile failed"));
+            wifiCache().forget();
+            startJoin();
+            return;
+        }
+
+        WiFi.disconnect();
+        backoff = backoff == 0 ? WIFI_BACKOFF_MIN : backoff * 2;
+        if (backoff > WIFI_BACKOFF_MAX)
+        {
+            backoff = WIFI_BACKOFF_MAX;
+        }
+        // Zwischen der halben und der vollen Wartezeit
+        unsigned long wait = backoff / 2 + random(backoff / 2 + 1);
+        millisRetry = millis() + wait;
+        DEBUG2(F("[WiFi] Connection failed, retry in "));
+        DEBUG2(wait);
+        DEBUG(F(" ms"));
+        setState(LINK_DOWN);
+    }
+
+    void joined()
+    {
+        lastJoinTime = millis() - millisState;
+        if (lastJoinTime > maxJoinTime)
+        {
+            maxJoinTime = lastJoinTime;
+        }
+        joinTimeTotal += lastJoinTime;
+        if (lost)
+        {
+            reconnects++;
+            lost = false;
+        }
+        joins++;
+        backoff = 0;
+        setState(LINK_UP);
+
+        uint8_t bssid[6];
+        WiFi.BSSID(bssid);
+        wifiCache().remember(ssid, bssid);
+        readRssi();
+
+        // Im Stromsparbetrieb schläft das WiFi Modul zwischen den Beacons
+        // des Access Points (DTIM)
+#ifdef LOW_POWER_MODE
+        WiFi.maxLowPowerMode();
+        power().set(POWER_RADIO, RADIO_POWER_SAVE);
+#else
+        power().set(POWER_RADIO, RADIO_LISTEN);
+#endif
+
+        DEBUG2(F("[WiFi] Connected after "));
+        DEBUG2(lastJoinTime);
+        DEBUG2(F(" ms, RSSI "));
+        DEBUG(rssi);
+    }
+
+    void readRssi()
+    {
+        rssi = WiFi.RSSI();
+        // Gleitender Mittelwert in 1/16 dBm
+        rssiAverage16 = rssiAverage16 == 0 ? rssi * 16 : rssiAverage16 + rssi - rssiAverage16 / 16;
+        millisRssi = millis();
+    }
+
+public:
+    // Statistiken
+    unsigned long joinAttempts = 0;
+    unsigned long failedJoins = 0;
+    unsigned long joins = 0;
+    unsigned long reconnects = 0;
+    unsigned long linkLosses = 0;
+    unsigned long lastJoinTime = 0;
+    unsigned long maxJoinTime = 0;
+
+    // Signalstärke in dBm, zuletzt gelesen und gemittelt
+    int32_t rssi = 0;
+    int32_t rssiAverage16 = 0;
+
+    /**
+     *
+     * Startet das WiFi Modul und den ersten Verbindungsversuch.
+     *
+     **/
+    void begin(const char *ssid, const char *key)
+    {
+        this->ssid = ssid;
+        this->key = key;
+        if (WiFi.status() == WL_NO_SHIELD)
+        {
+            DEBUG(F("[WiFi] WiFi shield no present"));
+        }
+
+        if (millisBegin == 0)
+        {
+            millisBegin = millis();
+            // Jede Station streut ihre Wartezeiten anders
+            uint8_t mac[6];
+            WiFi.macAddress(mac);
+            randomSeed(((uint32_t)mac[2] << 24 | (uint32_t)mac[3] << 16 | mac[4] << 8 | mac[5]) ^ micros());
+        }
+        startJoin();
+    }
+
+    /**
+     *
+     * Trennt die Verbindung und gibt das WiFi Modul frei, z.B. vor dem
+     * Ausschalten. Mit 'begin' wird wieder verbunden.
+     *
+     **/
+    void end()
+    {
+        WiFi.end();
+        setState(LINK_OFF);
+        power().set(POWER_RADIO, RADIO_OFF);
+    }
+
+    /**
+     *
+     * Fragt den Status des WiFi Moduls ab und führt den Zustand weiter,
+     * wird mit jeder Netzwerk Abfrage aufgerufen.
+     *
+     **/
+    void poll()
+    {
+        unsigned long now = millis();
+        switch (state)
+        {
+        case LINK_OFF:
+            break;
+
+        case LINK_DOWN:
+            if ((long)(now - millisRetry) >= 0)
+            {
+                startJoin();
+            }
+            break;
+
+        case LINK_JOINING:
+        {
+            uint8_t status = WiFi.status();
+            if (status == WL_CONNECTED)
+            {
+                joined();
+            }
+            else if (failed(status) || now - millisState >= (fastJoin ? WIFI_FAST_JOIN_TIMEOUT : WIFI_JOIN_TIMEOUT))
+            {
+                joinFailed();
+            }
+            break;
+        }
+
+        case LINK_UP:
+            if (WiFi.status() != WL_CONNECTED)
+            {
+                DEBUG(F("[WiFi] Connection lost"));
+                linkLosses++;
+                lost = true;
+                // Der erste Versuch folgt ohne Wartezeit
+                backoff = 0;
+                millisRetry = now;
+                setState(LINK_DOWN);
+                power().set(POWER_RADIO, RADIO_LISTEN);
+            }
+            else if (now - millisRssi >= WIFI_RSSI_INTERVAL)
+            {
+                readRssi();
+            }
+            break;
+        }
+    }
+
+    bool isUp() { return state == LINK_UP; }
+    bool isJoining() { return state == LINK_JOINING; }
+    LinkState getState() { return state; }
+
+    // Gesamte Zeit mit Verbindung in ms
+    unsigned long uptime()
+    {
+        return uptimeClosed + (state == LINK_UP ? millis() - millisState : 0);
+    }
+
+    int32_t averageRssi() { return rssiAverage16 / 16; }
+
+    /**
+     *
+     * Gibt die Statistiken der Verbindung aus.
+     *
+     **/
+    void report(Print &out)
+    {
+        unsigned long elapsed = millis() - millisBegin;
+        out.print(F("[WiFi] Uptime: "));
+        out.print(uptime() / 1000);
+        out.print(F(" s ("));
+        uint32_t permille = elapsed > 0 ? (uint64_t)uptime() * 1000 / elapsed : 0;
+        out.print(permille / 10);
+        out.print('.');
+        out.print(permille % 10);
+        out.println(F(" %)"));
+        out.print(F("  joins: "));
+        out.print(joins);
+        out.print(F(" (reconnects "));
+        out.print(reconnects);
+        out.print(F(", attempts "));
+        out.print(joinAttempts);
+        out.print(F(", failed "));
+        out.print(failedJoins);
+        out.print(F(", lost "));
+        out.print(linkLosses);
+        out.println(F(")"));
+        out.print(F("  time to associate: last "));
+        out.print(lastJoinTime);
+        out.print(F(" ms, avg "));
+        out.print(joins > 0 ? joinTimeTotal / joins : 0);
+        out.print(F(" ms, max "));
+        out.print(maxJoinTime);
+        out.println(F(" ms"));
+        out.print(F("  RSSI: "));
+        out.print(rssi);
+        out.print(F(" dBm (avg "));
+        out.print(averageRssi());
+        out.println(F(" dBm)"));
+    }
+};
+
+#endif
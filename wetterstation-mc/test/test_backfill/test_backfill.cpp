@@ -0,0 +1,266 @@
+/*
+    Unity Tests des Ringpuffers (ringbuffer.cpp) und des Nachholens nach
+    einem Ausfall (network.cpp): setup() und loop() laufen unter dem Shim
+    gegen den nachgebildeten Server. Die Tests bauen aufeinander auf, die
+    Uhr läuft weiter.
+*/
+
+#include <Arduino.h>
+#include <WiFi101.h>
+#include <set>
+#include <time.h>
+#include <unity.h>
+#include "native.h"
+
+#include "config.h"
+#include "ringbuffer.cpp"
+#include "network.cpp"
+
+extern Network network;
+
+#define HOUR 3600000UL
+
+// Zeilen (Messungen) eines Messzyklus im Body, gemessen vor dem ersten Ausfall
+static unsigned long linesPerCycle = 0;
+
+static unsigned long cycles(unsigned long duration)
+{
+    return duration / (unsigned long)OSM_REFRESH_INTERVAL;
+}
+
+// Höchstens so viele Requests sind zum Nachholen von 'entries' Messzyklen nötig
+static unsigned long batches(unsigned long entries)
+{
+    return (entries + PayloadEncoder::maxEntries() - 1) / PayloadEncoder::maxEntries();
+}
+
+// Gesendete Zeilen, JSON hat keine Zeilen und sendet einen Messzyklus pro Request
+static unsigned long postedLines()
+{
+#ifdef OSM_PAYLOAD_JSON
+    return nativeNetwork.posts;
+#else
+    return nativeNetwork.postedLines;
+#endif
+}
+
+// Mit ADAPTIVE_UPLOAD hängt die Anzahl der Messzyklen von den Messwerten ab,
+// geprüft wird dann nur die Obergrenze
+static void assertCycles(unsigned long expected, unsigned long actual)
+{
+#ifdef ADAPTIVE_UPLOAD
+    TEST_ASSERT_LESS_OR_EQUAL(expected + 1, actual);
+#else
+    TEST_ASSERT_UINT32_WITHIN(1, expected, actual);
+#endif
+}
+
+// Jeder der 'stored' Messzyklen wurde genau einmal gesendet
+static void assertPosted(unsigned long stored, unsigned long lines)
+{
+#ifndef ADAPTIVE_UPLOAD
+    TEST_ASSERT_UINT32_WITHIN(linesPerCycle, stored * linesPerCycle, lines);
+#endif
+}
+
+// Zeitstempel (Epoch) aller gesendeten Messzyklen
+static std::set<uint32_t> postedEpochs;
+
+static void recordEpochs(const std::string &body)
+{
+    // Zeitstempel im Format "YYYY-MM-DDTHH:MM:SSZ", in CSV und JSON gleich
+    for (size_t i = body.find('Z'); i != std::string::npos; i = body.find('Z', i + 1))
+    {
+        struct tm t = {};
+        if (i >= 19 && sscanf(body.c_str() + i - 19, "%4d-%2d-%2dT%2d:%2d:%2dZ", &t.tm_year, &t.tm_mon,
+                              &t.tm_mday, &t.tm_hour, &t.tm_min, &t.tm_sec) == 6)
+        {
+            t.tm_year -= 1900;
+            t.tm_mon -= 1;
+            postedEpochs.insert((uint32_t)timegm(&t));
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_ring_buffer_overwrites_oldest_entries()
+{
+    RingBuffer<int, 4> buffer;
+    for (int i = 1; i <= 6; i++)
+    {
+        buffer.push(i);
+    }
+    TEST_ASSERT_TRUE(buffer.isFull());
+    TEST_ASSERT_EQUAL(4, buffer.size());
+    TEST_ASSERT_EQUAL(2, buffer.dropped);
+    TEST_ASSERT_EQUAL(3, buffer.at(0));
+    TEST_ASSERT_EQUAL(6, buffer.at(3));
+
+    buffer.pop(1);
+    TEST_ASSERT_EQUAL(4, buffer.at(0));
+    buffer.push(7);
+    TEST_ASSERT_EQUAL(2, buffer.dropped);
+    TEST_ASSERT_EQUAL(7, buffer.at(3));
+
+    // Mehr entfernen als vorhanden leert den Puffer
+    buffer.pop(10);
+    TEST_ASSERT_TRUE(buffer.isEmpty());
+    buffer.push(8);
+    TEST_ASSERT_EQUAL(1, buffer.size());
+    TEST_ASSERT_EQUAL(8, buffer.at(0));
+}
+
+// Im Betrieb wird jeder Messzyklus sofort bestätigt
+void test_backlog_is_empty_while_online()
+{
+    nativeSetup();
+    nativeRun(millis() + HOUR, false);
+
+    unsigned long posts = nativeNetwork.posts;
+    unsigned long lines = postedLines();
+    nativeRun(millis() + HOUR, false);
+    TEST_ASSERT_GREATER_THAN(0, nativeNetwork.posts - posts);
+    linesPerCycle = (postedLines() - lines) / (nativeNetwork.posts - posts);
+
+    TEST_ASSERT_GREATER_THAN(0, linesPerCycle);
+    TEST_ASSERT_EQUAL(0, network.backlogSize());
+    TEST_ASSERT_EQUAL(0, network.backlogDropped());
+}
+
+// Nach 5 Stunden ohne WLAN werden alle Messzyklen in Batches nachgeholt
+void test_outage_is_backfilled_in_batches()
+{
+    unsigned long posts = nativeNetwork.posts;
+    unsigned long lines = postedLines();
+
+    nativeNetwork.online = false;
+    nativeRun(millis() + 5 * HOUR, false);
+    TEST_ASSERT_EQUAL(posts, nativeNetwork.posts);
+    assertCycles(cycles(5 * HOUR), network.backlogSize());
+
+    // Die Messzyklen des Ausfalls und der 10 Minuten danach
+    nativeNetwork.online = true;
+    nativeRun(millis() + HOUR / 6, false);
+    TEST_ASSERT_EQUAL(0, network.backlogSize());
+    TEST_ASSERT_EQUAL(0, network.backlogDropped());
+    TEST_ASSERT_EQUAL(0, network.failedPosts);
+
+    unsigned long stored = cycles(5 * HOUR + HOUR / 6);
+    assertPosted(stored, postedLines() - lines);
+    TEST_ASSERT_LESS_OR_EQUAL(batches(cycles(5 * HOUR) + 1) + cycles(HOUR / 6), nativeNetwork.posts - posts);
+}
+
+// Ist der Puffer voll, gehen nur die ältesten Messzyklen verloren, auch
+// noch während die Verbindung wieder aufgebaut wird
+void test_long_outage_keeps_newest_entries()
+{
+    unsigned long lines = postedLines();
+
+    nativeNetwork.online = false;
+    nativeRun(millis() + 8 * HOUR, false);
+    assertCycles(OFFLINE_BUFFER_SIZE, network.backlogSize());
+    assertCycles(cycles(8 * HOUR) - OFFLINE_BUFFER_SIZE, network.backlogDropped());
+
+    nativeNetwork.online = true;
+    nativeRun(millis() + HOUR / 6, false);
+    TEST_ASSERT_EQUAL(0, network.backlogSize());
+    TEST_ASSERT_LESS_OR_EQUAL(cycles(8 * HOUR + HOUR / 6) - OFFLINE_BUFFER_SIZE, network.backlogDropped());
+
+    // Jeder Messzyklus wurde entweder gesendet oder überschrieben
+    unsigned long stored = cycles(8 * HOUR + HOUR / 6) - network.backlogDropped();
+    assertPosted(stored, postedLines() - lines);
+}
+
+// Beginn eines Messzyklus und Verzögerung der Antworten des Servers
+static unsigned long millisCycle = 0;
+static const unsigned long slowResponse = 9000;
+
+// Der Server lehnt Requests ab, bis einer kurz vor dem nächsten Messzyklus
+// eintrifft: dessen Antwort kommt erst nach dem neuen Eintrag im vollen Puffer
+static void answerAcrossCycle(const std::string &body)
+{
+    unsigned long sinceCycle = (millis() - millisCycle) % (unsigned long)OSM_REFRESH_INTERVAL;
+    if (nativeNetwork.postStatus != 201 && sinceCycle + slowResponse > (unsigned long)OSM_REFRESH_INTERVAL + 1000)
+    {
+        nativeNetwork.postStatus = 201;
+    }
+    if (nativeNetwork.postStatus == 201)
+    {
+        recordEpochs(body);
+    }
+}
+
+// Antwortet der Server langsam, darf ein neuer Messzyklus bei vollem Puffer
+// keinen Eintrag des laufenden Requests verdrängen: nach dem Nachholen
+// fehlt kein Zeitstempel
+void test_slow_response_with_full_backlog_has_no_gaps()
+{
+    nativeNetwork.online = false;
+    nativeRun(millis() + 8 * HOUR, false);
+    // Der nächste Messzyklus verdrängt den ältesten Eintrag
+    unsigned long dropped = network.backlogDropped();
+    unsigned long end = millis() + 2 * (unsigned long)OSM_REFRESH_INTERVAL;
+    while (network.backlogDropped() == dropped && millis() < end)
+    {
+        nativeRun(millis() + 100, false);
+    }
+    millisCycle = millis();
+
+    postedEpochs.clear();
+    nativeNetwork.postStatus = 503;
+    nativeNetwork.responseDelay = slowResponse;
+    nativeNetwork.onPost = answerAcrossCycle;
+    nativeNetwork.online = true;
+    // Endet zwischen zwei Messzyklen, wie die folgenden Tests
+    nativeRun(millis() + 3 * HOUR + (unsigned long)OSM_REFRESH_INTERVAL / 2, false);
+    nativeNetwork.onPost = NULL;
+    nativeNetwork.responseDelay = 0;
+
+    TEST_ASSERT_EQUAL(201, nativeNetwork.postStatus);
+    TEST_ASSERT_EQUAL(0, network.backlogSize());
+#ifndef ADAPTIVE_UPLOAD
+    TEST_ASSERT_GREATER_THAN(OFFLINE_BUFFER_SIZE, postedEpochs.size());
+    uint32_t last = *postedEpochs.begin();
+    for (std::set<uint32_t>::iterator it = ++postedEpochs.begin(); it != postedEpochs.end(); ++it)
+    {
+        // Zeitstempel auf Sekunden gerundet, eine Lücke wäre ein ganzer Messzyklus
+        TEST_ASSERT_UINT32_WITHIN(1, OSM_REFRESH_INTERVAL / 1000, *it - last);
+        last = *it;
+    }
+#endif
+}
+
+// Bei Serverfehlern bleiben die Messzyklen erhalten und die Wiederholungen
+// werden seltener, es entsteht keine Schleife aus Requests
+void test_server_errors_keep_backlog_without_hot_loop()
+{
+    unsigned long posts = nativeNetwork.posts;
+
+    nativeNetwork.postStatus = 503;
+    nativeRun(millis() + 2 * HOUR, false);
+    TEST_ASSERT_GREATER_THAN(0, nativeNetwork.posts - posts);
+    TEST_ASSERT_LESS_OR_EQUAL(cycles(HOUR) / 3, nativeNetwork.posts - posts);
+    assertCycles(cycles(2 * HOUR), network.backlogSize());
+    TEST_ASSERT_EQUAL(0, network.rejectedPosts);
+
+    nativeNetwork.postStatus = 201;
+    unsigned long lines = postedLines();
+    unsigned long duration = (unsigned long)OSM_BACKOFF_MAX + HOUR / 6;
+    nativeRun(millis() + duration, false);
+    TEST_ASSERT_EQUAL(0, network.backlogSize());
+    assertPosted(cycles(2 * HOUR + duration), postedLines() - lines);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_buffer_overwrites_oldest_entries);
+    RUN_TEST(test_backlog_is_empty_while_online);
+    RUN_TEST(test_outage_is_backfilled_in_batches);
+    RUN_TEST(test_long_outage_keeps_newest_entries);
+    RUN_TEST(test_slow_response_with_full_backlog_has_no_gaps);
+    RUN_TEST(test_server_errors_keep_backlog_without_hot_loop);
+    return UNITY_END();
+}
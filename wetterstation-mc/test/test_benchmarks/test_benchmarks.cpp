@@ -0,0 +1,69 @@
+/*
+    Die Prüfungen der Benchmarks von "program" (shim/native.h) als Unity
+    Tests, mit kleiner Anzahl. Die Zeiten werden nur ausgegeben, geprüft
+    werden Ergebnisse, Heap Anforderungen und Grenzwerte.
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "native.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_event_queue()
+{
+    TEST_ASSERT_TRUE(stressEventQueue(100000, false));
+    TEST_ASSERT_TRUE(stressEventQueue(100000, true));
+}
+
+void test_http_parser()
+{
+    TEST_ASSERT_EQUAL(0, benchmarkHttpParser(1000));
+}
+
+void test_encoders()
+{
+    TEST_ASSERT_EQUAL(0, benchmarkEncoders(100));
+}
+
+void test_sensor_timing()
+{
+    Wire.attach(0x40, &hdc1080);
+    TEST_ASSERT_EQUAL(0, timingModel());
+}
+
+void test_filters()
+{
+    TEST_ASSERT_EQUAL(0, benchmarkFilters(10000));
+}
+
+void test_derived()
+{
+    TEST_ASSERT_EQUAL(0, benchmarkDerived(1000));
+}
+
+void test_display()
+{
+    TEST_ASSERT_EQUAL(0, benchmarkDisplay(100));
+}
+
+void test_measurement_log()
+{
+    TEST_ASSERT_EQUAL(0, benchmarkLog(10000));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_event_queue);
+    RUN_TEST(test_http_parser);
+    RUN_TEST(test_encoders);
+    RUN_TEST(test_sensor_timing);
+    RUN_TEST(test_filters);
+    RUN_TEST(test_derived);
+    RUN_TEST(test_display);
+    RUN_TEST(test_measurement_log);
+    return UNITY_END();
+}
@@ -0,0 +1,97 @@
+/*
+    Unity Tests der Firmware in der Umgebung 'native': setup() und loop()
+    laufen wie in "program" mit virtueller Uhr und nachgebildeter Hardware
+    (shim/native.h). Die Tests bauen aufeinander auf, die Uhr läuft weiter.
+
+        pio test -e native
+*/
+
+#include <Arduino.h>
+#include <WiFi101.h>
+#include <unity.h>
+#include "native.h"
+
+#include "config.h"
+#include "network.cpp"
+#include "scheduler.cpp"
+#include "boot.cpp"
+
+extern Network network;
+extern Scheduler scheduler;
+extern BootSequencer boot;
+
+void setUp() {}
+void tearDown() {}
+
+// Anzahl der Posts für 'seconds' bei festem Intervall
+static unsigned long expectedPosts(unsigned long seconds)
+{
+    return seconds * 1000 / (unsigned long)OSM_REFRESH_INTERVAL;
+}
+
+// Der Start wartet nicht auf das WLAN, die Verbindung folgt in loop()
+void test_setup_does_not_wait_for_wifi()
+{
+    nativeSetup();
+    TEST_ASSERT_LESS_THAN(NATIVE_JOIN_TIME, boot.duration());
+    TEST_ASSERT_EQUAL(0, network.getLink().joins);
+
+    nativeRun(millis() + NATIVE_JOIN_TIME + 1000, false);
+    TEST_ASSERT_EQUAL(1, network.getLink().joins);
+}
+
+// Ein Post je Intervall über eine TLS Sitzung, jeder wird bestätigt.
+// Mit ADAPTIVE_UPLOAD höchstens so viele, mit LOW_POWER_RADIO_OFF
+// beginnt jeder Post eine neue Sitzung.
+void test_posts_once_per_interval()
+{
+    unsigned long posts = network.posts;
+    nativeRun(3600000UL, false);
+#ifdef ADAPTIVE_UPLOAD
+    TEST_ASSERT_LESS_OR_EQUAL(expectedPosts(3600), network.posts - posts);
+#else
+    TEST_ASSERT_UINT32_WITHIN(1, expectedPosts(3600), network.posts - posts);
+#endif
+    TEST_ASSERT_EQUAL(0, network.failedPosts);
+    TEST_ASSERT_EQUAL(network.posts, nativeNetwork.posts);
+#ifndef LOW_POWER_RADIO_OFF
+    TEST_ASSERT_EQUAL(1, network.handshakes);
+#endif
+}
+
+// Im Betrieb fordert loop() keinen Heap Speicher an
+void test_loop_does_not_allocate()
+{
+    unsigned long allocations = nativeAllocations;
+    nativeRun(millis() + 3600000UL, false);
+    TEST_ASSERT_EQUAL(0, nativeAllocations - allocations);
+}
+
+// Die Uhr springt zur nächsten Deadline, jeder Aufruf von loop() hat Arbeit
+void test_loop_runs_only_when_due()
+{
+    unsigned long executions = scheduler.getExecutions();
+    unsigned long iterations = nativeRun(millis() + 3600000UL, false);
+    TEST_ASSERT_LESS_OR_EQUAL(scheduler.getExecutions() - executions, iterations);
+}
+
+// Keine Aufgabe blockiert die anderen: Verspätung und Dauer eines Durchlaufs
+// bleiben unter 10 ms, zwischen zwei Durchläufen liegt höchstens das
+// Abfrageintervall des Netzwerks
+void test_scheduler_timing_is_bounded()
+{
+    TEST_ASSERT_LESS_OR_EQUAL(10, scheduler.getMaxJitter());
+    TEST_ASSERT_LESS_OR_EQUAL(10, scheduler.getMaxRunTime());
+    TEST_ASSERT_LESS_OR_EQUAL(NETWORK_POLL_INTERVAL, scheduler.getMaxLoopLatency());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_setup_does_not_wait_for_wifi);
+    RUN_TEST(test_posts_once_per_interval);
+    RUN_TEST(test_loop_does_not_allocate);
+    RUN_TEST(test_loop_runs_only_when_due);
+    RUN_TEST(test_scheduler_timing_is_bounded);
+    return UNITY_END();
+}
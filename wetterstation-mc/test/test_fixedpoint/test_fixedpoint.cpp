@@ -0,0 +1,138 @@
+/*
+    Unity Tests der Festkommazahlen (fixedpoint.cpp, measurement.h): die
+    Formatierung muss der bisherigen Ausgabe von printf entsprechen, die
+    Übernahme von Sensorwerten darf bei NaN oder außerhalb des Wertebereichs
+    kein undefiniertes Verhalten auslösen.
+*/
+
+#include <Arduino.h>
+#include <limits.h>
+#include <math.h>
+#include <unity.h>
+
+#include "fixedpoint.cpp"
+#include "measurement.h"
+
+static const int32_t edgeValues[] = {0, 1, -1, 5, -5, 9, 10, 99, 100, -100, 999, 1000, 2153, -2153,
+                                     101325, -99999, 9999999, INT32_MAX, INT32_MIN, INT32_MIN + 1};
+
+// Formatiert 'value' mit 'FixedPoint::format' und vergleicht mit printf("%*.*f")
+static void assertLikePrintf(int32_t value, uint8_t decimals, uint8_t width)
+{
+    char expected[32];
+    char actual[32];
+    snprintf(expected, sizeof(expected), "%*.*f", width, decimals, value / pow(10, decimals));
+
+    uint8_t length = FixedPoint::format(actual, value, decimals, width);
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+    TEST_ASSERT_EQUAL(strlen(expected), length);
+    if (width == 0)
+    {
+        TEST_ASSERT_EQUAL(length, FixedPoint::length(value, decimals));
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_format_matches_printf()
+{
+    for (uint8_t decimals = 0; decimals <= 3; decimals++)
+    {
+        for (uint8_t i = 0; i < sizeof(edgeValues) / sizeof(edgeValues[0]); i++)
+        {
+            assertLikePrintf(edgeValues[i], decimals, 0);
+            assertLikePrintf(edgeValues[i], decimals, 9);
+        }
+        for (int32_t value = -20000; value <= 20000; value += 7)
+        {
+            assertLikePrintf(value, decimals, 0);
+            assertLikePrintf(value, decimals, 9);
+        }
+    }
+}
+
+void test_format_unsigned_covers_full_range()
+{
+    static const uint32_t values[] = {0, 7, 10, 1400, 2147483647UL, 2147483648UL, 4294967295UL};
+    for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        char expected[16];
+        char actual[16];
+        snprintf(expected, sizeof(expected), "%lu", (unsigned long)values[i]);
+        TEST_ASSERT_EQUAL(strlen(expected), FixedPoint::formatUnsigned(actual, values[i]));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+        TEST_ASSERT_EQUAL(strlen(expected), FixedPoint::digits(values[i]));
+    }
+}
+
+void test_assignment_rounds_half_away_from_zero()
+{
+    FixedValue<int16_t, 100> temperature;
+    temperature = 21.125f;
+    TEST_ASSERT_EQUAL(2113, temperature.raw);
+    temperature = -3.125f;
+    TEST_ASSERT_EQUAL(-313, temperature.raw);
+    TEST_ASSERT_EQUAL(-313, temperature.hundredths());
+
+    FixedValue<uint16_t, 10> pm;
+    pm = 12.34f;
+    TEST_ASSERT_EQUAL(123, pm.raw);
+    TEST_ASSERT_EQUAL(1230, pm.hundredths());
+}
+
+void test_assignment_clamps_to_range_of_type()
+{
+    FixedValue<uint16_t, 1> uv;
+    uv = -4.0f;
+    TEST_ASSERT_EQUAL(0, uv.raw);
+    uv = -0.2f;
+    TEST_ASSERT_EQUAL(0, uv.raw);
+    uv = 70000.0f;
+    TEST_ASSERT_EQUAL(65535, uv.raw);
+
+    FixedValue<uint32_t, 1> lux;
+    lux = -1.0f;
+    TEST_ASSERT_EQUAL(0, lux.raw);
+    lux = 1e12f;
+    TEST_ASSERT_EQUAL(4294967295UL, lux.raw);
+
+    FixedValue<int16_t, 100> temperature;
+    temperature = 400.0f;
+    TEST_ASSERT_EQUAL(32767, temperature.raw);
+    temperature = -400.0f;
+    TEST_ASSERT_EQUAL(-32768, temperature.raw);
+    temperature = -INFINITY;
+    TEST_ASSERT_EQUAL(-32768, temperature.raw);
+
+    FixedValue<int32_t, 100> pressure;
+    pressure = 1e10f;
+    TEST_ASSERT_EQUAL(INT32_MAX, pressure.raw);
+    pressure = -1e10f;
+    TEST_ASSERT_EQUAL(INT32_MIN, pressure.raw);
+}
+
+void test_assignment_of_nan_keeps_last_value()
+{
+    FixedValue<uint16_t, 100> humidity;
+    humidity = 55.5f;
+    humidity = NAN;
+    TEST_ASSERT_EQUAL(5550, humidity.raw);
+
+    FixedValue<int32_t, 100> pressure;
+    pressure = 1013.25f;
+    pressure = NAN;
+    TEST_ASSERT_EQUAL(101325, pressure.raw);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_format_matches_printf);
+    RUN_TEST(test_format_unsigned_covers_full_range);
+    RUN_TEST(test_assignment_rounds_half_away_from_zero);
+    RUN_TEST(test_assignment_clamps_to_range_of_type);
+    RUN_TEST(test_assignment_of_nan_keeps_last_value);
+    return UNITY_END();
+}
@@ -0,0 +1,137 @@
+/*
+    Unity Tests des HTTP Parsers (http.cpp): Antworten ohne Body und mit
+    'Transfer-Encoding: chunked' müssen ohne Schließen der Verbindung
+    vollständig sein, sonst endet ein Post erst mit HTTP_RESPONSE_TIMEOUT.
+*/
+
+#include <Arduino.h>
+#include <string>
+#include <unity.h>
+
+#include "config.h"
+#include "http.cpp"
+
+static HttpResponseParser parser;
+static HttpBodyFields fields;
+
+// Body der zuletzt gelesenen Antwort
+static std::string body;
+
+/**
+ *
+ * Liest 'text' Zeichen für Zeichen bis die Antwort vollständig ist, wie
+ * 'handleClient' ohne Schließen der Verbindung. Liefert die Anzahl der
+ * gelesenen Zeichen.
+ *
+ **/
+static size_t parse(const char *text)
+{
+    parser.begin();
+    fields.begin();
+    body.clear();
+
+    size_t i = 0;
+    for (; text[i] != '\0' && !parser.isDone(); i++)
+    {
+        if (parser.feed(text[i]))
+        {
+            body += text[i];
+            fields.feed(text[i]);
+        }
+    }
+    fields.finish();
+    return i;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_content_length_ends_body()
+{
+    const char *text = "HTTP/1.1 201 Created\r\nContent-Length: 5\r\n\r\nstoredHTTP/1.1";
+    TEST_ASSERT_EQUAL(strlen(text) - 9, parse(text));
+    TEST_ASSERT_TRUE(parser.isDone());
+    TEST_ASSERT_TRUE(parser.isKeepAlive());
+    TEST_ASSERT_EQUAL(201, parser.getStatusCode());
+    TEST_ASSERT_EQUAL_STRING("store", body.c_str());
+}
+
+void test_no_content_and_not_modified_have_no_body()
+{
+    const char *noContent = "HTTP/1.1 204 No Content\r\nServer: test\r\n\r\n";
+    TEST_ASSERT_EQUAL(strlen(noContent), parse(noContent));
+    TEST_ASSERT_TRUE(parser.isDone());
+    TEST_ASSERT_TRUE(parser.isKeepAlive());
+    TEST_ASSERT_EQUAL(204, parser.getStatusCode());
+
+    // Ein 'Content-Length' beschreibt hier die Ressource, nicht den Body
+    const char *notModified = "HTTP/1.1 304 Not Modified\r\nContent-Length: 120\r\n\r\n";
+    TEST_ASSERT_EQUAL(strlen(notModified), parse(notModified));
+    TEST_ASSERT_TRUE(parser.isDone());
+    TEST_ASSERT_TRUE(parser.isKeepAlive());
+    TEST_ASSERT_EQUAL(304, parser.getStatusCode());
+    TEST_ASSERT_EQUAL(0, body.size());
+}
+
+void test_interim_response_is_followed_by_final_response()
+{
+    const char *text = "HTTP/1.1 100 Continue\r\n\r\n"
+                       "HTTP/1.1 201 Created\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+    TEST_ASSERT_EQUAL(strlen(text), parse(text));
+    TEST_ASSERT_TRUE(parser.isDone());
+    TEST_ASSERT_FALSE(parser.isKeepAlive());
+    TEST_ASSERT_EQUAL(201, parser.getStatusCode());
+    TEST_ASSERT_EQUAL_STRING("ok", body.c_str());
+}
+
+void test_chunked_body_ends_with_last_chunk()
+{
+    const char *text = "HTTP/1.1 201 Created\r\nTransfer-Encoding: chunked\r\n\r\n"
+                       "7\r\nMeasure\r\n"
+                       "19;name=value\r\nments saved in box 5cf8c8\r\n"
+                       "0\r\n\r\n"
+                       "HTTP/1.1";
+    TEST_ASSERT_EQUAL(strlen(text) - 8, parse(text));
+    TEST_ASSERT_TRUE(parser.isDone());
+    TEST_ASSERT_TRUE(parser.isKeepAlive());
+    TEST_ASSERT_EQUAL(201, parser.getStatusCode());
+    TEST_ASSERT_EQUAL_STRING("Measurements saved in box 5cf8c8", body.c_str());
+}
+
+void test_chunked_body_with_trailer_and_fields()
+{
+    const char *text = "HTTP/1.1 200 OK\r\ntransfer-encoding: CHUNKED\r\nContent-Length: 3\r\n\r\n"
+                       "6\r\n3,270,\r\n8\r\n9.5,15.1\r\n"
+                       "0\r\nExpires: 0\r\n\r\n";
+    TEST_ASSERT_EQUAL(strlen(text), parse(text));
+    TEST_ASSERT_TRUE(parser.isDone());
+    TEST_ASSERT_TRUE(parser.isKeepAlive());
+    TEST_ASSERT_EQUAL_STRING("3,270,9.5,15.1", body.c_str());
+
+    TEST_ASSERT_EQUAL(4, fields.size());
+    TEST_ASSERT_EQUAL(300, fields.get(0));
+    TEST_ASSERT_EQUAL(27000, fields.get(1));
+    TEST_ASSERT_EQUAL(950, fields.get(2));
+    TEST_ASSERT_EQUAL(1510, fields.get(3));
+}
+
+// Eine abgebrochene Antwort ist auch beim Schließen nicht vollständig
+void test_truncated_chunked_body_is_incomplete()
+{
+    parse("HTTP/1.1 201 Created\r\nTransfer-Encoding: chunked\r\n\r\n10\r\nMeasure");
+    TEST_ASSERT_FALSE(parser.isDone());
+    parser.finish();
+    TEST_ASSERT_FALSE(parser.isDone());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_content_length_ends_body);
+    RUN_TEST(test_no_content_and_not_modified_have_no_body);
+    RUN_TEST(test_interim_response_is_followed_by_final_response);
+    RUN_TEST(test_chunked_body_ends_with_last_chunk);
+    RUN_TEST(test_chunked_body_with_trailer_and_fields);
+    RUN_TEST(test_truncated_chunked_body_is_incomplete);
+    return UNITY_END();
+}
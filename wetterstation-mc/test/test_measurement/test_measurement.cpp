@@ -0,0 +1,182 @@
+/*
+    Unity Tests des Messwert Datensatzes (measurement.h) gegen die bisherige
+    Klasse mit 'double' Feldern: Speicher pro Datensatz, gleiche Werte in
+    Hundertstel und Aufwand für das Formatieren eines Datensatzes.
+*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <unity.h>
+
+#include "fixedpoint.cpp"
+#include "measurement.h"
+
+/**
+ *
+ * Bisherige Klasse 'Measurment': zehn 'double' und ein 'int'.
+ *
+ **/
+class LegacyMeasurment
+{
+public:
+    double Temperature;
+    double Humidity;
+    double Pressure;
+    double Altitute;
+    double Lux;
+    double UV;
+    double Windspeed;
+    double Winddirection;
+    double pm25;
+    double pm10;
+    int valid;
+};
+
+// Ein Datensatz einer Station, in beiden Klassen gleich gefüllt
+static const float readings[] = {21.53f, 55.27f, 1013.25f, 42.18f, 45200.0f, 12.0f, 3.45f, 270.0f, 12.3f, 20.1f};
+
+static void fill(Measurment &data, float offset)
+{
+    data.Temperature = readings[0] + offset;
+    data.Humidity = readings[1] + offset;
+    data.Pressure = readings[2] + offset;
+    data.Altitute = readings[3] + offset;
+    data.Lux = readings[4] + offset;
+    data.UV = readings[5] + offset;
+    data.Windspeed = readings[6] + offset;
+    data.Winddirection = readings[7] + offset;
+    data.pm25 = readings[8] + offset;
+    data.pm10 = readings[9] + offset;
+}
+
+static void fill(LegacyMeasurment &data, float offset)
+{
+    double *fields[] = {&data.Temperature, &data.Humidity, &data.Pressure, &data.Altitute, &data.Lux,
+                        &data.UV, &data.Windspeed, &data.Winddirection, &data.pm25, &data.pm10};
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        *fields[i] = readings[i] + offset;
+    }
+}
+
+static const MeasurementField fields[] = {FIELD_TEMPERATURE, FIELD_HUMIDITY, FIELD_PRESSURE, FIELD_ALTITUDE, FIELD_LUX,
+                                          FIELD_UV, FIELD_WINDSPEED, FIELD_WINDDIRECTION, FIELD_PM25, FIELD_PM10};
+
+// Schreibt alle Felder wie im Body eines Posts, liefert die Anzahl der Zeichen
+static unsigned long format(const Measurment &data, char *buffer)
+{
+    unsigned long length = 0;
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        length += FixedPoint::format(buffer, data.hundredths(fields[i]), 2, 9);
+    }
+    return length;
+}
+
+static unsigned long format(const LegacyMeasurment &data, char *buffer)
+{
+    const double values[] = {data.Temperature, data.Humidity, data.Pressure, data.Altitute, data.Lux,
+                             data.UV, data.Windspeed, data.Winddirection, data.pm25, data.pm10};
+    unsigned long length = 0;
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        length += snprintf(buffer, 32, "%9.2f", (float)values[i]);
+    }
+    return length;
+}
+
+// Mittlere Dauer in ns für das Formatieren eines Datensatzes
+template <typename Record>
+static double formatTime(unsigned long count, unsigned long &length)
+{
+    Record records[16];
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        fill(records[i], i * 0.37f);
+    }
+
+    char buffer[32];
+    length = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < count; n++)
+    {
+        length += format(records[n % 16], buffer);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / count * 1e9;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fixed_values_have_the_size_of_their_type()
+{
+    TEST_ASSERT_EQUAL(sizeof(int16_t), sizeof(FixedValue<int16_t, 100>));
+    TEST_ASSERT_EQUAL(sizeof(uint16_t), sizeof(FixedValue<uint16_t, 10>));
+    TEST_ASSERT_EQUAL(sizeof(int32_t), sizeof(FixedValue<int32_t, 100>));
+    TEST_ASSERT_EQUAL(sizeof(uint32_t), sizeof(FixedValue<uint32_t, 1>));
+}
+
+void test_record_is_packed_and_smaller_than_doubles()
+{
+    Measurment data;
+    size_t fieldsSize = sizeof(data.Pressure) + sizeof(data.Altitute) + sizeof(data.Lux) +
+                        sizeof(data.SeaLevelPressure) + sizeof(data.Temperature) +
+                        sizeof(data.Hdc1080Temperature) + sizeof(data.Humidity) +
+                        sizeof(data.UV) + sizeof(data.Windspeed) + sizeof(data.Winddirection) +
+                        sizeof(data.pm25) + sizeof(data.pm10) + sizeof(data.DewPoint) +
+                        sizeof(data.PressureTendency) + sizeof(data.Aqi) + sizeof(data.valid) + sizeof(data.updated);
+    // Aufgefüllt wird nur bis zur Ausrichtung von 'int32_t'
+    TEST_ASSERT_EQUAL((fieldsSize + sizeof(int32_t) - 1) / sizeof(int32_t) * sizeof(int32_t), sizeof(Measurment));
+
+    // Mehr Felder als zuvor und trotzdem weniger als die Hälfte des Speichers
+    printf("Record: %u bytes, legacy %u bytes\n", (unsigned)sizeof(Measurment), (unsigned)sizeof(LegacyMeasurment));
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(LegacyMeasurment) / 2, sizeof(Measurment));
+}
+
+void test_hundredths_match_legacy_rounding()
+{
+    for (uint8_t n = 0; n < 100; n++)
+    {
+        Measurment data;
+        LegacyMeasurment legacy;
+        fill(data, n * 0.37f);
+        fill(legacy, n * 0.37f);
+
+        char expected[32];
+        char actual[32];
+        const double values[] = {legacy.Temperature, legacy.Humidity, legacy.Pressure, legacy.Altitute, legacy.Lux,
+                                 legacy.UV, legacy.Windspeed, legacy.Winddirection, legacy.pm25, legacy.pm10};
+        // Gespeichert wird in der Auflösung des Feldes, z.B. PM in 0.1 µg/m³
+        const int32_t scales[] = {data.Temperature.scale, data.Humidity.scale, data.Pressure.scale,
+                                  data.Altitute.scale, data.Lux.scale, data.UV.scale, data.Windspeed.scale,
+                                  data.Winddirection.scale, data.pm25.scale, data.pm10.scale};
+        for (uint8_t i = 0; i < 10; i++)
+        {
+            int32_t scale = scales[i];
+            snprintf(expected, sizeof(expected), "%9.2f", (double)FixedPoint::fromFloat(values[i], scale) / scale);
+            FixedPoint::format(actual, data.hundredths(fields[i]), 2, 9);
+            TEST_ASSERT_EQUAL_STRING(expected, actual);
+        }
+    }
+}
+
+void test_formatting_is_cheaper_than_printf()
+{
+    unsigned long fixedLength, legacyLength;
+    double fixedTime = formatTime<Measurment>(200000, fixedLength);
+    double legacyTime = formatTime<LegacyMeasurment>(200000, legacyLength);
+    printf("Format: %.0f ns per record, legacy %.0f ns\n", fixedTime, legacyTime);
+
+    TEST_ASSERT_EQUAL(legacyLength, fixedLength);
+    TEST_ASSERT_TRUE(fixedTime * 2 < legacyTime);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_values_have_the_size_of_their_type);
+    RUN_TEST(test_record_is_packed_and_smaller_than_doubles);
+    RUN_TEST(test_hundredths_match_legacy_rounding);
+    RUN_TEST(test_formatting_is_cheaper_than_printf);
+    return UNITY_END();
+}
@@ -0,0 +1,278 @@
+/*
+    Unity Tests des Feinstaubsensors (pmsensor.cpp) ohne SDS011: Eine eigene
+    serielle Schnittstelle spielt aufgezeichnete Antworten des Sensors ab und
+    zeichnet die gesendeten Kommandos auf. Geprüft werden der Ablauf des
+    Messzyklus auf der virtuellen Uhr, der Median und fehlerhafte Antworten.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "config.h"
+#include "pmsensor.cpp"
+
+// Aufgezeichnete Antworten eines SDS011 auf Abfragen (0xB4 0x04), PM2.5 und PM10 in 0.1 µg/m³
+static const uint8_t frame120[] = {0xAA, 0xC0, 0x78, 0x00, 0xC3, 0x00, 0xA1, 0x60, 0x3C, 0xAB};  // 12.0, 19.5
+static const uint8_t frame125[] = {0xAA, 0xC0, 0x7D, 0x00, 0xCB, 0x00, 0xA1, 0x60, 0x49, 0xAB};  // 12.5, 20.3
+static const uint8_t frame999[] = {0xAA, 0xC0, 0xE7, 0x03, 0xA0, 0x0F, 0xA1, 0x60, 0x9A, 0xAB};  // 99.9, 400.0
+static const uint8_t frame118[] = {0xAA, 0xC0, 0x76, 0x00, 0xBF, 0x00, 0xA1, 0x60, 0x36, 0xAB};  // 11.8, 19.1
+static const uint8_t frame123[] = {0xAA, 0xC0, 0x7B, 0x00, 0xC9, 0x00, 0xA1, 0x60, 0x45, 0xAB};  // 12.3, 20.1
+
+// Dieselben Antworten mit Übertragungsfehlern: falsche Prüfsumme, falsches Endbyte
+static const uint8_t badChecksum[] = {0xAA, 0xC0, 0x78, 0x00, 0xC3, 0x00, 0xA1, 0x60, 0x3D, 0xAB};
+static const uint8_t badTail[] = {0xAA, 0xC0, 0x7D, 0x00, 0xCB, 0x00, 0xA1, 0x60, 0x49, 0xAC};
+static const uint8_t noise[] = {0x00, 0xFF, 0x13};
+
+#define MAX_COMMANDS 64
+
+/**
+ *
+ * Ersatz für den SDS011 an 'Serial1'. Zeichnet jedes Kommando mit Zeitpunkt
+ * auf, bestätigt Kommandos mit 0xC5 und beantwortet Abfragen der Reihe nach
+ * mit den Einträgen aus 'replies'. Sind alle abgespielt, bleibt er stumm.
+ *
+ **/
+class RecordedSds011 : public SerialDevice
+{
+private:
+    uint8_t frame[SDS_COMMAND_LENGTH];
+    uint8_t index = 0;
+
+public:
+    const uint8_t *const *replies = NULL;
+    uint8_t replyLengths[16];
+    uint8_t replyCount = 0;
+    uint8_t nextReply = 0;
+
+    uint8_t commands[MAX_COMMANDS][3];
+    unsigned long commandTimes[MAX_COMMANDS];
+    uint8_t commandCount = 0;
+    uint8_t malformedCommands = 0;
+
+    void receive(HardwareSerial &port, uint8_t c)
+    {
+        if (index == 0 && c != SDS_HEAD)
+        {
+            return;
+        }
+        frame[index++] = c;
+        if (index < SDS_COMMAND_LENGTH)
+        {
+            return;
+        }
+        index = 0;
+
+        uint8_t checksum = 0;
+        for (uint8_t i = 2; i < 17; i++)
+        {
+            checksum += frame[i];
+        }
+        if (frame[1] != SDS_CMD_ID || frame[15] != 0xFF || frame[16] != 0xFF ||
+            frame[17] != checksum || frame[18] != SDS_TAIL)
+        {
+            malformedCommands++;
+            return;
+        }
+
+        if (commandCount < MAX_COMMANDS)
+        {
+            memcpy(commands[commandCount], frame + 2, 3);
+            commandTimes[commandCount] = millis();
+            commandCount++;
+        }
+
+        if (frame[2] == 0x04)
+        {
+            if (nextReply < replyCount)
+            {
+                port.inject(replies[nextReply], replyLengths[nextReply]);
+                nextReply++;
+            }
+        }
+        else if (replyCount > 0)
+        {
+            uint8_t ack[SDS_REPLY_LENGTH] = {SDS_HEAD, SDS_REPLY_CMD, frame[2], frame[3], frame[4], 0, 0xA1, 0x60, 0, SDS_TAIL};
+            for (uint8_t i = 2; i < 8; i++)
+            {
+                ack[8] += ack[i];
+            }
+            port.inject(ack, sizeof(ack));
+        }
+    }
+
+    bool isCommand(uint8_t i, uint8_t d1, uint8_t d2, uint8_t d3)
+    {
+        return i < commandCount && commands[i][0] == d1 && commands[i][1] == d2 && commands[i][2] == d3;
+    }
+};
+
+static HardwareSerial uart;
+static RecordedSds011 sds011;
+static Measurment data;
+
+static void play(const uint8_t *const *replies, const uint8_t *lengths, uint8_t count)
+{
+    sds011.replies = replies;
+    memcpy(sds011.replyLengths, lengths, count);
+    sds011.replyCount = count;
+}
+
+// Ruft 'handle' im Intervall des Schedulers auf, bis 'state' erreicht ist
+static bool pollUntil(PmSensor &sensor, PmState state, unsigned long timeout)
+{
+    unsigned long start = millis();
+    while (sensor.getState() != state)
+    {
+        if (millis() - start > timeout)
+        {
+            return false;
+        }
+        nativeAdvance(PM_POLL_INTERVAL * 1000ULL);
+        sensor.handle();
+    }
+    return true;
+}
+
+// Ein vollständiger Zyklus ab dem Aufwecken
+static void runCycle(PmSensor &sensor)
+{
+    sensor.handle();
+    TEST_ASSERT_EQUAL(PM_WARMUP, sensor.getState());
+    TEST_ASSERT_TRUE(pollUntil(sensor, PM_SLEEPING, PM_REFRESH_INTERVAL));
+}
+
+void setUp()
+{
+    sds011 = RecordedSds011();
+    uart = HardwareSerial();
+    uart.device = &sds011;
+    data = Measurment();
+}
+
+void tearDown() {}
+
+void test_begin_selects_query_mode_and_sleeps()
+{
+    PmSensor sensor(uart, &data);
+    sensor.begin();
+
+    TEST_ASSERT_EQUAL(2, sds011.commandCount);
+    TEST_ASSERT_EQUAL(0, sds011.malformedCommands);
+    TEST_ASSERT_TRUE(sds011.isCommand(0, 0x02, 0x01, 0x01));
+    TEST_ASSERT_TRUE(sds011.isCommand(1, 0x06, 0x01, 0x00));
+    TEST_ASSERT_EQUAL(PM_SLEEPING, sensor.getState());
+}
+
+void test_cycle_follows_warmup_and_sample_interval()
+{
+    static const uint8_t *const replies[] = {frame120, frame125, frame999, frame118, frame123};
+    static const uint8_t lengths[] = {10, 10, 10, 10, 10};
+    play(replies, lengths, 5);
+
+    PmSensor sensor(uart, &data);
+    sensor.begin();
+    unsigned long start = millis();
+    runCycle(sensor);
+
+    // Aufwecken, 5 Abfragen, schlafen legen
+    TEST_ASSERT_EQUAL(2 + 1 + PM_SAMPLES + 1, sds011.commandCount);
+    TEST_ASSERT_TRUE(sds011.isCommand(2, 0x06, 0x01, 0x01));
+    TEST_ASSERT_EQUAL(start, sds011.commandTimes[2]);
+
+    // Die erste Abfrage folgt erst nach dem Aufwärmen, danach im festen Intervall
+    TEST_ASSERT_TRUE(sds011.isCommand(3, 0x04, 0x00, 0x00));
+    TEST_ASSERT_UINT32_WITHIN(PM_POLL_INTERVAL, start + PM_WARMUP_TIME + PM_POLL_INTERVAL, sds011.commandTimes[3]);
+    for (uint8_t i = 4; i < 3 + PM_SAMPLES; i++)
+    {
+        TEST_ASSERT_TRUE(sds011.isCommand(i, 0x04, 0x00, 0x00));
+        TEST_ASSERT_EQUAL(PM_SAMPLE_INTERVAL, sds011.commandTimes[i] - sds011.commandTimes[i - 1]);
+    }
+
+    // Schlafen, sobald die letzte Antwort verarbeitet ist
+    uint8_t last = 3 + PM_SAMPLES;
+    TEST_ASSERT_TRUE(sds011.isCommand(last, 0x06, 0x01, 0x00));
+    TEST_ASSERT_EQUAL(PM_POLL_INTERVAL, sds011.commandTimes[last] - sds011.commandTimes[last - 1]);
+    TEST_ASSERT_EQUAL(0, sds011.malformedCommands);
+
+    // Der nächste Zyklus beginnt 'PM_REFRESH_INTERVAL' nach dem Aufwecken
+    TEST_ASSERT_TRUE(pollUntil(sensor, PM_WARMUP, PM_REFRESH_INTERVAL));
+    TEST_ASSERT_EQUAL(start + PM_REFRESH_INTERVAL, millis());
+}
+
+// Lüfter und Laser altern nur im Betrieb, höchstens 15 % der Zeit wach
+void test_sensor_sleeps_most_of_the_cycle()
+{
+    static const uint8_t *const replies[] = {frame120, frame125, frame999, frame118, frame123};
+    static const uint8_t lengths[] = {10, 10, 10, 10, 10};
+    play(replies, lengths, 5);
+
+    PmSensor sensor(uart, &data);
+    sensor.begin();
+    runCycle(sensor);
+
+    unsigned long awake = sds011.commandTimes[sds011.commandCount - 1] - sds011.commandTimes[2];
+    TEST_ASSERT_LESS_OR_EQUAL(PM_REFRESH_INTERVAL * 15 / 100, awake);
+}
+
+void test_median_ignores_outlier()
+{
+    static const uint8_t *const replies[] = {frame120, frame125, frame999, frame118, frame123};
+    static const uint8_t lengths[] = {10, 10, 10, 10, 10};
+    play(replies, lengths, 5);
+
+    PmSensor sensor(uart, &data);
+    sensor.begin();
+    runCycle(sensor);
+
+    TEST_ASSERT_EQUAL(1, sensor.completedCycles);
+    TEST_ASSERT_EQUAL(0, sensor.invalidReplies);
+    TEST_ASSERT_TRUE(data.isValid(FIELD_PM25));
+    TEST_ASSERT_TRUE(data.isValid(FIELD_PM10));
+    TEST_ASSERT_EQUAL(1230, data.pm25.hundredths());
+    TEST_ASSERT_EQUAL(2010, data.pm10.hundredths());
+}
+
+void test_corrupt_replies_are_counted_and_ignored()
+{
+    static const uint8_t *const replies[] = {badChecksum, frame120, badTail, noise, frame125, frame999, frame118, frame123};
+    static const uint8_t lengths[] = {10, 10, 10, 3, 10, 10, 10, 10};
+    play(replies, lengths, 8);
+
+    PmSensor sensor(uart, &data);
+    sensor.begin();
+    runCycle(sensor);
+
+    // Ohne gültige Antwort wird erneut abgefragt, Störbytes vor 0xAA fallen weg
+    TEST_ASSERT_EQUAL(2, sensor.invalidReplies);
+    TEST_ASSERT_EQUAL(1, sensor.completedCycles);
+    TEST_ASSERT_EQUAL(8, sds011.nextReply);
+    TEST_ASSERT_EQUAL(1230, data.pm25.hundredths());
+    TEST_ASSERT_EQUAL(2010, data.pm10.hundredths());
+}
+
+void test_silent_sensor_fails_cycle()
+{
+    PmSensor sensor(uart, &data);
+    sensor.begin();
+    runCycle(sensor);
+
+    // Jede Abfrage wird einmal wiederholt, danach schläft der Sensor wieder
+    TEST_ASSERT_EQUAL(1, sensor.failedCycles);
+    TEST_ASSERT_EQUAL(0, sensor.completedCycles);
+    TEST_ASSERT_FALSE(data.isValid(FIELD_PM25));
+    TEST_ASSERT_FALSE(data.isValid(FIELD_PM10));
+    TEST_ASSERT_EQUAL(2 + 1 + 2 * PM_SAMPLES + 1, sds011.commandCount);
+    TEST_ASSERT_TRUE(sds011.isCommand(sds011.commandCount - 1, 0x06, 0x01, 0x00));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_selects_query_mode_and_sleeps);
+    RUN_TEST(test_cycle_follows_warmup_and_sample_interval);
+    RUN_TEST(test_sensor_sleeps_most_of_the_cycle);
+    RUN_TEST(test_median_ignores_outlier);
+    RUN_TEST(test_corrupt_replies_are_counted_and_ignored);
+    RUN_TEST(test_silent_sensor_fails_cycle);
+    return UNITY_END();
+}
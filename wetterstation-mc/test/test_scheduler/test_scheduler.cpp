@@ -0,0 +1,198 @@
+/*
+    Unity Tests des Schedulers (scheduler.cpp) mit eigener Uhr: Reihenfolge
+    nach Deadline, Intervalle ohne Drift, übersprungene Durchläufe, volle
+    Tabelle, Überlauf von millis() sowie Verspätung und Latenz.
+*/
+
+#include <Arduino.h>
+#include <limits.h>
+#include <unity.h>
+
+#include "config.h"
+#include "scheduler.cpp"
+
+// Uhr der Tests, Aufgaben können sie vorstellen um Arbeit zu simulieren
+static unsigned long now = 0;
+static unsigned long testClock() { return now; }
+
+// Aufzeichnung der Aufrufe: Nummer der Aufgabe und Zeitpunkt
+static uint8_t order[64];
+static unsigned long times[64];
+static uint8_t calls = 0;
+
+static void record(uint8_t task)
+{
+    if (calls < sizeof(order))
+    {
+        order[calls] = task;
+        times[calls] = now;
+    }
+    calls++;
+}
+
+static void taskA() { record(0); }
+static void taskB() { record(1); }
+static void taskC() { record(2); }
+
+// Blockiert 50 ms, wie eine lange I2C Übertragung
+static void slowTask()
+{
+    record(3);
+    now += 50;
+}
+
+// Läuft bis 'end', die Uhr springt jeweils zur nächsten Deadline
+static void runUntil(Scheduler &scheduler, unsigned long end)
+{
+    while ((long)(end - now) >= 0)
+    {
+        scheduler.run();
+        unsigned long wait = scheduler.timeUntilNext();
+        if (wait == 0xFFFFFFFF || (long)(end - now) < (long)wait)
+        {
+            now = end + 1;
+            break;
+        }
+        now += wait > 0 ? wait : 1;
+    }
+}
+
+void setUp()
+{
+    now = 0;
+    calls = 0;
+}
+
+void tearDown() {}
+
+void test_periodic_task_keeps_its_interval_without_drift()
+{
+    Scheduler scheduler(testClock);
+    scheduler.addPeriodic(taskA, 1000, 1000);
+
+    // Jeder Aufruf kommt 3 ms zu spät, die Deadlines bleiben auf dem Raster
+    for (unsigned long k = 1; k <= 10; k++)
+    {
+        now = k * 1000 + 3;
+        scheduler.run();
+    }
+    TEST_ASSERT_EQUAL(10, calls);
+    TEST_ASSERT_EQUAL(997, scheduler.timeUntilNext());
+    TEST_ASSERT_EQUAL(3, scheduler.getMaxJitter());
+}
+
+void test_due_tasks_run_in_deadline_order()
+{
+    Scheduler scheduler(testClock);
+    scheduler.addOnce(taskC, 300);
+    scheduler.addOnce(taskA, 100);
+    scheduler.addOnce(taskB, 200);
+
+    now = 500;
+    scheduler.run();
+    TEST_ASSERT_EQUAL(3, calls);
+    TEST_ASSERT_EQUAL(0, order[0]);
+    TEST_ASSERT_EQUAL(1, order[1]);
+    TEST_ASSERT_EQUAL(2, order[2]);
+}
+
+void test_one_shot_task_runs_once_and_frees_its_slot()
+{
+    Scheduler scheduler(testClock);
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+    {
+        TEST_ASSERT_EQUAL(i, scheduler.addOnce(taskA, 10));
+    }
+    TEST_ASSERT_EQUAL(-1, scheduler.addOnce(taskB, 10));
+    TEST_ASSERT_EQUAL(SCHEDULER_MAX_TASKS, scheduler.getTaskCount());
+
+    runUntil(scheduler, 1000);
+    TEST_ASSERT_EQUAL(0, scheduler.getTaskCount());
+    TEST_ASSERT_EQUAL(SCHEDULER_MAX_TASKS, calls);
+    TEST_ASSERT_EQUAL(0xFFFFFFFF, scheduler.timeUntilNext());
+    TEST_ASSERT_EQUAL(0, scheduler.addOnce(taskB, 10));
+}
+
+void test_missed_periods_are_skipped()
+{
+    Scheduler scheduler(testClock);
+    scheduler.addPeriodic(taskA, 100, 100);
+
+    // 350 ms ohne Aufruf: nur eine Ausführung, danach wieder im Intervall
+    now = 450;
+    scheduler.run();
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(100, scheduler.timeUntilNext());
+    TEST_ASSERT_EQUAL(350, scheduler.getMaxJitter());
+}
+
+void test_short_interval_does_not_starve_other_tasks()
+{
+    Scheduler scheduler(testClock);
+    scheduler.addPeriodic(taskA, 1, 0);
+    scheduler.addPeriodic(slowTask, 1000, 0);
+    scheduler.addPeriodic(taskB, 1000, 0);
+
+    // Die langsame Aufgabe verschiebt die Uhr, trotzdem läuft jede einmal
+    scheduler.run();
+    TEST_ASSERT_EQUAL(3, calls);
+    TEST_ASSERT_EQUAL(50, scheduler.getMaxJitter());
+    TEST_ASSERT_EQUAL(50, scheduler.getMaxRunTime());
+}
+
+void test_reschedule_and_cancel()
+{
+    Scheduler scheduler(testClock);
+    int8_t a = scheduler.addPeriodic(taskA, 1000, 1000);
+    int8_t b = scheduler.addPeriodic(taskB, 1000, 1000);
+
+    scheduler.reschedule(a, 10);
+    scheduler.cancel(b);
+    runUntil(scheduler, 1500);
+    TEST_ASSERT_EQUAL(2, calls);
+    TEST_ASSERT_EQUAL(10, times[0]);
+    TEST_ASSERT_EQUAL(1010, times[1]);
+}
+
+// Auf dem Host hat unsigned long 64 Bit, der Überlauf liegt daher bei ULONG_MAX
+void test_deadlines_survive_millis_overflow()
+{
+    now = ULONG_MAX - 1500;
+    Scheduler scheduler(testClock);
+    scheduler.addPeriodic(taskA, 1000, 1000);
+
+    runUntil(scheduler, 2500);
+    TEST_ASSERT_EQUAL(4, calls);
+    TEST_ASSERT_TRUE(times[0] == ULONG_MAX - 500);
+    TEST_ASSERT_EQUAL(499, times[1]);
+    TEST_ASSERT_EQUAL(0, scheduler.getMaxJitter());
+}
+
+// Die Latenz zählt vom Ende eines Durchlaufs bis zum nächsten Aufruf
+void test_loop_latency_is_the_longest_gap_between_runs()
+{
+    Scheduler scheduler(testClock);
+    scheduler.addPeriodic(slowTask, 200, 0);
+
+    runUntil(scheduler, 1000);
+    TEST_ASSERT_EQUAL(150, scheduler.getMaxLoopLatency());
+    TEST_ASSERT_EQUAL(50, scheduler.getMaxRunTime());
+
+    scheduler.resetStatistics();
+    TEST_ASSERT_EQUAL(0, scheduler.getMaxLoopLatency());
+    TEST_ASSERT_EQUAL(0, scheduler.getExecutions());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_periodic_task_keeps_its_interval_without_drift);
+    RUN_TEST(test_due_tasks_run_in_deadline_order);
+    RUN_TEST(test_one_shot_task_runs_once_and_frees_its_slot);
+    RUN_TEST(test_missed_periods_are_skipped);
+    RUN_TEST(test_short_interval_does_not_starve_other_tasks);
+    RUN_TEST(test_reschedule_and_cancel);
+    RUN_TEST(test_deadlines_survive_millis_overflow);
+    RUN_TEST(test_loop_latency_is_the_longest_gap_between_runs);
+    return UNITY_END();
+}
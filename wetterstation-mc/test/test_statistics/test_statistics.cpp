@@ -0,0 +1,219 @@
+/*
+    Unity Tests der laufenden Statistik (statistics.cpp) mit synthetischen
+    Signalen: Mittelwert und Standardabweichung nach Welford gegen die exakte
+    Berechnung in zwei Durchläufen, Minimum und Maximum sowie die Dauer pro
+    Messung.
+*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <math.h>
+#include <unity.h>
+
+#include "config.h"
+#include "statistics.cpp"
+
+#define MAX_SAMPLES 4096
+
+static int32_t samples[MAX_SAMPLES];
+
+// Pseudozufall mit festem Startwert, gleichverteilt in [-1, 1]
+static uint32_t seed = 1;
+static double noise()
+{
+    seed = seed * 1103515245 + 12345;
+    return ((seed >> 8) & 0xFFFF) / 32767.5 - 1.0;
+}
+
+/**
+ *
+ * Füllt 'samples' mit 'offset' + Sinus der Amplitude 'amplitude' über
+ * 'periods' Perioden + Rauschen der Amplitude 'noiseLevel', alles in
+ * Hundertstel wie in 'Measurment'.
+ *
+ **/
+static void generate(uint16_t count, double offset, double amplitude, double periods, double noiseLevel)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        samples[i] = (int32_t)lround(offset + amplitude * sin(2 * M_PI * periods * i / count) + noiseLevel * noise());
+    }
+}
+
+// Vergleicht 'RunningStats' mit der Berechnung in zwei Durchläufen in double
+static void assertLikeTwoPass(uint16_t count)
+{
+    RunningStats stats;
+    int32_t minimum = samples[0];
+    int32_t maximum = samples[0];
+    double sum = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        stats.add(samples[i]);
+        sum += samples[i];
+        minimum = samples[i] < minimum ? samples[i] : minimum;
+        maximum = samples[i] > maximum ? samples[i] : maximum;
+    }
+    double mean = sum / count;
+    double squares = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        squares += (samples[i] - mean) * (samples[i] - mean);
+    }
+    double stddev = count > 1 ? sqrt(squares / (count - 1)) : 0;
+
+    // Auf eine Hundertstel genau, die Standardabweichung auf 0.1 %
+    TEST_ASSERT_EQUAL(count, stats.count());
+    TEST_ASSERT_EQUAL(minimum, stats.min());
+    TEST_ASSERT_EQUAL(maximum, stats.max());
+    TEST_ASSERT_INT32_WITHIN(1, lround(mean), stats.mean());
+    TEST_ASSERT_INT32_WITHIN(1 + (int32_t)(stddev / 1000), lround(stddev), stats.stddev());
+}
+
+void setUp()
+{
+    seed = 1;
+}
+
+void tearDown() {}
+
+void test_constant_signal_has_no_deviation()
+{
+    generate(360, 2153, 0, 0, 0);
+    assertLikeTwoPass(360);
+
+    RunningStats stats;
+    for (uint16_t i = 0; i < 360; i++)
+    {
+        stats.add(samples[i]);
+    }
+    TEST_ASSERT_EQUAL(0, stats.stddev());
+}
+
+// Temperatur: 21.53 °C, Tagesgang 5 °C, Rauschen 0.1 °C
+void test_temperature_like_signal()
+{
+    generate(360, 2153, 500, 1, 10);
+    assertLikeTwoPass(360);
+    generate(MAX_SAMPLES, -1520, 500, 3, 10);
+    assertLikeTwoPass(MAX_SAMPLES);
+}
+
+// Luftdruck in Hundertstel hPa: großer Abstand zur Null, kleine Schwankung
+void test_large_offset_small_variation()
+{
+    generate(MAX_SAMPLES, 101325, 30, 2, 5);
+    assertLikeTwoPass(MAX_SAMPLES);
+}
+
+// Beleuchtungsstärke bis 100000 lx, in Hundertstel also bis 1e7
+void test_lux_like_signal()
+{
+    generate(MAX_SAMPLES, 5000000, 4000000, 1, 20000);
+    assertLikeTwoPass(MAX_SAMPLES);
+    generate(MAX_SAMPLES, 9000000, 100, 4, 50);
+    assertLikeTwoPass(MAX_SAMPLES);
+}
+
+void test_reset_starts_new_interval()
+{
+    RunningStats stats;
+    stats.add(-500);
+    stats.add(3000);
+    stats.reset();
+    stats.add(100);
+    stats.add(300);
+    TEST_ASSERT_EQUAL(2, stats.count());
+    TEST_ASSERT_EQUAL(100, stats.min());
+    TEST_ASSERT_EQUAL(300, stats.max());
+    TEST_ASSERT_EQUAL(200, stats.mean());
+    TEST_ASSERT_EQUAL(141, stats.stddev());
+}
+
+// Nur neu gemessene Felder werden übernommen, ohne Messung gilt der letzte Wert
+void test_aggregator_takes_only_updated_fields()
+{
+    MeasurementAggregator aggregator;
+    Measurment data;
+
+    data.Temperature = 20.0f;
+    data.setValid(FIELD_TEMPERATURE);
+    aggregator.collect(data);
+    data.Temperature = 22.0f;
+    data.setValid(FIELD_TEMPERATURE);
+    aggregator.collect(data);
+    aggregator.collect(data);
+
+    TEST_ASSERT_EQUAL(2, aggregator.get(FIELD_TEMPERATURE).count());
+    TEST_ASSERT_EQUAL(2100, aggregator.value(data, FIELD_TEMPERATURE));
+
+    data.Humidity = 55.0f;
+    TEST_ASSERT_EQUAL(0, aggregator.get(FIELD_HUMIDITY).count());
+    TEST_ASSERT_EQUAL(5500, aggregator.value(data, FIELD_HUMIDITY));
+
+    aggregator.reset();
+    TEST_ASSERT_EQUAL(2200, aggregator.value(data, FIELD_TEMPERATURE));
+}
+
+// BMP280 und HDC1080 messen die Temperatur getrennt
+void test_aggregator_keeps_temperature_sensors_apart()
+{
+    MeasurementAggregator aggregator;
+    Measurment data;
+
+    data.Temperature = 21.0f;
+    data.setValid(FIELD_TEMPERATURE);
+    data.Hdc1080Temperature = 23.0f;
+    data.setValid(FIELD_HDC1080_TEMPERATURE);
+    aggregator.collect(data);
+
+    // Ein Lesefehler des HDC1080 betrifft nur dessen Temperatur
+    data.setInvalid(FIELD_HDC1080_TEMPERATURE);
+    data.Temperature = 21.5f;
+    data.setValid(FIELD_TEMPERATURE);
+    aggregator.collect(data);
+
+    TEST_ASSERT_TRUE(data.isValid(FIELD_TEMPERATURE));
+    TEST_ASSERT_EQUAL(2, aggregator.get(FIELD_TEMPERATURE).count());
+    TEST_ASSERT_EQUAL(1, aggregator.get(FIELD_HDC1080_TEMPERATURE).count());
+    TEST_ASSERT_EQUAL(2125, aggregator.value(data, FIELD_TEMPERATURE));
+    TEST_ASSERT_EQUAL(2300, aggregator.value(data, FIELD_HDC1080_TEMPERATURE));
+}
+
+void test_cost_per_sample()
+{
+    generate(MAX_SAMPLES, 2153, 500, 1, 10);
+    RunningStats stats;
+    const unsigned long rounds = 100;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < rounds; n++)
+    {
+        stats.reset();
+        for (uint16_t i = 0; i < MAX_SAMPLES; i++)
+        {
+            stats.add(samples[i]);
+        }
+    }
+    double ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / (rounds * MAX_SAMPLES) * 1e9;
+    printf("RunningStats::add: %.1f ns per sample, %u bytes per channel\n", ns, (unsigned)sizeof(RunningStats));
+
+    // Kein Speicher für Messungen, nur die Zustandsvariablen
+    TEST_ASSERT_LESS_OR_EQUAL(24, sizeof(RunningStats));
+    TEST_ASSERT_LESS_THAN(1000, ns);
+    TEST_ASSERT_EQUAL(2153, stats.mean());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_constant_signal_has_no_deviation);
+    RUN_TEST(test_temperature_like_signal);
+    RUN_TEST(test_large_offset_small_variation);
+    RUN_TEST(test_lux_like_signal);
+    RUN_TEST(test_reset_starts_new_interval);
+    RUN_TEST(test_aggregator_takes_only_updated_fields);
+    RUN_TEST(test_aggregator_keeps_temperature_sensors_apart);
+    RUN_TEST(test_cost_per_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,212 @@
+/*
+    Unity Tests des Upload Encoders (upload.cpp, encoding.cpp): die vorab
+    berechnete Länge muss den geschriebenen Bytes entsprechen, das Fenster
+    wird nur in ganzen Blöcken übergeben und der Body entspricht dem
+    bisherigen Format "%s,%9.2f\n".
+*/
+
+#include <Arduino.h>
+#include <Client.h>
+#include <time.h>
+#include <string>
+#include <unity.h>
+
+#include "config.h"
+#include "encoding.cpp"
+
+/**
+ *
+ * Client welcher den Body und die Größe jedes Schreibaufrufs aufzeichnet.
+ *
+ **/
+class RecordingClient : public Client
+{
+public:
+    std::string body;
+    size_t writes[256];
+    uint16_t writeCount = 0;
+
+    int connect(IPAddress ip, uint16_t port) { return 1; }
+    int connect(const char *host, uint16_t port) { return 1; }
+    uint8_t connected() { return 1; }
+    void stop() {}
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size)
+    {
+        body.append((const char *)buffer, size);
+        if (writeCount < 256)
+        {
+            writes[writeCount] = size;
+        }
+        writeCount++;
+        return size;
+    }
+    int available() { return 0; }
+    int read() { return -1; }
+    int read(uint8_t *buffer, size_t size) { return 0; }
+};
+
+/**
+ *
+ * Messzyklen mit Werten in Hundertstel wie bei einer Station, jede dritte
+ * Messung des zweiten Kanals ist ungültig.
+ *
+ **/
+class TestBatch
+{
+private:
+    char ids[8][25];
+    uint16_t entries;
+    uint32_t start;
+
+public:
+    TestBatch(uint16_t entries, uint32_t start) : entries(entries), start(start)
+    {
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            snprintf(ids[j], sizeof(ids[j]), "5cf8c8fa07460b001b4d%04x", j);
+        }
+    }
+
+    uint16_t size() { return entries; }
+    uint8_t channels(uint16_t i) { return 8; }
+    bool valid(uint16_t i, uint8_t j) { return j != 1 || i % 3 != 0; }
+    int32_t value(uint16_t i, uint8_t j)
+    {
+        static const int32_t values[] = {2153, 101325, 4520000, 12, 6890, -350, 5, -99999999};
+        return values[j] + i * 37;
+    }
+    uint32_t epoch(uint16_t i) { return start == 0 ? 0 : start + i * 60; }
+    const char *sensorId(uint8_t j) { return ids[j]; }
+};
+
+static RecordingClient client;
+static UploadWriter writer;
+
+template <typename Encoder>
+static void writeBatch(TestBatch &batch, UploadCounter &counter)
+{
+    Encoder::write(counter, batch);
+    writer.begin(client);
+    Encoder::write(writer, batch);
+    writer.flush();
+}
+
+void setUp()
+{
+    client = RecordingClient();
+}
+
+void tearDown() {}
+
+void test_counted_length_matches_written_body()
+{
+    TestBatch timed(OSM_BACKFILL_BATCH, 1618489800);
+    TestBatch untimed(1, 0);
+
+    UploadCounter counter;
+    writeBatch<CsvPaddedEncoder>(timed, counter);
+    TEST_ASSERT_EQUAL(counter.length, client.body.size());
+    TEST_ASSERT_FALSE(writer.writeError);
+
+    client = RecordingClient();
+    UploadCounter csv;
+    writeBatch<CsvEncoder>(timed, csv);
+    TEST_ASSERT_EQUAL(csv.length, client.body.size());
+
+    client = RecordingClient();
+    UploadCounter json;
+    writeBatch<JsonEncoder>(untimed, json);
+    TEST_ASSERT_EQUAL(json.length, client.body.size());
+}
+
+void test_window_is_written_in_large_blocks()
+{
+    TestBatch batch(OSM_BACKFILL_BATCH, 1618489800);
+    UploadCounter counter;
+    unsigned long writeCalls = writer.writeCalls;
+    writeBatch<CsvPaddedEncoder>(batch, counter);
+
+    // Jeder Block außer dem letzten ist bis auf einen Zeitstempel gefüllt
+    TEST_ASSERT_GREATER_THAN(1, client.writeCount);
+    TEST_ASSERT_EQUAL(client.writeCount, writer.writeCalls - writeCalls);
+    for (uint16_t i = 0; i < client.writeCount; i++)
+    {
+        TEST_ASSERT_LESS_OR_EQUAL(UPLOAD_WINDOW_SIZE, client.writes[i]);
+        if (i + 1 < client.writeCount)
+        {
+            TEST_ASSERT_GREATER_OR_EQUAL(UPLOAD_WINDOW_SIZE - UPLOAD_TIMESTAMP_LENGTH, client.writes[i]);
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(counter.length / (UPLOAD_WINDOW_SIZE - UPLOAD_TIMESTAMP_LENGTH) + 1, client.writeCount);
+}
+
+void test_padded_csv_matches_printf()
+{
+    TestBatch batch(3, 0);
+    UploadCounter counter;
+    writeBatch<CsvPaddedEncoder>(batch, counter);
+
+    std::string expected;
+    for (uint16_t i = 0; i < batch.size(); i++)
+    {
+        for (uint8_t j = 0; j < batch.channels(i); j++)
+        {
+            if (batch.valid(i, j))
+            {
+                char line[64];
+                snprintf(line, sizeof(line), "%s,%9.2f\n", batch.sensorId(j), batch.value(i, j) / 100.0);
+                expected += line;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), client.body.c_str());
+}
+
+void test_timestamp_matches_gmtime()
+{
+    // 1970, Schalttage 2000 und 2024, Jahreswechsel und das Ende von uint32_t
+    static const uint32_t epochs[] = {0, 951782400, 951868799, 1618489800, 1709164800, 1735689599, 4294967295UL};
+    for (uint8_t i = 0; i < sizeof(epochs) / sizeof(epochs[0]); i++)
+    {
+        time_t t = epochs[i];
+        char expected[32];
+        strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+
+        client = RecordingClient();
+        writer.begin(client);
+        writer.printTimestamp(epochs[i]);
+        writer.flush();
+        TEST_ASSERT_EQUAL_STRING(expected, client.body.c_str());
+    }
+}
+
+void test_large_unsigned_values_print_positive()
+{
+    static const uint32_t values[] = {0, 1400, 2147483648UL, 4294967295UL};
+    for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        char expected[16];
+        snprintf(expected, sizeof(expected), "%lu", (unsigned long)values[i]);
+
+        client = RecordingClient();
+        UploadCounter counter;
+        counter.print(values[i]);
+        writer.begin(client);
+        writer.print(values[i]);
+        writer.flush();
+        TEST_ASSERT_EQUAL_STRING(expected, client.body.c_str());
+        TEST_ASSERT_EQUAL(counter.length, client.body.size());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_counted_length_matches_written_body);
+    RUN_TEST(test_window_is_written_in_large_blocks);
+    RUN_TEST(test_padded_csv_matches_printf);
+    RUN_TEST(test_timestamp_matches_gmtime);
+    RUN_TEST(test_large_unsigned_values_print_positive);
+    return UNITY_END();
+}